@@ -29,6 +29,11 @@
 
 #include <cctype>
 
+#if JUCE_INTEL && (defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define JUCE_USE_SSE2_TEXT_SCANNING 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
@@ -158,5 +163,92 @@ double CharacterFunctions::mulexp10 (const double value, int exponent) noexcept
     return negative ? (value / result) : (value * result);
 }
 
+//==============================================================================
+namespace CharacterFunctionsHelpers
+{
+    inline bool isInAsciiRun (const uint8 c, const bool whitespace) noexcept
+    {
+        if (whitespace)
+            return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+
+        return c > ' ' ? c < 0x80
+                       : (c != 0 && c != ' ' && (c < '\t' || c > '\r'));
+    }
+
+   #if JUCE_USE_SSE2_TEXT_SCANNING
+    /** Returns a bit-mask of the bytes in a block that don't belong to the run. */
+    inline int findBytesNotInAsciiRun (const __m128i block, const bool whitespace) noexcept
+    {
+        const __m128i spaces = _mm_cmpeq_epi8 (block, _mm_set1_epi8 (' '));
+
+        if (whitespace)
+        {
+            const __m128i tabs = _mm_or_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ('\t')),
+                                               _mm_or_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ('\v')),
+                                                             _mm_cmpeq_epi8 (block, _mm_set1_epi8 ('\f'))));
+
+            return (~_mm_movemask_epi8 (_mm_or_si128 (spaces, tabs))) & 0xffff;
+        }
+
+        // Non-ASCII bytes have their top bit set, so they're caught by the movemask, and
+        // also compare as negative numbers, so they're never inside the control-code range.
+        const __m128i controlCodes = _mm_and_si128 (_mm_cmpgt_epi8 (block, _mm_set1_epi8 ('\t' - 1)),
+                                                    _mm_cmplt_epi8 (block, _mm_set1_epi8 ('\r' + 1)));
+        const __m128i terminators = _mm_cmpeq_epi8 (block, _mm_setzero_si128());
+
+        return _mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (block, spaces),
+                                                _mm_or_si128 (controlCodes, terminators)));
+    }
+
+    inline int findLowestSetBit (const int mask) noexcept
+    {
+        int bit = 0;
+
+        while ((mask & (1 << bit)) == 0)
+            ++bit;
+
+        return bit;
+    }
+   #endif
+}
+
+size_t CharacterFunctions::skipAsciiRun (CharPointer_UTF8& text, const size_t maxChars, const bool skipWhitespace) noexcept
+{
+    using namespace CharacterFunctionsHelpers;
+    const uint8* const bytes = reinterpret_cast <const uint8*> (text.getAddress());
+    size_t numSkipped = 0;
+
+    while (numSkipped < maxChars)
+    {
+       #if JUCE_USE_SSE2_TEXT_SCANNING
+        if ((((pointer_sized_int) (bytes + numSkipped)) & 15) == 0)
+        {
+            // An aligned load can't cross into another page, so it's safe to read a whole
+            // block even when the string's terminator is somewhere inside it.
+            const int mask = findBytesNotInAsciiRun (_mm_load_si128 (reinterpret_cast <const __m128i*> (bytes + numSkipped)),
+                                                     skipWhitespace);
+
+            if (mask != 0)
+            {
+                numSkipped += (size_t) findLowestSetBit (mask);
+                break;
+            }
+
+            numSkipped += 16;
+            continue;
+        }
+       #endif
+
+        if (! isInAsciiRun (bytes [numSkipped], skipWhitespace))
+            break;
+
+        ++numSkipped;
+    }
+
+    numSkipped = jmin (numSkipped, maxChars);
+    text = CharPointer_UTF8 (reinterpret_cast <const char*> (bytes + numSkipped));
+    return numSkipped;
+}
+
 
 END_JUCE_NAMESPACE
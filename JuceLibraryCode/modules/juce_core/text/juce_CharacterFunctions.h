@@ -65,6 +65,8 @@
 #undef max
 #undef min
 
+class CharPointer_UTF8;
+
 //==============================================================================
 /**
     A set of methods for manipulating characters and character strings.
@@ -524,6 +526,40 @@ public:
         return t;
     }
 
+    //==============================================================================
+    /** Moves a pointer past a run of ASCII characters that are all of the same kind, and
+        returns the number of characters that it skipped.
+
+        If skipWhitespace is true, the run is made up of whitespace other than line-breaks,
+        otherwise it's made up of non-whitespace characters. The pointer stops at the first
+        character that doesn't belong to the run, at any non-ASCII character, at the end of the
+        string, or after maxChars characters, so that the caller can carry on from there with
+        its normal character-by-character parsing.
+    */
+    template <typename CharPointerType>
+    static size_t skipAsciiRun (CharPointerType& text, const size_t maxChars, const bool skipWhitespace) noexcept
+    {
+        size_t numSkipped = 0;
+
+        while (numSkipped < maxChars)
+        {
+            const juce_wchar c = *text;
+
+            if (c == 0 || c >= 0x80 || c == '\r' || c == '\n' || isWhitespace ((char) c) != skipWhitespace)
+                break;
+
+            ++text;
+            ++numSkipped;
+        }
+
+        return numSkipped;
+    }
+
+    /** A faster version of skipAsciiRun() for UTF-8 strings, which looks at 16 bytes at a time
+        on processors that support SSE2.
+    */
+    static size_t skipAsciiRun (CharPointer_UTF8& text, size_t maxChars, bool skipWhitespace) noexcept;
+
 private:
     static double mulexp10 (const double value, int exponent) noexcept;
 };
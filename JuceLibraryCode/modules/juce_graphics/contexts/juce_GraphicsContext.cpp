@@ -49,6 +49,12 @@ LowLevelGraphicsContext::~LowLevelGraphicsContext()
 {
 }
 
+void LowLevelGraphicsContext::drawGlyphRun (const int* glyphNumbers, const Point<float>* positions, int numGlyphs)
+{
+    for (int i = 0; i < numGlyphs; ++i)
+        drawGlyph (glyphNumbers[i], AffineTransform::translation (positions[i].x, positions[i].y));
+}
+
 //==============================================================================
 Graphics::Graphics (const Image& imageToDrawOnto)
     : context (imageToDrawOnto.createLowLevelContext()),
@@ -103,6 +103,10 @@ public:
     virtual void setFont (const Font& newFont) = 0;
     virtual Font getFont() = 0;
     virtual void drawGlyph (int glyphNumber, const AffineTransform& transform) = 0;
+    /** Draws a set of glyphs from the current font, each one translated to its own position.
+        The default implementation just calls drawGlyph() for each of them.
+    */
+    virtual void drawGlyphRun (const int* glyphNumbers, const Point<float>* positions, int numGlyphs);
     virtual bool drawTextLayout (const AttributedString&, const Rectangle<int>&, float* /*textHeight*/)  { return false; }
 };
 
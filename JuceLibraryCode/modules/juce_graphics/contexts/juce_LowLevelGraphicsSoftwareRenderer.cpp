@@ -1020,6 +1020,7 @@ public:
     virtual void fillRectWithColour (Image::BitmapData& destData, const Rectangle<int>& area, const PixelARGB& colour, bool replaceContents) const = 0;
     virtual void fillRectWithColour (Image::BitmapData& destData, const Rectangle<float>& area, const PixelARGB& colour) const = 0;
     virtual void fillAllWithColour (Image::BitmapData& destData, const PixelARGB& colour, bool replaceContents) const = 0;
+    virtual void fillMaskWithColour (Image::BitmapData& destData, const Rectangle<int>& area, const uint8* mask, int maskLineStride, const PixelARGB& colour) const = 0;
     virtual void fillAllWithGradient (Image::BitmapData& destData, ColourGradient& gradient, const AffineTransform& transform, bool isIdentity) const = 0;
     virtual void renderImageTransformed (const Image::BitmapData& destData, const Image::BitmapData& srcData, const int alpha, const AffineTransform& t, bool betterQuality, bool tiledFill) const = 0;
     virtual void renderImageUntransformed (const Image::BitmapData& destData, const Image::BitmapData& srcData, const int alpha, int x, int y, bool tiledFill) const = 0;
@@ -1345,6 +1346,13 @@ public:
         }
     }
 
+    void fillMaskWithColour (Image::BitmapData& destData, const Rectangle<int>& area, const uint8* mask, int maskLineStride, const PixelARGB& colour) const
+    {
+        ClipRegion_EdgeTable et (EdgeTable (area, mask, maskLineStride));
+        et.edgeTable.clipToEdgeTable (edgeTable);
+        et.fillAllWithColour (destData, colour, false);
+    }
+
     void fillAllWithGradient (Image::BitmapData& destData, ColourGradient& gradient, const AffineTransform& transform, bool isIdentity) const
     {
         HeapBlock <PixelARGB> lookupTable;
@@ -1499,6 +1507,18 @@ public:
         }
     }
 
+    void fillMaskWithColour (Image::BitmapData& destData, const Rectangle<int>& area, const uint8* mask, int maskLineStride, const PixelARGB& colour) const
+    {
+        SubRectangleMaskIterator iter (clip, area, mask, maskLineStride);
+
+        switch (destData.pixelFormat)
+        {
+            case Image::ARGB:   renderSolidFill (iter, destData, colour, false, (PixelARGB*) 0); break;
+            case Image::RGB:    renderSolidFill (iter, destData, colour, false, (PixelRGB*) 0); break;
+            default:            renderSolidFill (iter, destData, colour, false, (PixelAlpha*) 0); break;
+        }
+    }
+
     void fillAllWithGradient (Image::BitmapData& destData, ColourGradient& gradient, const AffineTransform& transform, bool isIdentity) const
     {
         HeapBlock <PixelARGB> lookupTable;
@@ -1588,6 +1608,72 @@ private:
         JUCE_DECLARE_NON_COPYABLE (SubRectangleIterator);
     };
 
+    //==============================================================================
+    class SubRectangleMaskIterator
+    {
+    public:
+        SubRectangleMaskIterator (const RectangleList& clip_, const Rectangle<int>& area_,
+                                  const uint8* mask_, const int maskLineStride_) noexcept
+            : clip (clip_), area (area_), mask (mask_), maskLineStride (maskLineStride_)
+        {
+        }
+
+        template <class Renderer>
+        void iterate (Renderer& r) const noexcept
+        {
+            RectangleList::Iterator iter (clip);
+
+            while (iter.next())
+            {
+                const Rectangle<int> rect (iter.getRectangle()->getIntersection (area));
+
+                if (! rect.isEmpty())
+                {
+                    const int right = rect.getRight();
+                    const int bottom = rect.getBottom();
+
+                    for (int y = rect.getY(); y < bottom; ++y)
+                    {
+                        const uint8* m = mask + (y - area.getY()) * maskLineStride + (rect.getX() - area.getX());
+                        r.setEdgeTableYPos (y);
+
+                        for (int x = rect.getX(); x < right;)
+                        {
+                            // find the run of pixels that have the same level..
+                            const int level = *m;
+                            int numPix = 1;
+
+                            while (x + numPix < right && m [numPix] == level)
+                                ++numPix;
+
+                            if (level >= 255)
+                            {
+                                if (numPix == 1)    r.handleEdgeTablePixelFull (x);
+                                else                r.handleEdgeTableLineFull (x, numPix);
+                            }
+                            else if (level > 0)
+                            {
+                                if (numPix == 1)    r.handleEdgeTablePixel (x, level);
+                                else                r.handleEdgeTableLine (x, numPix, level);
+                            }
+
+                            x += numPix;
+                            m += numPix;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        const RectangleList& clip;
+        const Rectangle<int> area;
+        const uint8* const mask;
+        const int maskLineStride;
+
+        JUCE_DECLARE_NON_COPYABLE (SubRectangleMaskIterator);
+    };
+
     //==============================================================================
     class SubRectangleIteratorFloat
     {
@@ -1935,6 +2021,23 @@ public:
         }
     }
 
+    // (the area is in device coordinates)
+    void fillAlphaMask (const Rectangle<int>& deviceArea, const uint8* mask, const int maskLineStride)
+    {
+        if (clip != nullptr)
+        {
+            if (fillType.isColour())
+            {
+                Image::BitmapData destData (image, Image::BitmapData::readWrite);
+                clip->fillMaskWithColour (destData, deviceArea, mask, maskLineStride, fillType.colour.getPixelARGB());
+            }
+            else
+            {
+                fillShape (new SoftwareRendererClasses::ClipRegion_EdgeTable (EdgeTable (deviceArea, mask, maskLineStride)), false);
+            }
+        }
+    }
+
     void drawGlyph (const Font& f, int glyphNumber, const AffineTransform& t)
     {
         if (clip != nullptr)
@@ -2208,43 +2311,527 @@ void LowLevelGraphicsSoftwareRenderer::drawHorizontalLine (const int y, float le
 }
 
 //==============================================================================
-class CachedGlyphEdgeTable
+/** A set of 8-bit images that the glyph masks are packed into.
+
+    Each page is divided into shelves, which are rows whose heights are rounded up to a
+    multiple of a few pixels, and a mask goes into the first shelf of about the right height
+    that has room for it. When a glyph is deleted, its columns are given back to its shelf so
+    that another glyph can use them, and the empty shelves at the bottom of a page can be
+    reused for masks of any height. A page is freed once none of its space is in use.
+*/
+class GlyphAtlas  : private DeletedAtShutdown
+{
+public:
+    //==============================================================================
+    /** One of the atlas's images, and a record of which parts of it are in use. */
+    class Page  : public ReferenceCountedObject
+    {
+    public:
+        typedef ReferenceCountedObjectPtr<Page> Ptr;
+
+        Page (const int width, const int height)
+            : image (Image::SingleChannel, width, height, true, SoftwareImageType()),
+              nextShelfY (0)
+        {
+        }
+
+        /** Finds space for a mask, returning false if there isn't any.
+            The slot that's returned may be a few pixels taller than the mask.
+        */
+        bool allocate (const int width, const int height, Rectangle<int>& slot)
+        {
+            const ScopedLock sl (lock);
+            const int shelfHeight = (height + shelfHeightStep - 1) & ~(shelfHeightStep - 1);
+            const int maxShelfHeight = shelfHeight + jmax ((int) shelfHeightStep, shelfHeight / 4);
+
+            for (int i = 0; i < shelves.size(); ++i)
+            {
+                Shelf& shelf = shelves.getReference (i);
+
+                if (shelf.height >= shelfHeight && shelf.height <= maxShelfHeight && shelf.allocate (width, slot))
+                    return true;
+            }
+
+            if (width <= image.getWidth() && nextShelfY + shelfHeight <= image.getHeight())
+            {
+                shelves.add (Shelf (nextShelfY, shelfHeight, image.getWidth()));
+                nextShelfY += shelfHeight;
+                return shelves.getReference (shelves.size() - 1).allocate (width, slot);
+            }
+
+            // As a last resort, a mask can go in an empty shelf that's much taller than it
+            for (int i = 0; i < shelves.size(); ++i)
+            {
+                Shelf& shelf = shelves.getReference (i);
+
+                if (shelf.numSlotsInUse == 0 && shelf.height >= shelfHeight && shelf.allocate (width, slot))
+                    return true;
+            }
+
+            return false;
+        }
+
+        /** Gives back a slot that was returned by allocate(). */
+        void release (const Rectangle<int>& slot)
+        {
+            const ScopedLock sl (lock);
+
+            for (int i = shelves.size(); --i >= 0;)
+            {
+                Shelf& shelf = shelves.getReference (i);
+
+                if (shelf.y == slot.getY())
+                {
+                    shelf.freeColumns.addRange (Range<int> (slot.getX(), slot.getRight()));
+                    --(shelf.numSlotsInUse);
+                    break;
+                }
+            }
+
+            while (shelves.size() > 0 && shelves.getReference (shelves.size() - 1).numSlotsInUse == 0)
+            {
+                nextShelfY = shelves.getReference (shelves.size() - 1).y;
+                shelves.removeLast();
+            }
+        }
+
+        Image image;
+
+    private:
+        struct Shelf
+        {
+            Shelf (const int y_, const int height_, const int width)
+                : y (y_), height (height_), numSlotsInUse (0)
+            {
+                freeColumns.addRange (Range<int> (0, width));
+            }
+
+            bool allocate (const int width, Rectangle<int>& slot)
+            {
+                for (int i = 0; i < freeColumns.getNumRanges(); ++i)
+                {
+                    const Range<int> columns (freeColumns.getRange (i));
+
+                    if (columns.getLength() >= width)
+                    {
+                        freeColumns.removeRange (Range<int> (columns.getStart(), columns.getStart() + width));
+                        slot.setBounds (columns.getStart(), y, width, height);
+                        ++numSlotsInUse;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            int y, height, numSlotsInUse;
+            SparseSet<int> freeColumns;
+        };
+
+        CriticalSection lock;
+        Array<Shelf> shelves;
+        int nextShelfY;
+
+        JUCE_DECLARE_NON_COPYABLE (Page);
+    };
+
+    //==============================================================================
+    GlyphAtlas()
+    {
+    }
+
+    ~GlyphAtlas()
+    {
+        clearSingletonInstance();
+    }
+
+    /** Finds space for a mask of the given size, and returns the page that it's on. */
+    Page::Ptr allocate (const int width, const int height, Rectangle<int>& slot)
+    {
+        if (width > pageSize || height > pageSize)
+        {
+            Page::Ptr page (new Page (width, (height + shelfHeightStep - 1) & ~(shelfHeightStep - 1)));
+            page->allocate (width, height, slot);
+            return page;
+        }
+
+        const ScopedLock sl (lock);
+
+        // Once no glyphs refer to a page, all of its space is free, so only one empty page is kept
+        bool hasEmptyPage = false;
+
+        for (int i = pages.size(); --i >= 0;)
+        {
+            if (pages.getReference (i)->getReferenceCount() == 1)
+            {
+                if (hasEmptyPage)
+                    pages.remove (i);
+
+                hasEmptyPage = true;
+            }
+        }
+
+        for (int i = 0; i < pages.size(); ++i)
+            if (pages.getReference (i)->allocate (width, height, slot))
+                return pages.getReference (i);
+
+        const Page::Ptr page (new Page (pageSize, pageSize));
+        pages.add (page);
+        page->allocate (width, height, slot);
+        return page;
+    }
+
+    juce_DeclareSingleton (GlyphAtlas, false);
+
+private:
+    enum { pageSize = 512 };
+    enum { shelfHeightStep = 4 };
+
+    CriticalSection lock;
+    Array<Page::Ptr> pages;
+
+    JUCE_DECLARE_NON_COPYABLE (GlyphAtlas);
+};
+
+juce_ImplementSingleton (GlyphAtlas);
+
+//==============================================================================
+/** An optional file of rendered glyph masks that's kept between runs.
+
+    The file is memory-mapped when it's opened, so a glyph that it contains can be copied
+    straight into the atlas instead of being rendered from its outline. Glyphs that weren't
+    in the file are added to it when the cache is deleted at shutdown.
+*/
+class GlyphDiskCache  : private DeletedAtShutdown
+{
+public:
+    GlyphDiskCache()
+        : fileSize (headerSize), hasNewGlyphs (false)
+    {
+    }
+
+    ~GlyphDiskCache()
+    {
+        save();
+        clearSingletonInstance();
+    }
+
+    void setFile (const File& newFile)
+    {
+        const ScopedLock sl (lock);
+
+        save();
+        glyphs.clear();
+        newGlyphData.clear();
+        mappedFile = nullptr;
+        fileSize = headerSize;
+        file = newFile;
+
+        mappedFile = new MemoryMappedFile (file, MemoryMappedFile::readOnly);
+        const uint8* const data = static_cast <const uint8*> (mappedFile->getData());
+        const size_t size = mappedFile->getSize();
+
+        if (data != nullptr && size >= (size_t) headerSize
+             && readInt (data) == (int) fileMagic)
+        {
+            for (size_t pos = headerSize; pos + entryHeaderSize <= size;)
+            {
+                // (a corrupt or truncated file mustn't produce a glyph whose mask goes past its end)
+                const int width  = readInt (data + pos + 16);
+                const int height = readInt (data + pos + 20);
+
+                if (width <= 0 || height <= 0 || width > maxGlyphSize || height > maxGlyphSize
+                     || (size_t) width * (size_t) height > size - pos - entryHeaderSize)
+                    break;
+
+                StoredGlyph g;
+                g.bounds.setBounds (readInt (data + pos + 8), readInt (data + pos + 12), width, height);
+                g.mask = data + pos + entryHeaderSize;
+
+                const size_t entrySize = entryHeaderSize + (size_t) g.getMaskSize();
+
+                glyphs.set ((int64) (ByteOrder::littleEndianInt (data + pos)
+                                      | ((uint64) ByteOrder::littleEndianInt (data + pos + 4) << 32)), g);
+                pos += entrySize;
+                fileSize = pos;
+            }
+        }
+    }
+
+    /** Returns the key that a glyph is stored under, or 0 if it can't be kept. */
+    static int64 getKey (const Font& font, const int glyphNumber, const AffineTransform& transform)
+    {
+        Typeface* const typeface = font.getTypeface();
+        const int64 fontFileHash = typeface->getFontFileHash();
+
+        // A glyph that the typeface doesn't contain is drawn by one of the font's fallback
+        // typefaces, which can change without the file hash changing, so it isn't kept.
+        if (fontFileHash == 0 || ! typeface->hasGlyph ((juce_wchar) glyphNumber))
+            return 0;
+
+        const float values[] = { font.getHeight(), font.getHorizontalScale(),
+                                 transform.mat00, transform.mat01, transform.mat02,
+                                 transform.mat10, transform.mat11, transform.mat12 };
+
+        uint64 h = 14695981039346656037ULL;
+        h = (h ^ (uint64) fontFileHash) * 1099511628211ULL;
+        h = (h ^ (uint64) (uint32) glyphNumber) * 1099511628211ULL;
+
+        for (int i = 0; i < numElementsInArray (values); ++i)
+        {
+            union { float asFloat; uint32 asInt; } u;
+            u.asFloat = values[i];
+            h = (h ^ u.asInt) * 1099511628211ULL;
+        }
+
+        return h != 0 ? (int64) h : 1;
+    }
+
+    /** If the glyph is in the cache, this passes its bounds and mask to the glyph's setMask() method. */
+    template <class GlyphType>
+    bool loadGlyph (const int64 key, GlyphType& glyph)
+    {
+        const ScopedLock sl (lock);
+
+        if (! glyphs.contains (key))
+            return false;
+
+        const StoredGlyph g (glyphs [key]);
+        glyph.setMask (g.bounds, g.mask, g.bounds.getWidth());
+        return true;
+    }
+
+    void storeGlyph (const int64 key, const Rectangle<int>& bounds, const uint8* mask, const int lineStride)
+    {
+        const ScopedLock sl (lock);
+
+        if (bounds.isEmpty() || bounds.getWidth() > maxGlyphSize || bounds.getHeight() > maxGlyphSize)
+            return;
+
+        StoredGlyph g;
+        g.bounds = bounds;
+
+        const size_t entrySize = entryHeaderSize + (size_t) g.getMaskSize();
+
+        if (glyphs.contains (key) || fileSize + entrySize > (size_t) maxFileSize)
+            return;
+
+        MemoryBlock* const data = new MemoryBlock ((size_t) g.getMaskSize());
+        newGlyphData.add (data);
+
+        for (int y = 0; y < bounds.getHeight(); ++y)
+            memcpy (static_cast <uint8*> (data->getData()) + y * bounds.getWidth(),
+                    mask + y * lineStride, (size_t) bounds.getWidth());
+
+        g.mask = static_cast <const uint8*> (data->getData());
+        glyphs.set (key, g);
+        fileSize += entrySize;
+        hasNewGlyphs = true;
+    }
+
+    juce_DeclareSingleton (GlyphDiskCache, false);
+
+private:
+    enum
+    {
+        fileMagic = 0x3263676a,  // "jgc2"
+        headerSize = 4,
+        entryHeaderSize = 24,
+        maxGlyphSize = 1024,   // (glyphs that are any wider or taller than this aren't kept)
+        maxFileSize = 16 * 1024 * 1024
+    };
+
+    struct StoredGlyph
+    {
+        StoredGlyph() noexcept : mask (nullptr) {}
+
+        int getMaskSize() const noexcept     { return bounds.getWidth() * bounds.getHeight(); }
+
+        Rectangle<int> bounds;
+        const uint8* mask;
+    };
+
+    struct KeyHashFunction
+    {
+        static int generateHash (const int64 key, const int upperLimit) noexcept
+        {
+            return (int) (((uint64) key ^ ((uint64) key >> 32)) % (uint64) upperLimit);
+        }
+    };
+
+    CriticalSection lock;
+    File file;
+    ScopedPointer<MemoryMappedFile> mappedFile;
+    HashMap<int64, StoredGlyph, KeyHashFunction> glyphs;
+    OwnedArray<MemoryBlock> newGlyphData;
+    size_t fileSize;
+    bool hasNewGlyphs;
+
+    static int readInt (const uint8* const p) noexcept     { return (int) ByteOrder::littleEndianInt (p); }
+
+    // The file stays mapped until it's replaced, and the stored glyphs that came from it
+    // can't be used after that, so this is only called just before the cache is emptied.
+    void save()
+    {
+        if (! hasNewGlyphs)
+            return;
+
+        hasNewGlyphs = false;
+
+        MemoryOutputStream out (fileSize);
+        out.writeInt ((int) fileMagic);
+
+        for (HashMap<int64, StoredGlyph, KeyHashFunction>::Iterator i (glyphs); i.next();)
+        {
+            const StoredGlyph g (i.getValue());
+
+            out.writeInt64 (i.getKey());
+            out.writeInt (g.bounds.getX());
+            out.writeInt (g.bounds.getY());
+            out.writeInt (g.bounds.getWidth());
+            out.writeInt (g.bounds.getHeight());
+            out.write (g.mask, g.getMaskSize());
+        }
+
+        // (on some platforms a file can't be replaced while it's mapped)
+        mappedFile = nullptr;
+
+        file.getParentDirectory().createDirectory();
+        file.replaceWithData (out.getData(), out.getDataSize());
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (GlyphDiskCache);
+};
+
+juce_ImplementSingleton (GlyphDiskCache);
+
+//==============================================================================
+class CachedGlyphMask  : public ReferenceCountedObject
 {
 public:
-    CachedGlyphEdgeTable() : glyph (0), lastAccessCount (0) {}
+    CachedGlyphMask() : mask (nullptr), maskLineStride (0) {}
 
-    void draw (LowLevelGraphicsSoftwareRenderer::SavedState& state, float x, const float y) const
+    ~CachedGlyphMask()
     {
-        if (snapToIntegerCoordinate)
-            x = std::floor (x + 0.5f);
+        if (page != nullptr)
+            page->release (slot);
+    }
 
-        if (edgeTable != nullptr)
-            state.fillEdgeTable (*edgeTable, x, roundToInt (y));
+    void draw (LowLevelGraphicsSoftwareRenderer::SavedState& state, const int x, const int y) const
+    {
+        if (mask != nullptr)
+            state.fillAlphaMask (bounds.translated (x, y), mask, maskLineStride);
     }
 
-    void generate (const Font& newFont, const int glyphNumber)
+    void generate (const Font& font, const int glyphNumber, const AffineTransform& transform)
     {
-        font = newFont;
-        snapToIntegerCoordinate = newFont.getTypeface()->isHinted();
-        glyph = glyphNumber;
+        GlyphDiskCache* const diskCache = GlyphDiskCache::getInstanceWithoutCreating();
+        const int64 diskCacheKey = diskCache != nullptr ? GlyphDiskCache::getKey (font, glyphNumber, transform) : 0;
+
+        if (diskCacheKey != 0 && diskCache->loadGlyph (diskCacheKey, *this))
+            return;
 
         const float fontHeight = font.getHeight();
-        edgeTable = font.getTypeface()->getEdgeTableForGlyph (glyphNumber,
-                                                              AffineTransform::scale (fontHeight * font.getHorizontalScale(), fontHeight)
-                                                                            #if JUCE_MAC || JUCE_IOS
-                                                                              .translated (0.0f, -0.5f)
-                                                                            #endif
-                                                              );
+        const ScopedPointer<EdgeTable> et (font.getTypeface()->getEdgeTableForGlyph (glyphNumber,
+                                                                                     AffineTransform::scale (fontHeight * font.getHorizontalScale(), fontHeight)
+                                                                                                     .followedBy (transform)
+                                                                                                   #if JUCE_MAC || JUCE_IOS
+                                                                                                     .translated (0.0f, -0.5f)
+                                                                                                   #endif
+                                                                                     ));
+
+        if (et != nullptr && ! et->getMaximumBounds().isEmpty())
+        {
+            allocate (et->getMaximumBounds());
+
+            // (the slot may have been used by another glyph, so it has to be cleared first)
+            for (int y = 0; y < bounds.getHeight(); ++y)
+                zeromem (mask + y * maskLineStride, (size_t) bounds.getWidth());
+
+            const Image::BitmapData maskData (page->image, Image::BitmapData::readWrite);
+            MaskWriter writer (maskData, slot.getPosition() - bounds.getPosition());
+            et->iterate (writer);
+        }
+
+        if (diskCacheKey != 0)
+            diskCache->storeGlyph (diskCacheKey, bounds, mask, maskLineStride);
     }
 
-    Font font;
-    int glyph, lastAccessCount;
-    bool snapToIntegerCoordinate;
+    /** Copies a mask that has already been rendered into the atlas. */
+    void setMask (const Rectangle<int>& area, const uint8* sourceMask, const int sourceLineStride)
+    {
+        if (! area.isEmpty())
+        {
+            allocate (area);
+
+            for (int y = 0; y < area.getHeight(); ++y)
+                memcpy (mask + y * maskLineStride, sourceMask + y * sourceLineStride, (size_t) area.getWidth());
+        }
+    }
+
+    size_t getMemorySize() const noexcept
+    {
+        return sizeof (*this) + (size_t) (slot.getWidth() * slot.getHeight());
+    }
+
+    /** Returns the area that the mask covers when the glyph is drawn at the origin. */
+    const Rectangle<int>& getBounds() const noexcept        { return bounds; }
+
+    /** Returns one of the rows of the mask, which is a line of bounds.getWidth() alpha levels. */
+    const uint8* getLine (const int row) const noexcept     { return mask + row * maskLineStride; }
 
 private:
-    ScopedPointer <EdgeTable> edgeTable;
+    GlyphAtlas::Page::Ptr page;
+    Rectangle<int> bounds, slot;
+    uint8* mask;
+    int maskLineStride;
+
+    void allocate (const Rectangle<int>& area)
+    {
+        bounds = area;
+        page = GlyphAtlas::getInstance()->allocate (bounds.getWidth(), bounds.getHeight(), slot);
+
+        // The atlas pages are software images, so their pixels stay where they are for
+        // as long as this object keeps its page alive.
+        const Image::BitmapData maskData (page->image, Image::BitmapData::readWrite);
+        mask = maskData.getPixelPointer (slot.getX(), slot.getY());
+        maskLineStride = maskData.lineStride;
+    }
+
+    struct MaskWriter
+    {
+        MaskWriter (const Image::BitmapData& data_, const Point<int>& offset_) noexcept
+            : data (data_), offset (offset_), line (nullptr)
+        {
+        }
+
+        forcedinline void setEdgeTableYPos (const int y) noexcept
+        {
+            line = data.getLinePointer (y + offset.y) + offset.x;
+        }
+
+        forcedinline void handleEdgeTablePixel (const int x, const int alphaLevel) const noexcept   { line [x] = (uint8) alphaLevel; }
+        forcedinline void handleEdgeTablePixelFull (const int x) const noexcept                     { line [x] = 255; }
+        forcedinline void handleEdgeTableLine (const int x, const int width, const int alphaLevel) const noexcept   { memset (line + x, alphaLevel, (size_t) width); }
+        forcedinline void handleEdgeTableLineFull (const int x, const int width) const noexcept     { memset (line + x, 255, (size_t) width); }
+
+        const Image::BitmapData& data;
+        const Point<int> offset;
+        uint8* line;
+
+        JUCE_DECLARE_NON_COPYABLE (MaskWriter);
+    };
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CachedGlyphEdgeTable);
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CachedGlyphMask);
+};
+
+typedef RenderingHelpers::GlyphCache <CachedGlyphMask, LowLevelGraphicsSoftwareRenderer::SavedState> SoftwareGlyphCache;
+
+/** A glyph from a run, and the area that it covers in the run. */
+struct PlacedGlyphMask
+{
+    SoftwareGlyphCache::GlyphPtr glyph;
+    Rectangle<int> area;
 };
 
 void LowLevelGraphicsSoftwareRenderer::drawGlyph (int glyphNumber, const AffineTransform& transform)
@@ -2253,12 +2840,12 @@ void LowLevelGraphicsSoftwareRenderer::drawGlyph (int glyphNumber, const AffineT
 
     if (transform.isOnlyTranslation() && savedState->transform.isOnlyTranslated)
     {
-        RenderingHelpers::GlyphCache <CachedGlyphEdgeTable, SavedState>::getInstance()
-            .drawGlyph (*savedState, f, glyphNumber,
-                        transform.getTranslationX(),
-                        transform.getTranslationY());
+        SoftwareGlyphCache::getInstance().drawGlyph (*savedState, f, glyphNumber,
+                                                     savedState->transform.xOffset + transform.getTranslationX(),
+                                                     savedState->transform.yOffset + transform.getTranslationY());
     }
-    else
+    else if (! SoftwareGlyphCache::getInstance().drawTransformedGlyph (*savedState, f, glyphNumber,
+                                                                       savedState->transform.getTransformWith (transform)))
     {
         const float fontHeight = f.getHeight();
         savedState->drawGlyph (f, glyphNumber,
@@ -2267,6 +2854,85 @@ void LowLevelGraphicsSoftwareRenderer::drawGlyph (int glyphNumber, const AffineT
     }
 }
 
+void LowLevelGraphicsSoftwareRenderer::drawGlyphRun (const int* glyphNumbers, const Point<float>* positions, int numGlyphs)
+{
+    if (! savedState->transform.isOnlyTranslated)
+    {
+        LowLevelGraphicsContext::drawGlyphRun (glyphNumbers, positions, numGlyphs);
+        return;
+    }
+
+    if (savedState->clip == nullptr || numGlyphs <= 0)
+        return;
+
+    // Find the masks for all the glyphs first, and then combine them into one coverage
+    // mask, so that the whole run is blended onto the image in a single pass.
+    SoftwareGlyphCache& cache = SoftwareGlyphCache::getInstance();
+    const RenderingHelpers::TranslationOrTransform& t = savedState->transform;
+    Array<PlacedGlyphMask> placed;
+    placed.ensureStorageAllocated (numGlyphs);
+    Rectangle<int> runBounds;
+
+    for (int i = 0; i < numGlyphs; ++i)
+    {
+        int x;
+        const int phase = SoftwareGlyphCache::getSubpixelPhase (t.xOffset + positions[i].x, x);
+        SoftwareGlyphCache::GlyphPtr glyph (cache.getGlyph (savedState->font, glyphNumbers[i], phase));
+        const Rectangle<int> area (glyph->getBounds().translated (x, roundToInt (t.yOffset + positions[i].y)));
+
+        if (! area.isEmpty())
+        {
+            PlacedGlyphMask p;
+            p.glyph = glyph;
+            p.area = area;
+            placed.add (p);
+
+            runBounds = runBounds.isEmpty() ? area : runBounds.getUnion (area);
+        }
+    }
+
+    runBounds = runBounds.getIntersection (savedState->clip->getClipBounds());
+
+    if (! runBounds.isEmpty())
+    {
+        const int width = runBounds.getWidth();
+        HeapBlock<uint8> coverage;
+        coverage.calloc ((size_t) (width * runBounds.getHeight()));
+
+        for (int i = 0; i < placed.size(); ++i)
+        {
+            const PlacedGlyphMask& p = placed.getReference (i);
+            const Rectangle<int> area (p.area.getIntersection (runBounds));
+
+            for (int y = area.getY(); y < area.getBottom(); ++y)
+            {
+                const uint8* src = p.glyph->getLine (y - p.area.getY()) + (area.getX() - p.area.getX());
+                uint8* dest = coverage + (y - runBounds.getY()) * width + (area.getX() - runBounds.getX());
+
+                // Where glyphs overlap, their coverage is combined in the same way as
+                // it would be if they were drawn one after the other.
+                for (int n = area.getWidth(); --n >= 0; ++src, ++dest)
+                    *dest = (uint8) (*dest + *src - ((*dest * *src + 255) >> 8));
+            }
+        }
+
+        savedState->fillAlphaMask (runBounds, coverage, width);
+    }
+}
+
+void LowLevelGraphicsSoftwareRenderer::setGlyphCacheMemoryLimit (const size_t maxNumBytes)
+{
+    SoftwareGlyphCache::getInstance().setMemoryLimit (maxNumBytes);
+}
+
+void LowLevelGraphicsSoftwareRenderer::setGlyphDiskCacheFile (const File& cacheFile)
+{
+    if (cacheFile == File::nonexistent)
+        GlyphDiskCache::deleteInstance();
+    else
+        GlyphDiskCache::getInstance()->setFile (cacheFile);
+}
+
 void LowLevelGraphicsSoftwareRenderer::setFont (const Font& newFont)    { savedState->font = newFont; }
 Font LowLevelGraphicsSoftwareRenderer::getFont()                        { return savedState->font; }
 
@@ -85,6 +85,23 @@ public:
     Font getFont();
     void drawGlyph (int glyphNumber, float x, float y);
     void drawGlyph (int glyphNumber, const AffineTransform&);
+    void drawGlyphRun (const int* glyphNumbers, const Point<float>* positions, int numGlyphs);
+
+    /** Changes the amount of memory that the software renderer's cache of rendered glyphs
+        may use before it starts discarding the least-recently used ones.
+    */
+    static void setGlyphCacheMemoryLimit (size_t maxNumBytes);
+
+    /** Makes the software renderer keep the glyphs that it renders in a file, so that the next
+        time the app runs they can be loaded from it rather than rendered from their outlines.
+
+        Any glyphs that weren't already in the file are written to it when the app shuts down,
+        or when this is called again. Passing File::nonexistent stops using a cache file.
+        Only glyphs from typefaces that can identify their font files are stored, and not the
+        glyphs that are drawn by a font's fallback typefaces.
+        @see Typeface::getFontFileHash
+    */
+    static void setGlyphDiskCacheFile (const File& cacheFile);
 
    #ifndef DOXYGEN
     class SavedState;
@@ -27,17 +27,46 @@ BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
 AttributedString::Attribute::Attribute (const Range<int>& range_, const Colour& colour_)
-    : range (range_), colour (new Colour (colour_))
+    : range (range_), colour (colour_), hasFont (false), hasColour (true)
 {
 }
 
 AttributedString::Attribute::Attribute (const Range<int>& range_, const Font& font_)
-    : range (range_), font (new Font (font_))
+    : range (range_), font (font_), hasFont (true), hasColour (false)
 {
 }
 
+AttributedString::Attribute::Attribute (const Attribute& other)
+    : range (other.range), font (other.font), colour (other.colour),
+      hasFont (other.hasFont), hasColour (other.hasColour)
+{
+}
+
+AttributedString::Attribute::Attribute (const Attribute& other, const Range<int>& newRange)
+    : range (newRange), font (other.font), colour (other.colour),
+      hasFont (other.hasFont), hasColour (other.hasColour)
+{
+}
+
+AttributedString::Attribute& AttributedString::Attribute::operator= (const Attribute& other)
+{
+    range = other.range;
+    font = other.font;
+    colour = other.colour;
+    hasFont = other.hasFont;
+    hasColour = other.hasColour;
+    return *this;
+}
+
 AttributedString::Attribute::~Attribute() {}
 
+bool AttributedString::Attribute::hasSameValuesAs (const Attribute& other) const noexcept
+{
+    return hasFont == other.hasFont && hasColour == other.hasColour
+            && ((! hasFont) || font == other.font)
+            && ((! hasColour) || colour == other.colour);
+}
+
 //==============================================================================
 AttributedString::AttributedString()
     : lineSpacing (0.0f),
@@ -85,12 +114,126 @@ void AttributedString::setLineSpacing (const float newLineSpacing) noexcept
 
 void AttributedString::setColour (const Range<int>& range, const Colour& colour)
 {
-    attributes.add (new Attribute (range, colour));
+    applyAttribute (Attribute (range, colour));
 }
 
 void AttributedString::setFont (const Range<int>& range, const Font& font)
 {
-    attributes.add (new Attribute (range, font));
+    applyAttribute (Attribute (range, font));
+}
+
+namespace AttributedStringHelpers
+{
+    void addMerged (Array<AttributedString::Attribute>& list, const AttributedString::Attribute& attribute)
+    {
+        if (attribute.range.isEmpty())
+            return;
+
+        if (list.size() > 0)
+        {
+            AttributedString::Attribute& last = list.getReference (list.size() - 1);
+
+            if (last.range.getEnd() == attribute.range.getStart() && last.hasSameValuesAs (attribute))
+            {
+                last.range.setEnd (attribute.range.getEnd());
+                return;
+            }
+        }
+
+        list.add (attribute);
+    }
+}
+
+void AttributedString::applyAttribute (const Attribute& newAttribute)
+{
+    const Range<int> range (newAttribute.range.getIntersectionWith (Range<int> (0, std::numeric_limits<int>::max())));
+
+    if (range.isEmpty())
+        return;
+
+    // Binary-search for the first attribute that finishes after the start of the new range..
+    int firstIndex = 0;
+
+    {
+        int end = attributes.size();
+
+        while (firstIndex < end)
+        {
+            const int mid = (firstIndex + end) / 2;
+
+            if (attributes.getReference (mid).range.getEnd() <= range.getStart())
+                firstIndex = mid + 1;
+            else
+                end = mid;
+        }
+    }
+
+    // ..then rebuild the section of the list that it overlaps, filling any gaps between
+    // the existing attributes with the new one.
+    Array<Attribute> replacements;
+    int lastIndex = firstIndex;
+    int pos = range.getStart();
+
+    for (; lastIndex < attributes.size(); ++lastIndex)
+    {
+        const Attribute& existing = attributes.getReference (lastIndex);
+
+        if (existing.range.getStart() >= range.getEnd())
+            break;
+
+        if (existing.range.getStart() < pos)
+            AttributedStringHelpers::addMerged (replacements, Attribute (existing, Range<int> (existing.range.getStart(), pos)));
+        else
+            AttributedStringHelpers::addMerged (replacements, Attribute (newAttribute, Range<int> (pos, existing.range.getStart())));
+
+        Attribute overlap (existing, existing.range.getIntersectionWith (range));
+
+        if (newAttribute.hasFont)
+        {
+            overlap.font = newAttribute.font;
+            overlap.hasFont = true;
+        }
+
+        if (newAttribute.hasColour)
+        {
+            overlap.colour = newAttribute.colour;
+            overlap.hasColour = true;
+        }
+
+        AttributedStringHelpers::addMerged (replacements, overlap);
+        AttributedStringHelpers::addMerged (replacements, Attribute (existing, Range<int> (range.getEnd(), existing.range.getEnd())));
+        pos = jmax (pos, existing.range.getEnd());
+    }
+
+    AttributedStringHelpers::addMerged (replacements, Attribute (newAttribute, Range<int> (pos, range.getEnd())));
+
+    // Join up with the neighbours if they've ended up with the same values..
+    if (firstIndex > 0)
+    {
+        const Attribute& previous = attributes.getReference (firstIndex - 1);
+        Attribute& first = replacements.getReference (0);
+
+        if (previous.range.getEnd() == first.range.getStart() && previous.hasSameValuesAs (first))
+        {
+            first.range.setStart (previous.range.getStart());
+            --firstIndex;
+        }
+    }
+
+    if (lastIndex < attributes.size())
+    {
+        const Attribute& next = attributes.getReference (lastIndex);
+        Attribute& last = replacements.getReference (replacements.size() - 1);
+
+        if (last.range.getEnd() == next.range.getStart() && last.hasSameValuesAs (next))
+        {
+            last.range.setEnd (next.range.getEnd());
+            ++lastIndex;
+        }
+    }
+
+    attributes.removeRange (firstIndex, lastIndex - firstIndex);
+    attributes.insertArray (firstIndex, replacements.getRawDataPointer(), replacements.size());
 }
 
 static void drawAttributedString (Graphics& g, const Rectangle<int>& area,
@@ -113,14 +256,30 @@ void AttributedString::draw (Graphics& g, const Rectangle<int>& area)
         drawAttributedString (g, area, *this, nullptr);
 }
 
-void AttributedString::drawMultiple (Graphics& g, const Rectangle<int>& area,
-                                     const AttributedString* const* strings, int numStrings)
+AttributedString::Measurement AttributedString::measure (const float width) const
+{
+    Measurement result;
+    GlyphLayout::measureText (*this, width, result);
+    return result;
+}
+
+namespace AttributedStringHelpers
 {
-    if (numStrings > 0 && g.clipRegionIntersects (area))
+    /** Works down a list of paragraphs from the top of an area, stopping at the first one that
+        would start at or below stopY.
+
+        Each non-empty paragraph is passed to the callback's addParagraph (index, paragraphArea,
+        needsHeight, height) method, which returns its height. If the callback returns false, this
+        stops and returns false. Empty paragraphs just leave a 10-pixel gap.
+    */
+    template <class ParagraphCallback>
+    bool stackParagraphs (const Rectangle<int>& area, const int stopY,
+                          const AttributedString* const* strings, const int numStrings,
+                          ParagraphCallback& callback)
     {
         int y = 0;
 
-        for (int i = 0; i < numStrings && y < area.getHeight(); ++i)
+        for (int i = 0; i < numStrings && area.getY() + y < stopY; ++i)
         {
             if (strings[i]->getText().isEmpty())
             {
@@ -129,12 +288,234 @@ void AttributedString::drawMultiple (Graphics& g, const Rectangle<int>& area,
             else
             {
                 float height = 0;
-                drawAttributedString (g, area.withTop (area.getY() + y), *strings[i],
-                                      (i < numStrings - 1) ? &height : nullptr);
+
+                if (! callback.addParagraph (i, area.withTop (area.getY() + y), i < numStrings - 1, height))
+                    return false;
+
                 y += (int) height;
             }
         }
+
+        return true;
     }
+
+    /** Paragraphs that start below the clip region won't be visible, so there's no need to lay
+        them out. They're still laid out in the whole area, because a native layout engine may
+        position its lines according to the height it's given.
+    */
+    int getVisibleBottom (Graphics& g, const Rectangle<int>& area)
+    {
+        return jmin (area.getBottom(), g.getClipBounds().getBottom());
+    }
+
+    /** Lays out a batch of paragraphs at the top of an area, sharing them out between some
+        ThreadPool jobs and the calling thread.
+    */
+    class ParallelLayout
+    {
+    public:
+        ParallelLayout (const Rectangle<int>& area_, const AttributedString* const* strings_)
+            : area (area_.toFloat()), strings (strings_), firstIndex (0)
+        {
+        }
+
+        void layoutParagraphs (ThreadPool& threadPool, const int start, const int end)
+        {
+            layouts.clear();
+            firstIndex = start;
+            nextIndex = 0;
+
+            for (int i = start; i < end; ++i)
+                layouts.add (strings[i]->getText().isEmpty() ? nullptr : new GlyphLayout (area));
+
+            OwnedArray<Job> jobs;
+            const int numJobs = jmin (SystemStats::getNumCpus(), layouts.size()) - 1;
+
+            for (int i = 0; i < numJobs; ++i)
+            {
+                Job* const job = new Job (*this);
+                jobs.add (job);
+                threadPool.addJob (job);
+            }
+
+            layoutNextParagraphs();
+
+            // Any jobs that haven't been started by now are removed, and running ones are waited for
+            for (int i = 0; i < jobs.size(); ++i)
+                threadPool.removeJob (jobs.getUnchecked (i), false, -1);
+        }
+
+        bool contains (const int index) const noexcept
+        {
+            return index >= firstIndex && index < firstIndex + layouts.size();
+        }
+
+        /** Returns the layout of one of the current batch's paragraphs, or nullptr if it's empty. */
+        GlyphLayout* getLayout (const int index) const noexcept
+        {
+            return layouts [index - firstIndex];
+        }
+
+    private:
+        class Job  : public ThreadPoolJob
+        {
+        public:
+            Job (ParallelLayout& owner_)  : ThreadPoolJob ("Paragraph layout"), owner (owner_) {}
+
+            JobStatus runJob()
+            {
+                owner.layoutNextParagraphs();
+                return jobHasFinished;
+            }
+
+        private:
+            ParallelLayout& owner;
+
+            JUCE_DECLARE_NON_COPYABLE (Job);
+        };
+
+        const Rectangle<float> area;
+        const AttributedString* const* const strings;
+        OwnedArray<GlyphLayout> layouts;   // contains nullptrs for empty paragraphs
+        int firstIndex;
+        Atomic<int> nextIndex;
+
+        void layoutNextParagraphs()
+        {
+            for (;;)
+            {
+                const int index = ++nextIndex - 1;
+
+                if (index >= layouts.size())
+                    break;
+
+                GlyphLayout* const layout = layouts.getUnchecked (index);
+
+                if (layout != nullptr)
+                    layout->setText (*strings [firstIndex + index]);
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (ParallelLayout);
+    };
+
+    //==============================================================================
+    struct DrawParagraph
+    {
+        DrawParagraph (Graphics& g_, const AttributedString* const* strings_)  : g (g_), strings (strings_) {}
+
+        bool addParagraph (const int index, const Rectangle<int>& area, const bool needsHeight, float& height)
+        {
+            drawAttributedString (g, area, *strings[index], needsHeight ? &height : nullptr);
+            return true;
+        }
+
+        Graphics& g;
+        const AttributedString* const* const strings;
+
+        JUCE_DECLARE_NON_COPYABLE (DrawParagraph);
+    };
+
+    struct DrawParagraphNatively
+    {
+        DrawParagraphNatively (Graphics& g_, const AttributedString* const* strings_)  : g (g_), strings (strings_) {}
+
+        bool addParagraph (const int index, const Rectangle<int>& area, const bool needsHeight, float& height)
+        {
+            return g.getInternalContext()->drawTextLayout (*strings[index], area, needsHeight ? &height : nullptr);
+        }
+
+        Graphics& g;
+        const AttributedString* const* const strings;
+
+        JUCE_DECLARE_NON_COPYABLE (DrawParagraphNatively);
+    };
+
+    class LayoutParagraph
+    {
+    public:
+        LayoutParagraph (OwnedArray<GlyphLayout>& layouts_, const Rectangle<int>& area,
+                         const AttributedString* const* strings_, const int numStrings_, ThreadPool* const threadPool_)
+            : layouts (layouts_), strings (strings_), numStrings (numStrings_),
+              threadPool (threadPool_), parallelLayout (area, strings_)
+        {
+        }
+
+        bool addParagraph (const int index, const Rectangle<int>& area, bool, float& height)
+        {
+            GlyphLayout* const layout = new GlyphLayout (area.toFloat());
+            layouts.add (layout);
+
+            if (threadPool != nullptr)
+            {
+                // The paragraphs are laid out in batches, so that not too much work is wasted on
+                // the ones that turn out to be below the bottom of the area.
+                const int paragraphsPerBatch = 64;
+
+                if (! parallelLayout.contains (index))
+                    parallelLayout.layoutParagraphs (*threadPool, index, jmin (numStrings, index + paragraphsPerBatch));
+
+                layout->moveLinesFrom (*parallelLayout.getLayout (index));
+            }
+            else
+            {
+                layout->setText (*strings[index]);
+            }
+
+            height = layout->getTextHeight();
+            return true;
+        }
+
+    private:
+        OwnedArray<GlyphLayout>& layouts;
+        const AttributedString* const* const strings;
+        const int numStrings;
+        ThreadPool* const threadPool;
+        ParallelLayout parallelLayout;
+
+        JUCE_DECLARE_NON_COPYABLE (LayoutParagraph);
+    };
+}
+
+void AttributedString::drawMultiple (Graphics& g, const Rectangle<int>& area,
+                                     const AttributedString* const* strings, int numStrings,
+                                     ThreadPool* const threadPool)
+{
+    if (numStrings <= 0 || ! g.clipRegionIntersects (area))
+        return;
+
+    if (threadPool != nullptr)
+    {
+        if (! drawMultipleNatively (g, area, strings, numStrings))
+        {
+            OwnedArray<GlyphLayout> layouts;
+            AttributedStringHelpers::LayoutParagraph layoutParagraph (layouts, area, strings, numStrings, threadPool);
+            AttributedStringHelpers::stackParagraphs (area, AttributedStringHelpers::getVisibleBottom (g, area), strings, numStrings, layoutParagraph);
+
+            for (int i = 0; i < layouts.size(); ++i)
+                layouts.getUnchecked (i)->draw (g);
+        }
+    }
+    else
+    {
+        AttributedStringHelpers::DrawParagraph drawParagraph (g, strings);
+        AttributedStringHelpers::stackParagraphs (area, AttributedStringHelpers::getVisibleBottom (g, area), strings, numStrings, drawParagraph);
+    }
+}
+
+bool AttributedString::drawMultipleNatively (Graphics& g, const Rectangle<int>& area,
+                                             const AttributedString* const* strings, int numStrings)
+{
+    AttributedStringHelpers::DrawParagraphNatively drawParagraph (g, strings);
+    return AttributedStringHelpers::stackParagraphs (area, AttributedStringHelpers::getVisibleBottom (g, area), strings, numStrings, drawParagraph);
+}
+
+void AttributedString::layoutMultiple (OwnedArray<GlyphLayout>& layouts, const Rectangle<int>& area,
+                                       const AttributedString* const* strings, int numStrings,
+                                       ThreadPool* const threadPool)
+{
+    AttributedStringHelpers::LayoutParagraph layoutParagraph (layouts, area, strings, numStrings, threadPool);
+    AttributedStringHelpers::stackParagraphs (area, area.getBottom(), strings, numStrings, layoutParagraph);
 }
 
 END_JUCE_NAMESPACE
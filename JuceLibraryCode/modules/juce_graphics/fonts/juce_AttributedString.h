@@ -26,6 +26,7 @@
 #ifndef __JUCE_ATTRIBUTEDSTRING_JUCEHEADER__
 #define __JUCE_ATTRIBUTEDSTRING_JUCEHEADER__
 
+class GlyphLayout;
 
 //==============================================================================
 /**
@@ -99,47 +100,119 @@ public:
     void setLineSpacing (float newLineSpacing) noexcept;
 
     //==============================================================================
-    /** */
+    /** A font and/or colour applied to a range of characters.
+
+        The attributes of an AttributedString are kept sorted by position and never
+        overlap, so each one describes the complete set of properties for its range.
+        Either property may be missing, in which case the default is used.
+    */
     class JUCE_API  Attribute
     {
     public:
         Attribute (const Range<int>& range, const Colour& colour);
         Attribute (const Range<int>& range, const Font& font);
+        Attribute (const Attribute& other);
+        Attribute& operator= (const Attribute& other);
         ~Attribute();
 
         /** */
-        const Font* getFont() const noexcept            { return font; }
+        const Font* getFont() const noexcept            { return hasFont ? &font : nullptr; }
         /** */
-        const Colour* getColour() const noexcept        { return colour; }
+        const Colour* getColour() const noexcept        { return hasColour ? &colour : nullptr; }
+
+        /** Returns true if both attributes specify the same font and colour. */
+        bool hasSameValuesAs (const Attribute& other) const noexcept;
 
         /** */
-        const Range<int> range;
+        Range<int> range;
 
     private:
-        ScopedPointer<Font> font;
-        ScopedPointer<Colour> colour;
+        Font font;
+        Colour colour;
+        bool hasFont, hasColour;
+
+        friend class AttributedString;
+        Attribute (const Attribute& other, const Range<int>& newRange);
 
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Attribute);
+        JUCE_LEAK_DETECTOR (Attribute);
     };
 
-    /** */
+    /** Returns the number of attribute runs.
+        These are sorted by their range and never overlap.
+    */
     int getNumAttributes() const noexcept                       { return attributes.size(); }
     /** */
-    const Attribute* getAttribute (int index) const noexcept    { return attributes.getUnchecked (index); }
+    const Attribute* getAttribute (int index) const noexcept    { return &attributes.getReference (index); }
 
     //==============================================================================
-    /** */
+    /** Sets the colour of a range of characters.
+        Any colour previously applied to this range is replaced; fonts are unaffected.
+    */
     void setColour (const Range<int>& range, const Colour& colour);
 
-    /** */
+    /** Sets the font of a range of characters.
+        Any font previously applied to this range is replaced; colours are unaffected.
+    */
     void setFont (const Range<int>& range, const Font& font);
 
     //==============================================================================
     /** */
     void draw (Graphics& g, const Rectangle<int>& area);
 
-    /** */
-    static void drawMultiple (Graphics& g, const Rectangle<int>& area, const AttributedString* const* strings, int numStrings);
+    /** Draws a list of strings as paragraphs, one below the other.
+
+        If a ThreadPool is supplied, the paragraphs are laid out in parallel on its threads
+        (see layoutMultiple()) before being drawn.
+    */
+    static void drawMultiple (Graphics& g, const Rectangle<int>& area, const AttributedString* const* strings, int numStrings,
+                              ThreadPool* threadPool = nullptr);
+
+    /** Draws a list of strings as paragraphs in the same way as drawMultiple(), but only if the
+        graphics context has its own text layout engine (e.g. CoreText on the Mac).
+
+        If it doesn't, nothing is drawn and this returns false, so that the caller can draw
+        GlyphLayouts it has already made with layoutMultiple() instead.
+    */
+    static bool drawMultipleNatively (Graphics& g, const Rectangle<int>& area, const AttributedString* const* strings, int numStrings);
+
+    /** Creates a layout for each of a list of strings, stacked vertically in the same way
+        that drawMultiple() would draw them.
+
+        Strings that are empty or that would start below the bottom of the area are skipped.
+        The layouts are appended to the given array, and can be kept and drawn repeatedly.
+
+        If a ThreadPool is supplied, batches of paragraphs are laid out in parallel by its
+        threads and the calling thread, and are then stacked in order. The strings must not
+        be modified until this method returns.
+    */
+    static void layoutMultiple (OwnedArray<GlyphLayout>& layouts, const Rectangle<int>& area,
+                                const AttributedString* const* strings, int numStrings,
+                                ThreadPool* threadPool = nullptr);
+
+    //==============================================================================
+    /** The size that a string takes up once it has been word-wrapped to a particular width.
+        @see measure
+    */
+    class JUCE_API  Measurement
+    {
+    public:
+        Measurement() noexcept : height (0) {}
+
+        /** The height of the text, as GlyphLayout::getTextHeight() would return it. */
+        float height;
+        /** The width of each line, from its origin to the end of its last glyph. */
+        Array<float> lineWidths;
+
+        /** */
+        int getNumLines() const noexcept                        { return lineWidths.size(); }
+    };
+
+    /** Works out how big the string will be when it's laid out at the given width.
+
+        Where possible this only breaks the text into lines without creating any glyphs,
+        so it's much cheaper than a GlyphLayout when only the size is needed.
+    */
+    Measurement measure (float width) const;
 
 private:
     String text;
@@ -147,7 +220,9 @@ private:
     TextAlignment textAlignment;
     WordWrap wordWrap;
     ReadingDirection readingDirection;
-    OwnedArray<Attribute> attributes;
+    Array<Attribute> attributes;
+
+    void applyAttribute (const Attribute&);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AttributedString);
 };
@@ -49,13 +49,15 @@ public:
         kerningPairs.add (kp);
     }
 
-    float getHorizontalSpacing (const juce_wchar subsequentCharacter) const noexcept
+    float getHorizontalSpacing (const juce_wchar subsequentCharacter, CustomTypeface& typeface) const
     {
         if (subsequentCharacter != 0)
         {
             for (int i = kerningPairs.size(); --i >= 0;)
                 if (kerningPairs.getReference(i).character2 == subsequentCharacter)
                     return width + kerningPairs.getReference(i).kerningAmount;
+
+            return width + typeface.getKerningForPair (character, subsequentCharacter);
         }
 
         return width;
@@ -88,6 +90,23 @@ namespace CustomTypefaceHelpers
         return (juce_wchar) n;
     }
 
+    enum { coverageRange = 0x10000 };
+
+    bool isInCoverageRange (const juce_wchar character) noexcept
+    {
+        return isPositiveAndBelow ((int) character, (int) coverageRange);
+    }
+
+    bool getCoverageBit (const uint32* const bits, const juce_wchar character) noexcept
+    {
+        return ((bits [character >> 5] >> (character & 31)) & 1) != 0;
+    }
+
+    void setCoverageBit (uint32* const bits, const juce_wchar character) noexcept
+    {
+        bits [character >> 5] |= (uint32) 1 << (character & 31);
+    }
+
     void writeChar (OutputStream& out, juce_wchar charToWrite)
     {
         if (charToWrite >= 0x10000)
@@ -103,6 +122,260 @@ namespace CustomTypefaceHelpers
     }
 }
 
+//==============================================================================
+/*  The glyph-store format is a little-endian header, followed by a table of the glyphs sorted
+    by character, a table of the kerning pairs sorted by their first and second characters,
+    and then the outlines, each stored in the format that Path::writePathToStream() uses.
+    The tables have fixed-size entries, so a glyph can be found with a binary search and
+    only its own outline needs to be decoded.
+*/
+class CustomTypeface::GlyphStore
+{
+public:
+    GlyphStore (const void* data_, const size_t dataSize_, MemoryMappedFile* mappedFile_)
+        : mappedFile (mappedFile_),
+          data (static_cast <const uint8*> (data_)),
+          dataSize (dataSize_),
+          glyphTable (nullptr),
+          kerningTable (nullptr),
+          numGlyphs (0),
+          numKerningPairs (0)
+    {
+        if (data != nullptr && dataSize >= (size_t) headerSize
+             && readInt (data) == (int) fileMagic)
+        {
+            const int nameSize = readInt (data + 24);
+            const int glyphs = readInt (data + 4);
+            const int kerningPairs = readInt (data + 8);
+
+            // (The sizes are compared with what's left of the data rather than added up, so
+            // that a corrupt header can't make them wrap around)
+            if (nameSize >= 0 && glyphs >= 0 && kerningPairs >= 0
+                 && (size_t) nameSize <= dataSize - (size_t) headerSize)
+            {
+                const size_t tablesStart = (size_t) headerSize + (((size_t) nameSize + 3) & ~(size_t) 3);
+
+                if (tablesStart <= dataSize
+                     && (size_t) glyphs <= (dataSize - tablesStart) / (size_t) glyphEntrySize
+                     && (size_t) kerningPairs <= (dataSize - tablesStart - glyphs * (size_t) glyphEntrySize)
+                                                    / (size_t) kerningEntrySize)
+                {
+                    numGlyphs = glyphs;
+                    numKerningPairs = kerningPairs;
+                    glyphTable = data + tablesStart;
+                    kerningTable = glyphTable + numGlyphs * glyphEntrySize;
+                }
+            }
+        }
+    }
+
+    enum
+    {
+        fileMagic = 0x3173676a,  // "jgs1"
+        headerSize = 28,
+        glyphEntrySize = 16,
+        kerningEntrySize = 12,
+        boldFlag = 1,
+        italicFlag = 2
+    };
+
+    bool isValid() const noexcept               { return glyphTable != nullptr; }
+    int getNumGlyphs() const noexcept           { return numGlyphs; }
+
+    void loadCharacteristics (CustomTypeface& typeface) const
+    {
+        const int flags = readInt (data + 20);
+
+        typeface.setCharacteristics (String::fromUTF8 ((const char*) data + headerSize, readInt (data + 24)),
+                                     readFloat (data + 12),
+                                     (flags & boldFlag) != 0, (flags & italicFlag) != 0,
+                                     (juce_wchar) readInt (data + 16));
+    }
+
+    juce_wchar getCharacter (const int index) const noexcept
+    {
+        return (juce_wchar) readInt (glyphTable + index * glyphEntrySize);
+    }
+
+    /** Decodes a glyph and its kerning pairs, and adds them to the typeface. */
+    bool loadGlyph (CustomTypeface& typeface, const juce_wchar character) const
+    {
+        int start = 0, end = numGlyphs;
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if ((uint32) getCharacter (mid) < (uint32) character)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        if (start >= numGlyphs || getCharacter (start) != character)
+            return false;
+
+        const uint8* const entry = glyphTable + start * glyphEntrySize;
+        const int pathStart = readInt (entry + 8);
+        const int pathSize  = readInt (entry + 12);
+
+        Path path;
+
+        if (pathStart >= 0 && pathSize >= 0 && (size_t) pathStart <= dataSize
+             && (size_t) pathSize <= dataSize - (size_t) pathStart)
+            path.loadPathFromData (data + pathStart, (size_t) pathSize);
+
+        typeface.addGlyph (character, path, readFloat (entry + 4));
+
+        for (int i = findFirstKerningPair (character); i < numKerningPairs; ++i)
+        {
+            const uint8* const pair = kerningTable + i * kerningEntrySize;
+
+            if ((juce_wchar) readInt (pair) != character)
+                break;
+
+            typeface.addKerningPair (character, (juce_wchar) readInt (pair + 4), readFloat (pair + 8));
+        }
+
+        return true;
+    }
+
+    static void write (OutputStream& out, const CustomTypeface& typeface)
+    {
+        Array <const GlyphInfo*> sortedGlyphs;
+        int i, numPairs = 0;
+
+        for (i = 0; i < typeface.glyphs.size(); ++i)
+        {
+            const GlyphInfo* const g = typeface.glyphs.getUnchecked (i);
+            sortedGlyphs.add (g);
+            numPairs += g->kerningPairs.size();
+        }
+
+        GlyphCharacterComparator glyphComparator;
+        sortedGlyphs.sort (glyphComparator, true);
+
+        const MemoryBlock name (typeface.name.toUTF8(), typeface.name.getNumBytesAsUTF8());
+
+        out.writeInt ((int) fileMagic);
+        out.writeInt (sortedGlyphs.size());
+        out.writeInt (numPairs);
+        out.writeFloat (typeface.ascent);
+        out.writeInt ((int) typeface.defaultCharacter);
+        out.writeInt ((typeface.isBold ? boldFlag : 0) | (typeface.isItalic ? italicFlag : 0));
+        out.writeInt ((int) name.getSize());
+        out.write (name.getData(), (int) name.getSize());
+        writePadding (out, (int) name.getSize());
+
+        Array <MemoryBlock> paths;
+        int pathStart = headerSize + paddedSize ((int) name.getSize())
+                          + sortedGlyphs.size() * glyphEntrySize + numPairs * kerningEntrySize;
+
+        for (i = 0; i < sortedGlyphs.size(); ++i)
+        {
+            const GlyphInfo* const g = sortedGlyphs.getUnchecked (i);
+
+            MemoryOutputStream pathData;
+            g->path.writePathToStream (pathData);
+            paths.add (pathData.getMemoryBlock());
+
+            out.writeInt ((int) g->character);
+            out.writeFloat (g->width);
+            out.writeInt (pathStart);
+            out.writeInt ((int) pathData.getDataSize());
+
+            pathStart += (int) pathData.getDataSize();
+        }
+
+        for (i = 0; i < sortedGlyphs.size(); ++i)
+        {
+            const GlyphInfo* const g = sortedGlyphs.getUnchecked (i);
+            Array <GlyphInfo::KerningPair> pairs (g->kerningPairs);
+
+            KerningPairComparator pairComparator;
+            pairs.sort (pairComparator, true);
+
+            for (int j = 0; j < pairs.size(); ++j)
+            {
+                out.writeInt ((int) g->character);
+                out.writeInt ((int) pairs.getReference (j).character2);
+                out.writeFloat (pairs.getReference (j).kerningAmount);
+            }
+        }
+
+        for (i = 0; i < paths.size(); ++i)
+            out.write (paths.getReference (i).getData(), (int) paths.getReference (i).getSize());
+    }
+
+private:
+    ScopedPointer<MemoryMappedFile> mappedFile;
+    const uint8* const data;
+    const size_t dataSize;
+    const uint8* glyphTable;
+    const uint8* kerningTable;
+    int numGlyphs, numKerningPairs;
+
+    static int readInt (const uint8* const p) noexcept
+    {
+        return (int) ByteOrder::littleEndianInt (p);
+    }
+
+    static float readFloat (const uint8* const p) noexcept
+    {
+        union { int asInt; float asFloat; } n;
+        n.asInt = readInt (p);
+        return n.asFloat;
+    }
+
+    static int paddedSize (const int size) noexcept     { return (size + 3) & ~3; }
+
+    static int compareCharacters (const juce_wchar c1, const juce_wchar c2) noexcept
+    {
+        return (uint32) c1 < (uint32) c2 ? -1 : ((uint32) c1 > (uint32) c2 ? 1 : 0);
+    }
+
+    struct GlyphCharacterComparator
+    {
+        static int compareElements (const GlyphInfo* const g1, const GlyphInfo* const g2) noexcept
+        {
+            return compareCharacters (g1->character, g2->character);
+        }
+    };
+
+    struct KerningPairComparator
+    {
+        static int compareElements (const GlyphInfo::KerningPair& p1, const GlyphInfo::KerningPair& p2) noexcept
+        {
+            return compareCharacters (p1.character2, p2.character2);
+        }
+    };
+
+    static void writePadding (OutputStream& out, const int size)
+    {
+        for (int i = paddedSize (size) - size; --i >= 0;)
+            out.writeByte (0);
+    }
+
+    int findFirstKerningPair (const juce_wchar character) const noexcept
+    {
+        int start = 0, end = numKerningPairs;
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if ((uint32) readInt (kerningTable + mid * kerningEntrySize) < (uint32) character)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return start;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (GlyphStore);
+};
+
 //==============================================================================
 CustomTypeface::CustomTypeface()
     : Typeface (String::empty)
@@ -147,18 +420,65 @@ CustomTypeface::CustomTypeface (InputStream& serialisedTypefaceStream)
     }
 }
 
+CustomTypeface::CustomTypeface (const File& glyphStoreFile)
+    : Typeface (String::empty)
+{
+    clear();
+
+    MemoryMappedFile* const mappedFile = new MemoryMappedFile (glyphStoreFile, MemoryMappedFile::readOnly);
+    loadGlyphStore (mappedFile->getData(), mappedFile->getSize(), mappedFile);
+}
+
+CustomTypeface::CustomTypeface (const void* glyphStoreData, size_t glyphStoreSize)
+    : Typeface (String::empty)
+{
+    clear();
+    loadGlyphStore (glyphStoreData, glyphStoreSize, nullptr);
+}
+
 CustomTypeface::~CustomTypeface()
 {
 }
 
+void CustomTypeface::loadGlyphStore (const void* data, size_t size, MemoryMappedFile* mappedFile)
+{
+    ScopedPointer<GlyphStore> store (new GlyphStore (data, size, mappedFile));
+
+    // this data wasn't written by writeToGlyphStore()!
+    jassert (store->isValid());
+
+    if (store->isValid())
+    {
+        store->loadCharacteristics (*this);
+        glyphStore = store;
+    }
+}
+
+void CustomTypeface::loadAllGlyphsFromStore()
+{
+    const ScopedWriteLock sl (lock);
+
+    if (glyphStore != nullptr)
+    {
+        for (int i = 0; i < glyphStore->getNumGlyphs(); ++i)
+            findGlyph (glyphStore->getCharacter (i), true);
+    }
+}
+
 //==============================================================================
 void CustomTypeface::clear()
 {
+    const ScopedWriteLock sl (lock);
+
     defaultCharacter = 0;
     ascent = 1.0f;
     isBold = isItalic = false;
     zeromem (lookupTable, sizeof (lookupTable));
     glyphs.clear();
+    glyphStore = nullptr;
+    coveredCharacters.calloc (CustomTypefaceHelpers::coverageRange / 32);
+    missingCharacters.calloc (CustomTypefaceHelpers::coverageRange / 32);
+    resetAdvanceTable();
 }
 
 void CustomTypeface::setCharacteristics (const String& name_, const float ascent_, const bool isBold_,
@@ -173,6 +493,8 @@ void CustomTypeface::setCharacteristics (const String& name_, const float ascent
 
 void CustomTypeface::addGlyph (const juce_wchar character, const Path& path, const float width) noexcept
 {
+    const ScopedWriteLock sl (lock);
+
     // Check that you're not trying to add the same character twice..
     jassert (findGlyph (character, false) == nullptr);
 
@@ -180,17 +502,27 @@ void CustomTypeface::addGlyph (const juce_wchar character, const Path& path, con
         lookupTable [character] = (short) glyphs.size();
 
     glyphs.add (new GlyphInfo (character, path, width));
+
+    if (CustomTypefaceHelpers::isInCoverageRange (character))
+        CustomTypefaceHelpers::setCoverageBit (coveredCharacters, character);
+
+    if (AdvanceTable::contains (character))
+        resetAdvanceTable();
 }
 
 void CustomTypeface::addKerningPair (const juce_wchar char1, const juce_wchar char2, const float extraAmount) noexcept
 {
     if (extraAmount != 0)
     {
+        const ScopedWriteLock sl (lock);
         GlyphInfo* const g = findGlyph (char1, true);
         jassert (g != nullptr); // can only add kerning pairs for characters that exist!
 
         if (g != nullptr)
             g->addKerningPair (char2, extraAmount);
+
+        if (AdvanceTable::contains (char1) && AdvanceTable::contains (char2))
+            resetAdvanceTable();
     }
 }
 
@@ -199,22 +531,187 @@ CustomTypeface::GlyphInfo* CustomTypeface::findGlyph (const juce_wchar character
     if (isPositiveAndBelow ((int) character, (int) numElementsInArray (lookupTable)) && lookupTable [character] > 0)
         return glyphs [(int) lookupTable [(int) character]];
 
-    for (int i = 0; i < glyphs.size(); ++i)
+    const bool isInCoverageRange = CustomTypefaceHelpers::isInCoverageRange (character);
+
+    // (there's no need to search for characters that haven't been added)
+    if (! isInCoverageRange || CustomTypefaceHelpers::getCoverageBit (coveredCharacters, character))
     {
-        GlyphInfo* const g = glyphs.getUnchecked(i);
-        if (g->character == character)
-            return g;
+        for (int i = 0; i < glyphs.size(); ++i)
+        {
+            GlyphInfo* const g = glyphs.getUnchecked(i);
+            if (g->character == character)
+                return g;
+        }
     }
 
-    if (loadIfNeeded && loadGlyphIfPossible (character))
-        return findGlyph (character, false);
+    if (loadIfNeeded && ! isKnownToBeMissing (character))
+    {
+        if (loadGlyphIfPossible (character))
+            return findGlyph (character, false);
+
+        // remember that it's missing, so that text which needs a fallback doesn't keep trying to load it
+        if (isInCoverageRange)
+            CustomTypefaceHelpers::setCoverageBit (missingCharacters, character);
+    }
 
     return nullptr;
 }
 
-bool CustomTypeface::loadGlyphIfPossible (const juce_wchar /*characterNeeded*/)
+bool CustomTypeface::isKnownToBeMissing (const juce_wchar character) const noexcept
 {
-    return false;
+    return CustomTypefaceHelpers::isInCoverageRange (character)
+            && CustomTypefaceHelpers::getCoverageBit (missingCharacters, character);
+}
+
+// Glyphs are never changed or deleted once they've been added (other than by clear()), so a
+// pointer to one can still be used after the lock has been released.
+CustomTypeface::GlyphInfo* CustomTypeface::findOrLoadGlyph (const juce_wchar character) noexcept
+{
+    {
+        const ScopedReadLock sl (lock);
+        GlyphInfo* const g = findGlyph (character, false);
+
+        if (g != nullptr || isKnownToBeMissing (character))
+            return g;
+    }
+
+    const ScopedWriteLock sl (lock);
+    return findGlyph (character, true);
+}
+
+void CustomTypeface::loadGlyphsIfNeeded (const String& text)
+{
+    {
+        const ScopedReadLock sl (lock);
+        String::CharPointerType t (text.getCharPointer());
+
+        while (! t.isEmpty() && (findGlyph (*t, false) != nullptr || isKnownToBeMissing (*t)))
+            ++t;
+
+        if (t.isEmpty())
+            return;
+    }
+
+    // A read lock can't be upgraded without risking a deadlock with another reader, so
+    // the missing glyphs are loaded with a separate write lock.
+    const ScopedWriteLock sl (lock);
+
+    for (String::CharPointerType t (text.getCharPointer()); ! t.isEmpty();)
+        findGlyph (t.getAndAdvance(), true);
+}
+
+bool CustomTypeface::loadGlyphIfPossible (const juce_wchar characterNeeded)
+{
+    return glyphStore != nullptr && glyphStore->loadGlyph (*this, characterNeeded);
+}
+
+float CustomTypeface::getKerningForPair (const juce_wchar /*char1*/, const juce_wchar /*char2*/)
+{
+    return 0;
+}
+
+bool CustomTypeface::hasGlyph (const juce_wchar character)
+{
+    return findOrLoadGlyph (character) != nullptr;
+}
+
+//==============================================================================
+void CustomTypeface::setFallbackFontNames (const StringArray& names)
+{
+    const ScopedLock sl (fallbackLock);
+    fallbackNames = names;
+    fallbackTypefaces.clear();
+}
+
+// The fallbackLock isn't held while the fallbacks are searched, because a fallback may need
+// to look through its own fallbacks, which could include this typeface.
+Typeface::Ptr CustomTypeface::getFallbackTypefaceFor (const juce_wchar character)
+{
+    bool hasFallbackNames;
+
+    {
+        const ScopedLock sl (fallbackLock);
+        hasFallbackNames = fallbackNames.size() > 0;
+    }
+
+    if (! hasFallbackNames)
+    {
+        const Typeface::Ptr fallbackTypeface (Typeface::getFallbackTypeface());
+        return fallbackTypeface != this ? fallbackTypeface : nullptr;
+    }
+
+    for (int i = 0;; ++i)
+    {
+        const Typeface::Ptr t (getFallbackTypefaceAt (i));
+
+        if (t == nullptr)
+            return nullptr;
+
+        if (t != this && t->hasGlyph (character))
+            return t;
+    }
+}
+
+Typeface::Ptr CustomTypeface::getFallbackTypefaceAt (const int index)
+{
+    const ScopedLock sl (fallbackLock);
+
+    if (index >= fallbackNames.size())
+        return nullptr;
+
+    // (the typefaces are only created when they're first needed)
+    while (fallbackTypefaces.size() <= index)
+        fallbackTypefaces.add (Font (fallbackNames [fallbackTypefaces.size()], 10.0f,
+                                     (isBold ? Font::bold : 0) | (isItalic ? Font::italic : 0)).getTypeface());
+
+    return fallbackTypefaces.getUnchecked (index);
+}
+
+/*  Finds the glyph for each character of a string, and the distance from it to the next one,
+    with a zero glyph for each character that has to be taken from a fallback typeface.
+
+    Only this part of measuring a string is done with the lock held. The fallbacks are found and
+    measured without it, because they may need the locks of other typefaces that are themselves
+    waiting for this one's.
+*/
+void CustomTypeface::findGlyphsForText (const String& text, Array<juce_wchar>& textGlyphs,
+                                        Array<float>& advances)
+{
+    loadGlyphsIfNeeded (text);
+
+    const ScopedReadLock sl (lock);
+
+    for (String::CharPointerType t (text.getCharPointer()); ! t.isEmpty();)
+    {
+        const GlyphInfo* const glyph = findGlyph (*t, false);
+        ++t;
+
+        textGlyphs.add (glyph != nullptr ? glyph->character : 0);
+        advances.add (glyph != nullptr ? glyph->getHorizontalSpacing (*t, *this) : 0.0f);
+    }
+}
+
+/*  Finds the end of a run of characters that are missing from this typeface, but which can all
+    be taken from the same fallback typeface, so that the run can be measured in one call.
+    The first character is always included, even if the fallback doesn't have it.
+*/
+int CustomTypeface::findEndOfFallbackRun (const Array<juce_wchar>& textGlyphs, int index,
+                                          String::CharPointerType& t, Typeface* const fallbackTypeface)
+{
+    ++index;
+    ++t;
+
+    if (fallbackTypeface != nullptr)
+    {
+        while (index < textGlyphs.size() && textGlyphs.getUnchecked (index) == 0
+                && fallbackTypeface->hasGlyph (*t))
+        {
+            ++index;
+            ++t;
+        }
+    }
+
+    return index;
 }
 
 void CustomTypeface::addGlyphsFromOtherTypeface (Typeface& typefaceToCopy, juce_wchar characterStartIndex, int numCharacters) noexcept
@@ -256,6 +753,9 @@ void CustomTypeface::addGlyphsFromOtherTypeface (Typeface& typefaceToCopy, juce_
 
 bool CustomTypeface::writeToStream (OutputStream& outputStream)
 {
+    loadAllGlyphsFromStore();
+
+    const ScopedReadLock sl (lock);
     GZIPCompressorOutputStream out (&outputStream);
 
     out.writeString (name);
@@ -295,6 +795,15 @@ bool CustomTypeface::writeToStream (OutputStream& outputStream)
     return true;
 }
 
+bool CustomTypeface::writeToGlyphStore (OutputStream& outputStream)
+{
+    loadAllGlyphsFromStore();
+
+    const ScopedReadLock sl (lock);
+    GlyphStore::write (outputStream, *this);
+    return true;
+}
+
 //==============================================================================
 float CustomTypeface::getAscent() const
 {
@@ -308,24 +817,29 @@ float CustomTypeface::getDescent() const
 
 float CustomTypeface::getStringWidth (const String& text)
 {
+    Array<juce_wchar> textGlyphs;
+    Array<float> advances;
+    findGlyphsForText (text, textGlyphs, advances);
+
     float x = 0;
     String::CharPointerType t (text.getCharPointer());
 
-    while (! t.isEmpty())
+    for (int i = 0; i < textGlyphs.size();)
     {
-        const juce_wchar c = t.getAndAdvance();
-        const GlyphInfo* const glyph = findGlyph (c, true);
-
-        if (glyph == nullptr)
+        if (textGlyphs.getUnchecked (i) == 0)
         {
-            const Typeface::Ptr fallbackTypeface (Typeface::getFallbackTypeface());
+            const String::CharPointerType runStart (t);
+            const Typeface::Ptr fallbackTypeface (getFallbackTypefaceFor (*t));
+            i = findEndOfFallbackRun (textGlyphs, i, t, fallbackTypeface);
 
-            if (fallbackTypeface != nullptr && fallbackTypeface != this)
-                x += fallbackTypeface->getStringWidth (String::charToString (c));
+            if (fallbackTypeface != nullptr)
+                x += fallbackTypeface->getStringWidth (String (runStart, t));
+        }
+        else
+        {
+            x += advances.getUnchecked (i++);
+            ++t;
         }
-
-        if (glyph != nullptr)
-            x += glyph->getHorizontalSpacing (*t);
     }
 
     return x;
@@ -333,38 +847,44 @@ float CustomTypeface::getStringWidth (const String& text)
 
 void CustomTypeface::getGlyphPositions (const String& text, Array <int>& resultGlyphs, Array<float>& xOffsets)
 {
+    Array<juce_wchar> textGlyphs;
+    Array<float> advances;
+    findGlyphsForText (text, textGlyphs, advances);
+
     xOffsets.add (0);
     float x = 0;
     String::CharPointerType t (text.getCharPointer());
 
-    while (! t.isEmpty())
+    for (int i = 0; i < textGlyphs.size();)
     {
-        const juce_wchar c = t.getAndAdvance();
-        const GlyphInfo* const glyph = findGlyph (c, true);
+        const juce_wchar glyph = textGlyphs.getUnchecked (i);
 
-        if (glyph == nullptr)
+        if (glyph == 0)
         {
-            const Typeface::Ptr fallbackTypeface (Typeface::getFallbackTypeface());
+            // A run of characters that this typeface doesn't have is measured with one call to its fallback
+            const String::CharPointerType runStart (t);
+            const Typeface::Ptr fallbackTypeface (getFallbackTypefaceFor (*t));
+            i = findEndOfFallbackRun (textGlyphs, i, t, fallbackTypeface);
 
-            if (fallbackTypeface != nullptr && fallbackTypeface != this)
+            if (fallbackTypeface != nullptr)
             {
                 Array <int> subGlyphs;
                 Array <float> subOffsets;
-                fallbackTypeface->getGlyphPositions (String::charToString (c), subGlyphs, subOffsets);
+                fallbackTypeface->getGlyphPositions (String (runStart, t), subGlyphs, subOffsets);
 
-                if (subGlyphs.size() > 0)
-                {
-                    resultGlyphs.add (subGlyphs.getFirst());
-                    x += subOffsets[1];
-                    xOffsets.add (x);
-                }
+                resultGlyphs.addArray (subGlyphs);
+
+                for (int j = 1; j < subOffsets.size(); ++j)
+                    xOffsets.add (x + subOffsets.getUnchecked (j));
+
+                x += subOffsets.getLast();
             }
         }
-
-        if (glyph != nullptr)
+        else
         {
-            x += glyph->getHorizontalSpacing (*t);
-            resultGlyphs.add ((int) glyph->character);
+            x += advances.getUnchecked (i++);
+            ++t;
+            resultGlyphs.add ((int) glyph);
             xOffsets.add (x);
         }
     }
@@ -372,13 +892,13 @@ void CustomTypeface::getGlyphPositions (const String& text, Array <int>& resultG
 
 bool CustomTypeface::getOutlineForGlyph (int glyphNumber, Path& path)
 {
-    const GlyphInfo* const glyph = findGlyph ((juce_wchar) glyphNumber, true);
+    const GlyphInfo* const glyph = findOrLoadGlyph ((juce_wchar) glyphNumber);
 
     if (glyph == nullptr)
     {
-        const Typeface::Ptr fallbackTypeface (Typeface::getFallbackTypeface());
+        const Typeface::Ptr fallbackTypeface (getFallbackTypefaceFor ((juce_wchar) glyphNumber));
 
-        if (fallbackTypeface != nullptr && fallbackTypeface != this)
+        if (fallbackTypeface != nullptr)
             fallbackTypeface->getOutlineForGlyph (glyphNumber, path);
     }
 
@@ -393,13 +913,13 @@ bool CustomTypeface::getOutlineForGlyph (int glyphNumber, Path& path)
 
 EdgeTable* CustomTypeface::getEdgeTableForGlyph (int glyphNumber, const AffineTransform& transform)
 {
-    const GlyphInfo* const glyph = findGlyph ((juce_wchar) glyphNumber, true);
+    const GlyphInfo* const glyph = findOrLoadGlyph ((juce_wchar) glyphNumber);
 
     if (glyph == nullptr)
     {
-        const Typeface::Ptr fallbackTypeface (Typeface::getFallbackTypeface());
+        const Typeface::Ptr fallbackTypeface (getFallbackTypefaceFor ((juce_wchar) glyphNumber));
 
-        if (fallbackTypeface != nullptr && fallbackTypeface != this)
+        if (fallbackTypeface != nullptr)
             return fallbackTypeface->getEdgeTableForGlyph (glyphNumber, transform);
     }
 
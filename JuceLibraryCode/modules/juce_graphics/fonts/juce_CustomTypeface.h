@@ -56,6 +56,21 @@ public:
     */
     explicit CustomTypeface (InputStream& serialisedTypefaceStream);
 
+    /** Loads a typeface from a file that was written by writeToGlyphStore().
+
+        The file is memory-mapped rather than read in, and each glyph's outline and kerning
+        pairs are only decoded the first time that the glyph is needed.
+        @see writeToGlyphStore
+    */
+    explicit CustomTypeface (const File& glyphStoreFile);
+
+    /** Loads a typeface from a block of data that was written by writeToGlyphStore(), e.g. a
+        font that has been embedded in the app's binary data.
+        The data isn't copied, so it must stay valid for as long as the typeface exists.
+        @see writeToGlyphStore
+    */
+    CustomTypeface (const void* glyphStoreData, size_t glyphStoreSize);
+
     /** Destructor. */
     ~CustomTypeface();
 
@@ -104,6 +119,13 @@ public:
     */
     bool writeToStream (OutputStream& outputStream);
 
+    /** Saves this typeface as an uncompressed glyph store.
+        This format is larger than the one that writeToStream() produces, but it can be loaded
+        without parsing all of its glyphs - see the CustomTypeface constructors that take a File
+        or a block of data.
+    */
+    bool writeToGlyphStore (OutputStream& outputStream);
+
     //==============================================================================
     // The following methods implement the basic Typeface behaviour.
     float getAscent() const;
@@ -112,6 +134,7 @@ public:
     void getGlyphPositions (const String& text, Array <int>& glyphs, Array<float>& xOffsets);
     bool getOutlineForGlyph (int glyphNumber, Path& path);
     EdgeTable* getEdgeTableForGlyph (int glyphNumber, const AffineTransform& transform);
+    bool hasGlyph (juce_wchar character);
 
 protected:
     //==============================================================================
@@ -128,14 +151,49 @@ protected:
     */
     virtual bool loadGlyphIfPossible (juce_wchar characterNeeded);
 
+    /** If a subclass overrides this, it can supply the kerning between two characters when
+        it's first needed, rather than adding every pair in advance with addKerningPair().
+        It's only called for pairs that haven't had a kerning pair added, and should return
+        the extra amount in the same units that addKerningPair() uses. The default returns 0.
+    */
+    virtual float getKerningForPair (juce_wchar char1, juce_wchar char2);
+
+    /** Sets the typefaces to take glyphs from, in order, for characters that this one doesn't contain.
+        If the list is empty, the global fallback font is used.
+        @see Font::setFallbackFontNames
+    */
+    void setFallbackFontNames (const StringArray& names);
+
 private:
     //==============================================================================
     class GlyphInfo;
     friend class OwnedArray<GlyphInfo>;
     OwnedArray <GlyphInfo> glyphs;
     short lookupTable [128];
+    ReadWriteLock lock;
+
+    class GlyphStore;
+    friend class ScopedPointer<GlyphStore>;
+    ScopedPointer<GlyphStore> glyphStore;
+
+    // One bit for each character in the basic multilingual plane, for the characters that have
+    // been added, and the ones that have been found to be missing.
+    HeapBlock<uint32> coveredCharacters, missingCharacters;
+
+    StringArray fallbackNames;
+    Array<Typeface::Ptr> fallbackTypefaces;
+    CriticalSection fallbackLock;
 
     GlyphInfo* findGlyph (const juce_wchar character, bool loadIfNeeded) noexcept;
+    GlyphInfo* findOrLoadGlyph (juce_wchar character) noexcept;
+    bool isKnownToBeMissing (juce_wchar character) const noexcept;
+    Typeface::Ptr getFallbackTypefaceFor (juce_wchar character);
+    Typeface::Ptr getFallbackTypefaceAt (int index);
+    void findGlyphsForText (const String& text, Array<juce_wchar>& textGlyphs, Array<float>& advances);
+    int findEndOfFallbackRun (const Array<juce_wchar>& textGlyphs, int index, String::CharPointerType& t, Typeface*);
+    void loadGlyphsIfNeeded (const String& text);
+    void loadGlyphStore (const void* data, size_t size, MemoryMappedFile* mappedFile);
+    void loadAllGlyphsFromStore();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CustomTypeface);
 };
@@ -45,9 +45,9 @@ class TypefaceCache  : public DeletedAtShutdown
 {
 public:
     TypefaceCache()
-        : counter (0)
+        : maxFaces (10),
+          counter (0)
     {
-        setSize (10);
     }
 
     ~TypefaceCache()
@@ -55,95 +55,156 @@ public:
         clearSingletonInstance();
     }
 
-    juce_DeclareSingleton_SingleThreaded_Minimal (TypefaceCache);
+    juce_DeclareSingleton (TypefaceCache, false);
 
     void setSize (const int numToCache)
     {
+        const ScopedLock sl (creationLock);
+        const SpinLock::ScopedLockType fl (facesLock);
         faces.clear();
-        faces.insertMultiple (-1, CachedFace(), numToCache);
+        cachedFaces.clear();
+        maxFaces = jmax (1, numToCache);
     }
 
     Typeface::Ptr findTypefaceFor (const Font& font)
     {
-        const int flags = font.getStyleFlags() & (Font::bold | Font::italic);
-        const String faceName (font.getTypefaceName());
+        const Key key (font.getTypefaceName(), font.getStyleFlags() & (Font::bold | Font::italic),
+                       font.getFallbackFontNames());
 
-        int i;
-        for (i = faces.size(); --i >= 0;)
-        {
-            CachedFace& face = faces.getReference(i);
+        Typeface::Ptr typeface (findCachedFace (key, font));
 
-            if (face.flags == flags
-                 && face.typefaceName == faceName
-                 && face.typeface->isSuitableForFont (font))
-            {
-                face.lastUsageCount = ++counter;
-                return face.typeface;
-            }
-        }
+        if (typeface != nullptr)
+            return typeface;
 
-        int replaceIndex = 0;
-        int bestLastUsageCount = std::numeric_limits<int>::max();
+        // Only one typeface is created at a time, but other threads can carry on looking up
+        // faces that are already in the cache while it's happening.
+        const ScopedLock sl (creationLock);
 
-        for (i = faces.size(); --i >= 0;)
-        {
-            const int lu = faces.getReference(i).lastUsageCount;
+        // another thread may have added it while we were waiting..
+        typeface = findCachedFace (key, font);
+
+        if (typeface != nullptr)
+            return typeface;
+
+        if (juce_getTypefaceForFont == nullptr)
+            typeface = Font::getDefaultTypefaceForFont (font);
+        else
+            typeface = juce_getTypefaceForFont (font);
+
+        jassert (typeface != nullptr); // the look and feel must return a typeface!
+
+        const bool isDefaultFont = (font == Font());
+        const SpinLock::ScopedLockType fl (facesLock);
+        CachedFace* face = faces [key];
 
-            if (bestLastUsageCount > lu)
+        if (face == nullptr)
+        {
+            if (cachedFaces.size() < maxFaces)
             {
-                bestLastUsageCount = lu;
-                replaceIndex = i;
+                face = new CachedFace();
+                cachedFaces.add (face);
             }
-        }
+            else
+            {
+                face = cachedFaces.getUnchecked (0);
 
-        CachedFace& face = faces.getReference (replaceIndex);
-        face.typefaceName = faceName;
-        face.flags = flags;
-        face.lastUsageCount = ++counter;
+                for (int i = cachedFaces.size(); --i > 0;)
+                    if (cachedFaces.getUnchecked(i)->lastUsageCount < face->lastUsageCount)
+                        face = cachedFaces.getUnchecked(i);
 
-        if (juce_getTypefaceForFont == nullptr)
-            face.typeface = Font::getDefaultTypefaceForFont (font);
-        else
-            face.typeface = juce_getTypefaceForFont (font);
+                faces.remove (face->key);
+            }
 
-        jassert (face.typeface != nullptr); // the look and feel must return a typeface!
+            face->key = key;
+            faces.set (key, face);
+        }
 
-        if (defaultFace == nullptr && font == Font())
-            defaultFace = face.typeface;
+        face->lastUsageCount = ++counter;
+        face->typeface = typeface;
 
-        return face.typeface;
+        if (defaultFace == nullptr && isDefaultFont)
+            defaultFace = typeface;
+
+        return typeface;
     }
 
     Typeface::Ptr getDefaultTypeface() const noexcept
     {
+        const SpinLock::ScopedLockType fl (facesLock);
         return defaultFace;
     }
 
 private:
-    struct CachedFace
+    struct Key
     {
-        CachedFace() noexcept
-            : lastUsageCount (0), flags (-1)
+        Key() noexcept : flags (-1) {}
+
+        Key (const String& typefaceName_, const int flags_, const StringArray& fallbackNames_) noexcept
+            : typefaceName (typefaceName_), fallbackNames (fallbackNames_), flags (flags_)
         {
         }
 
+        bool operator== (const Key& other) const noexcept
+        {
+            // Most fonts share the same few name strings, so the characters rarely need comparing.
+            return flags == other.flags
+                    && (typefaceName.getCharPointer() == other.typefaceName.getCharPointer()
+                         || typefaceName == other.typefaceName)
+                    && fallbackNames == other.fallbackNames;
+        }
+
         // Although it seems a bit wacky to store the name here, it's because it may be a
         // placeholder rather than a real one, e.g. "<Sans-Serif>" vs the actual typeface name.
         // Since the typeface itself doesn't know that it may have this alias, the name under
         // which it was fetched needs to be stored separately.
         String typefaceName;
-        int lastUsageCount, flags;
+        StringArray fallbackNames;  // a typeface may use the font's fallback list, so fonts with different lists need their own
+        int flags;
+    };
+
+    struct KeyHashFunction
+    {
+        static int generateHash (const Key& key, const int upperLimit) noexcept
+        {
+            return (int) (((uint32) key.typefaceName.hashCode() * 31 + (uint32) key.flags) % (uint32) upperLimit);
+        }
+    };
+
+    struct CachedFace
+    {
+        CachedFace() noexcept : lastUsageCount (0) {}
+
+        Key key;
+        int lastUsageCount;
         Typeface::Ptr typeface;
+
+        JUCE_DECLARE_NON_COPYABLE (CachedFace);
     };
 
-    Array <CachedFace> faces;
+    HashMap<Key, CachedFace*, KeyHashFunction> faces;
+    OwnedArray<CachedFace> cachedFaces;
     Typeface::Ptr defaultFace;
-    int counter;
+    int maxFaces, counter;
+    SpinLock facesLock;
+    CriticalSection creationLock;
+
+    Typeface::Ptr findCachedFace (const Key& key, const Font& font)
+    {
+        // The lock is only held for the hash lookup, never while a typeface is being created.
+        const SpinLock::ScopedLockType fl (facesLock);
+        CachedFace* const face = faces [key];
+
+        if (face == nullptr || ! face->typeface->isSuitableForFont (font))
+            return nullptr;
+
+        face->lastUsageCount = ++counter;
+        return face->typeface;
+    }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TypefaceCache);
 };
 
-juce_ImplementSingleton_SingleThreaded (TypefaceCache)
+juce_ImplementSingleton (TypefaceCache)
 
 void Typeface::setTypefaceCacheSize (int numFontsToCache)
 {
@@ -159,7 +220,8 @@ Font::SharedFontInternal::SharedFontInternal (const float height_, const int sty
       ascent (0),
       styleFlags (styleFlags_),
       typeface ((styleFlags_ & (Font::bold | Font::italic)) == 0
-                    ? TypefaceCache::getInstance()->getDefaultTypeface() : nullptr)
+                    ? TypefaceCache::getInstance()->getDefaultTypeface() : nullptr),
+      resolvedTypeface (typeface)
 {
 }
 
@@ -170,7 +232,8 @@ Font::SharedFontInternal::SharedFontInternal (const String& typefaceName_, const
       kerning (0),
       ascent (0),
       styleFlags (styleFlags_),
-      typeface (nullptr)
+      typeface (nullptr),
+      resolvedTypeface (nullptr)
 {
 }
 
@@ -181,18 +244,21 @@ Font::SharedFontInternal::SharedFontInternal (const Typeface::Ptr& typeface_) no
       kerning (0),
       ascent (0),
       styleFlags (Font::plain),
-      typeface (typeface_)
+      typeface (typeface_),
+      resolvedTypeface (typeface_)
 {
 }
 
 Font::SharedFontInternal::SharedFontInternal (const SharedFontInternal& other) noexcept
     : typefaceName (other.typefaceName),
+      fallbackNames (other.fallbackNames),
       height (other.height),
       horizontalScale (other.horizontalScale),
       kerning (other.kerning),
       ascent (other.ascent),
       styleFlags (other.styleFlags),
-      typeface (other.typeface)
+      typeface (other.resolvedTypeface.get()),
+      resolvedTypeface (typeface)
 {
 }
 
@@ -202,7 +268,8 @@ bool Font::SharedFontInternal::operator== (const SharedFontInternal& other) cons
             && styleFlags == other.styleFlags
             && horizontalScale == other.horizontalScale
             && kerning == other.kerning
-            && typefaceName == other.typefaceName;
+            && typefaceName == other.typefaceName
+            && fallbackNames == other.fallbackNames;
 }
 
 //==============================================================================
@@ -297,6 +364,7 @@ void Font::setTypefaceName (const String& faceName)
         dupeInternalIfShared();
         font->typefaceName = faceName;
         font->typeface = nullptr;
+        font->resolvedTypeface = nullptr;
         font->ascent = 0;
     }
 }
@@ -316,6 +384,17 @@ void Font::setFallbackFontName (const String& name)
    #endif
 }
 
+void Font::setFallbackFontNames (const StringArray& names)
+{
+    if (names != font->fallbackNames)
+    {
+        dupeInternalIfShared();
+        font->fallbackNames = names;
+        font->typeface = nullptr;
+        font->resolvedTypeface = nullptr;
+    }
+}
+
 //==============================================================================
 void Font::setHeight (float newHeight)
 {
@@ -347,6 +426,7 @@ void Font::setStyleFlags (const int newFlags)
         dupeInternalIfShared();
         font->styleFlags = newFlags;
         font->typeface = nullptr;
+        font->resolvedTypeface = nullptr;
         font->ascent = 0;
     }
 }
@@ -450,7 +530,12 @@ int Font::getStringWidth (const String& text) const
 
 float Font::getStringWidthFloat (const String& text) const
 {
-    float w = getTypeface()->getStringWidth (text);
+    Typeface* const typeface = getTypeface();
+    Typeface::AdvanceTable* const advanceTable = typeface->getAdvanceTable();
+    float w;
+
+    if (advanceTable == nullptr || ! advanceTable->getStringWidth (text, w))
+        w = typeface->getStringWidth (text);
 
     if (font->kerning != 0)
         w += font->kerning * text.length();
@@ -460,7 +545,11 @@ float Font::getStringWidthFloat (const String& text) const
 
 void Font::getGlyphPositions (const String& text, Array <int>& glyphs, Array <float>& xOffsets) const
 {
-    getTypeface()->getGlyphPositions (text, glyphs, xOffsets);
+    Typeface* const typeface = getTypeface();
+    Typeface::AdvanceTable* const advanceTable = typeface->getAdvanceTable();
+
+    if (advanceTable == nullptr || ! advanceTable->getGlyphPositions (text, glyphs, xOffsets))
+        typeface->getGlyphPositions (text, glyphs, xOffsets);
 
     const float scale = font->height * font->horizontalScale;
     const int num = xOffsets.size();
@@ -541,10 +630,22 @@ Font Font::fromString (const String& fontDescription)
 //==============================================================================
 Typeface* Font::getTypeface() const
 {
-    if (font->typeface == 0)
-        font->typeface = TypefaceCache::getInstance()->findTypefaceFor (*this);
+    Typeface* typeface = font->resolvedTypeface.get();
+
+    if (typeface == nullptr)
+    {
+        // The internal object may be shared with Fonts that are in use on other threads. Finding
+        // the typeface may mean loading it, so that's done without a lock, and if another thread
+        // publishes one first, that's the one that's kept.
+        const Typeface::Ptr newTypeface (TypefaceCache::getInstance()->findTypefaceFor (*this));
+
+        if (font->resolvedTypeface.compareAndSetBool (newTypeface, nullptr))
+            font->typeface = newTypeface;
+
+        typeface = font->resolvedTypeface.get();
+    }
 
-    return font->typeface;
+    return typeface;
 }
 
 
@@ -344,6 +344,17 @@ public:
     */
     static void setFallbackFontName (const String& name);
 
+    /** Sets a list of typefaces that this font should take glyphs from, in order, when its own
+        typeface doesn't contain them.
+        If the list is empty, the typeface named by setFallbackFontName() is used instead.
+        The list is used by typefaces that are based on CustomTypeface, such as the Linux ones.
+        @see getFallbackFontNames
+    */
+    void setFallbackFontNames (const StringArray& names);
+
+    /** Returns the list of fallback typefaces that was set with setFallbackFontNames(). */
+    const StringArray& getFallbackFontNames() const noexcept    { return font->fallbackNames; }
+
     //==============================================================================
     /** Creates a string to describe this font.
         The string will contain information to describe the font's typeface, size, and
@@ -363,7 +374,7 @@ private:
     friend class FontGlyphAlphaMap;
     friend class TypefaceCache;
 
-    class SharedFontInternal  : public SingleThreadedReferenceCountedObject
+    class SharedFontInternal  : public ReferenceCountedObject
     {
     public:
         SharedFontInternal (float height, int styleFlags) noexcept;
@@ -374,9 +385,11 @@ private:
         bool operator== (const SharedFontInternal&) const noexcept;
 
         String typefaceName;
+        StringArray fallbackNames;
         float height, horizontalScale, kerning, ascent;
         int styleFlags;
         Typeface::Ptr typeface;
+        Atomic<Typeface*> resolvedTypeface;  // published when the typeface is found, so that it can be read without a lock
     };
 
     ReferenceCountedObjectPtr <SharedFontInternal> font;
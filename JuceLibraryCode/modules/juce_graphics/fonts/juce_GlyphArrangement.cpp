@@ -288,10 +288,14 @@ void GlyphArrangement::addJustifiedText (const Font& font,
     while (lineStartIndex < glyphs.size())
     {
         int i = lineStartIndex;
+        LineBreaker lineBreaker;
 
         if (glyphs.getUnchecked(i)->getCharacter() != '\n'
               && glyphs.getUnchecked(i)->getCharacter() != '\r')
+        {
+            lineBreaker.next (glyphs.getUnchecked(i)->getCharacter());
             ++i;
+        }
 
         const float lineMaxX = glyphs.getUnchecked (lineStartIndex)->getLeft() + maxLineWidth;
         int lastWordBreakIndex = -1;
@@ -311,14 +315,22 @@ void GlyphArrangement::addJustifiedText (const Font& font,
 
                 break;
             }
-            else if (pg->isWhitespace())
-            {
-                lastWordBreakIndex = i + 1;
-            }
-            else if (pg->getRight() - 0.0001f >= lineMaxX)
+
+            if (lineBreaker.next (c) != LineBreaker::noBreak)
+                lastWordBreakIndex = i;
+
+            if ((! pg->isWhitespace()) && pg->getRight() - 0.0001f >= lineMaxX)
             {
                 if (lastWordBreakIndex >= 0)
+                {
                     i = lastWordBreakIndex;
+                }
+                else
+                {
+                    // there's nowhere the line can be broken, so split the word, but not just before a mark
+                    while (i > lineStartIndex + 1 && LineBreaker::isCombiningMark (glyphs.getUnchecked (i)->getCharacter()))
+                        --i;
+                }
 
                 break;
             }
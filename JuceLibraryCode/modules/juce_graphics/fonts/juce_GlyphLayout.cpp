@@ -25,40 +25,19 @@
 
 BEGIN_JUCE_NAMESPACE
 
-GlyphLayout::Glyph::Glyph (const int glyphCode_, const Point<float>& anchor_)
-    : glyphCode (glyphCode_), anchor (anchor_)
-{
-}
-
-GlyphLayout::Glyph::~Glyph()
-{
-}
-
-//==============================================================================
 GlyphLayout::Run::Run()
     : colour (Colours::black)
 {
 }
 
-GlyphLayout::Run::Run (const int numGlyphs, const Range<int>& range)
+GlyphLayout::Run::Run (const Range<int>& range)
     : stringRange (range),
       colour (Colours::black)
 {
-    glyphs.ensureStorageAllocated (numGlyphs);
 }
 
 GlyphLayout::Run::~Run() {}
 
-GlyphLayout::Glyph& GlyphLayout::Run::getGlyph (const int index) const
-{
-    return *glyphs.getUnchecked (index);
-}
-
-void GlyphLayout::Run::ensureStorageAllocated (int numGlyphsNeeded)
-{
-    glyphs.ensureStorageAllocated (numGlyphsNeeded);
-}
-
 void GlyphLayout::Run::setStringRange (const Range<int>& newStringRange) noexcept
 {
     stringRange = newStringRange;
@@ -74,52 +53,51 @@ void GlyphLayout::Run::setColour (const Colour& newColour) noexcept
     colour = newColour;
 }
 
-void GlyphLayout::Run::addGlyph (Glyph* glyph)
-{
-    glyphs.add (glyph);
-}
-
 //==============================================================================
 GlyphLayout::Line::Line()
-    : ascent (0.0f), descent (0.0f), leading (0.0f)
+    : ascent (0.0f), descent (0.0f), leading (0.0f), width (0.0f)
 {
 }
 
-GlyphLayout::Line::Line (const int numRuns, const Range<int>& stringRange_, const Point<float>& lineOrigin_,
+GlyphLayout::Line::Line (const Range<int>& stringRange_, const Point<float>& lineOrigin_,
                          const float ascent_, const float descent_, const float leading_)
     : stringRange (stringRange_), lineOrigin (lineOrigin_),
-      ascent (ascent_), descent (descent_), leading (leading_)
+      ascent (ascent_), descent (descent_), leading (leading_), width (0.0f)
 {
-    runs.ensureStorageAllocated (numRuns);
 }
 
-GlyphLayout::Line::~Line()
+Rectangle<float> GlyphLayout::Line::getBounds() const noexcept
 {
+    return Rectangle<float> (lineOrigin.x, lineOrigin.y - ascent, width, ascent + descent);
 }
 
-GlyphLayout::Run& GlyphLayout::Line::getRun (const int index) const
+GlyphLayout::Line::~Line()
 {
-    return *runs.getUnchecked(index);
 }
 
-void GlyphLayout::Line::setStringRange (const Range<int>& newStringRange)
+void GlyphLayout::Line::setStringRange (const Range<int>& newStringRange) noexcept
 {
     stringRange = newStringRange;
 }
 
-void GlyphLayout::Line::setLineOrigin (const Point<float>& newLineOrigin)
+void GlyphLayout::Line::setLineOrigin (const Point<float>& newLineOrigin) noexcept
 {
     lineOrigin = newLineOrigin;
 }
 
-void GlyphLayout::Line::setDescent (const float newDescent)
+void GlyphLayout::Line::setAscent (const float newAscent) noexcept
+{
+    ascent = newAscent;
+}
+
+void GlyphLayout::Line::setDescent (const float newDescent) noexcept
 {
     descent = newDescent;
 }
 
-void GlyphLayout::Line::addRun (Run* run)
+void GlyphLayout::Line::setWidth (const float newWidth) noexcept
 {
-    runs.add (run);
+    width = newWidth;
 }
 
 //==============================================================================
@@ -134,47 +112,142 @@ GlyphLayout::~GlyphLayout()
 
 float GlyphLayout::getTextHeight() const
 {
-    const Line* const lastLine = lines.getLast();
+    if (lines.size() == 0)
+        return 0;
+
+    const Line& lastLine = lines.getReference (lines.size() - 1);
+    return lastLine.getLineOrigin().getY() + lastLine.getDescent();
+}
+
+GlyphLayout::Line& GlyphLayout::getLine (const int index) const noexcept
+{
+    return lines.getReference (index);
+}
 
-    return lastLine != nullptr ? lastLine->getLineOrigin().getY() + lastLine->getDescent()
-                               : 0;
+GlyphLayout::Run& GlyphLayout::getRun (const int index) const noexcept
+{
+    return runs.getReference (index);
 }
 
-GlyphLayout::Line& GlyphLayout::getLine (const int index) const
+GlyphLayout::Run& GlyphLayout::getRun (const Line& line, const int index) const noexcept
 {
-    return *lines[index];
+    jassert (isPositiveAndBelow (index, line.getNumRuns()));
+    return runs.getReference (line.runRange.getStart() + index);
 }
 
-void GlyphLayout::ensureStorageAllocated (int numLinesNeeded)
+void GlyphLayout::ensureStorageAllocated (int numLinesNeeded, int numRunsNeeded, int numGlyphsNeeded)
 {
     lines.ensureStorageAllocated (numLinesNeeded);
+    runs.ensureStorageAllocated (numRunsNeeded);
+    glyphCodes.ensureStorageAllocated (numGlyphsNeeded);
+    glyphAnchors.ensureStorageAllocated (numGlyphsNeeded);
 }
 
-void GlyphLayout::addLine (const Line* line)
+GlyphLayout::Line& GlyphLayout::addLine (const Line& line)
 {
     lines.add (line);
+    Line& newLine = lines.getReference (lines.size() - 1);
+    newLine.runRange = Range<int>::emptyRange (runs.size());
+    return newLine;
+}
+
+GlyphLayout::Run& GlyphLayout::addRun (const Run& run)
+{
+    jassert (lines.size() > 0); // a run has to belong to a line!
+
+    runs.add (run);
+    Run& newRun = runs.getReference (runs.size() - 1);
+    newRun.glyphRange = Range<int>::emptyRange (glyphCodes.size());
+
+    lines.getReference (lines.size() - 1).runRange.setEnd (runs.size());
+    return newRun;
+}
+
+void GlyphLayout::addGlyph (const int glyphCode, const Point<float>& anchor)
+{
+    jassert (runs.size() > 0); // a glyph has to belong to a run!
+
+    glyphCodes.add (glyphCode);
+    glyphAnchors.add (anchor);
+
+    runs.getReference (runs.size() - 1).glyphRange.setEnd (glyphCodes.size());
+}
+
+void GlyphLayout::clear()
+{
+    lines.clearQuick();
+    runs.clearQuick();
+    glyphCodes.clearQuick();
+    glyphAnchors.clearQuick();
+    bidiLevels.clearQuick();
+}
+
+void GlyphLayout::moveLinesFrom (GlyphLayout& source)
+{
+    jassert (&source != this);
+
+    lines.swapWithArray (source.lines);
+    runs.swapWithArray (source.runs);
+    glyphCodes.swapWithArray (source.glyphCodes);
+    glyphAnchors.swapWithArray (source.glyphAnchors);
+    bidiLevels.swapWithArray (source.bidiLevels);
+    source.clear();
+
+    const Point<float> delta (area.getPosition() - source.area.getPosition());
+
+    if (delta != Point<float>())
+        for (int i = 0; i < glyphAnchors.size(); ++i)
+            glyphAnchors.getReference (i) += delta;
 }
 
 void GlyphLayout::draw (const Graphics& g) const
 {
     LowLevelGraphicsContext* const context = g.getInternalContext();
+    const Rectangle<float> clip (g.getClipBounds().toFloat() - area.getPosition());
 
-    for (int i = 0; i < getNumLines(); ++i)
+    // Binary-search for the first line that finishes below the top of the clip region..
+    int start = 0, end = lines.size();
+
+    while (start < end)
+    {
+        const int mid = (start + end) / 2;
+
+        if (lines.getReference (mid).getBounds().getBottom() <= clip.getY())
+            start = mid + 1;
+        else
+            end = mid;
+    }
+
+    // ..and then draw runs until reaching a line that starts below the bottom of it.
+    // The runs of consecutive lines are contiguous, so they can be drawn in a single pass.
+    int lastRun = runs.size();
+
+    for (end = start; end < lines.size(); ++end)
+    {
+        const Line& line = lines.getReference (end);
+
+        if (line.getBounds().getY() >= clip.getBottom())
+        {
+            lastRun = line.runRange.getStart();
+            break;
+        }
+    }
+
+    const int firstRun = start < lines.size() ? lines.getReference (start).runRange.getStart() : runs.size();
+
+    for (int i = firstRun; i < lastRun; ++i)
     {
-        Line& line = getLine (i);
+        const Run& run = runs.getReference (i);
 
-        for (int j = 0; j < line.getNumRuns(); ++j)
+        if (run.getNumGlyphs() > 0)
         {
-            const Run& run = line.getRun (j);
+            const int firstGlyph = run.glyphRange.getStart();
+
             context->setFont (run.getFont());
             context->setFill (run.getColour());
-
-            for (int k = 0; k < run.getNumGlyphs(); ++k)
-            {
-                const Glyph& glyph = run.getGlyph (k);
-                context->drawGlyph (glyph.glyphCode, AffineTransform::translation ((float) glyph.anchor.x,
-                                                                                   (float) glyph.anchor.y));
-            }
+            context->drawGlyphRun (&glyphCodes.getReference (firstGlyph),
+                                   &glyphAnchors.getReference (firstGlyph),
+                                   run.getNumGlyphs());
         }
     }
 }
@@ -182,351 +255,1964 @@ void GlyphLayout::draw (const Graphics& g) const
 //==============================================================================
 namespace GlyphLayoutHelpers
 {
-    struct FontAndColour
+    /** The parts of the Unicode bidirectional algorithm (UAX #9) that the standard layout
+        needs: the embedding level of each character of a paragraph is worked out once when
+        the text is set, and each line is then put into visual order as it's laid out.
+
+        Each level run is resolved on its own, rather than being joined up with the runs on
+        either side of an isolate into an isolating run sequence, so a pair of brackets is only
+        matched up by rule N0 when both of them are in the same level run.
+    */
+    namespace Bidi
     {
-        FontAndColour() noexcept   : colour (0xff000000) {}
+        enum CharClass
+        {
+            leftToRight, rightToLeft, arabicLetter, europeanNumber, europeanSeparator, europeanTerminator,
+            arabicNumber, commonSeparator, nonSpacingMark, boundaryNeutral, paragraphSeparator,
+            segmentSeparator, whitespace, otherNeutral, leftToRightEmbedding, leftToRightOverride,
+            rightToLeftEmbedding, rightToLeftOverride, popDirectionalFormat, leftToRightIsolate,
+            rightToLeftIsolate, firstStrongIsolate, popDirectionalIsolate
+        };
+
+        enum
+        {
+            maxDepth = 125,
 
-        const Font* font;
-        Colour colour;
+            /** The levels are all below 128, so the top bit of each one is used to mark the
+                characters that belong to a right-to-left paragraph. */
+            rightToLeftParagraphFlag = 0x80
+        };
 
-        bool operator!= (const FontAndColour& other) const noexcept
+        struct CharClassRange
         {
-            return (font != other.font && *font != *other.font) || colour != other.colour;
+            juce_wchar first, last;
+            CharClass type;
+        };
+
+        // Any character that isn't in one of these ranges is a strong left-to-right one.
+        static const CharClassRange charClassRanges[] =
+        {
+            { 0x0000, 0x0008, boundaryNeutral },        { 0x0009, 0x0009, segmentSeparator },
+            { 0x000a, 0x000a, paragraphSeparator },     { 0x000b, 0x000b, segmentSeparator },
+            { 0x000c, 0x000c, whitespace },             { 0x000d, 0x000d, paragraphSeparator },
+            { 0x000e, 0x001b, boundaryNeutral },        { 0x001c, 0x001e, paragraphSeparator },
+            { 0x001f, 0x001f, segmentSeparator },       { 0x0020, 0x0020, whitespace },
+            { 0x0021, 0x0022, otherNeutral },           { 0x0023, 0x0025, europeanTerminator },
+            { 0x0026, 0x002a, otherNeutral },           { 0x002b, 0x002b, europeanSeparator },
+            { 0x002c, 0x002c, commonSeparator },        { 0x002d, 0x002d, europeanSeparator },
+            { 0x002e, 0x002f, commonSeparator },        { 0x0030, 0x0039, europeanNumber },
+            { 0x003a, 0x003a, commonSeparator },        { 0x003b, 0x0040, otherNeutral },
+            { 0x005b, 0x0060, otherNeutral },           { 0x007b, 0x007e, otherNeutral },
+            { 0x007f, 0x0084, boundaryNeutral },        { 0x0085, 0x0085, paragraphSeparator },
+            { 0x0086, 0x009f, boundaryNeutral },        { 0x00a0, 0x00a0, commonSeparator },
+            { 0x00a1, 0x00a1, otherNeutral },           { 0x00a2, 0x00a5, europeanTerminator },
+            { 0x00a6, 0x00a9, otherNeutral },           { 0x00ab, 0x00ac, otherNeutral },
+            { 0x00ad, 0x00ad, boundaryNeutral },        { 0x00ae, 0x00af, otherNeutral },
+            { 0x00b0, 0x00b1, europeanTerminator },     { 0x00b2, 0x00b3, europeanNumber },
+            { 0x00b4, 0x00b4, otherNeutral },           { 0x00b6, 0x00b8, otherNeutral },
+            { 0x00b9, 0x00b9, europeanNumber },         { 0x00bb, 0x00bf, otherNeutral },
+            { 0x00d7, 0x00d7, otherNeutral },           { 0x00f7, 0x00f7, otherNeutral },
+            { 0x02b9, 0x02ba, otherNeutral },           { 0x02c2, 0x02cf, otherNeutral },
+            { 0x02d2, 0x02df, otherNeutral },           { 0x02e5, 0x02ed, otherNeutral },
+            { 0x02ef, 0x02ff, otherNeutral },           { 0x0300, 0x036f, nonSpacingMark },
+            { 0x0374, 0x0375, otherNeutral },           { 0x037e, 0x037e, otherNeutral },
+            { 0x0384, 0x0385, otherNeutral },           { 0x0387, 0x0387, otherNeutral },
+            { 0x03f6, 0x03f6, otherNeutral },           { 0x0483, 0x0489, nonSpacingMark },
+            { 0x058a, 0x058a, otherNeutral },           { 0x058d, 0x058e, otherNeutral },
+            { 0x058f, 0x058f, europeanTerminator },     { 0x0590, 0x0590, rightToLeft },
+            { 0x0591, 0x05bd, nonSpacingMark },         { 0x05be, 0x05be, rightToLeft },
+            { 0x05bf, 0x05bf, nonSpacingMark },         { 0x05c0, 0x05c0, rightToLeft },
+            { 0x05c1, 0x05c2, nonSpacingMark },         { 0x05c3, 0x05c3, rightToLeft },
+            { 0x05c4, 0x05c5, nonSpacingMark },         { 0x05c6, 0x05c6, rightToLeft },
+            { 0x05c7, 0x05c7, nonSpacingMark },         { 0x05c8, 0x05ff, rightToLeft },
+            { 0x0600, 0x0605, arabicNumber },           { 0x0606, 0x0607, otherNeutral },
+            { 0x0608, 0x0608, arabicLetter },           { 0x0609, 0x060a, europeanTerminator },
+            { 0x060b, 0x060b, arabicLetter },           { 0x060c, 0x060c, commonSeparator },
+            { 0x060d, 0x060d, arabicLetter },           { 0x060e, 0x060f, otherNeutral },
+            { 0x0610, 0x061a, nonSpacingMark },         { 0x061b, 0x064a, arabicLetter },
+            { 0x064b, 0x065f, nonSpacingMark },         { 0x0660, 0x0669, arabicNumber },
+            { 0x066a, 0x066a, europeanTerminator },     { 0x066b, 0x066c, arabicNumber },
+            { 0x066d, 0x066f, arabicLetter },           { 0x0670, 0x0670, nonSpacingMark },
+            { 0x0671, 0x06d5, arabicLetter },           { 0x06d6, 0x06dc, nonSpacingMark },
+            { 0x06dd, 0x06dd, arabicNumber },           { 0x06de, 0x06de, otherNeutral },
+            { 0x06df, 0x06e4, nonSpacingMark },         { 0x06e5, 0x06e6, arabicLetter },
+            { 0x06e7, 0x06e8, nonSpacingMark },         { 0x06e9, 0x06e9, otherNeutral },
+            { 0x06ea, 0x06ed, nonSpacingMark },         { 0x06ee, 0x06ef, arabicLetter },
+            { 0x06f0, 0x06f9, europeanNumber },         { 0x06fa, 0x0710, arabicLetter },
+            { 0x0711, 0x0711, nonSpacingMark },         { 0x0712, 0x072f, arabicLetter },
+            { 0x0730, 0x074a, nonSpacingMark },         { 0x074b, 0x07a5, arabicLetter },
+            { 0x07a6, 0x07b0, nonSpacingMark },         { 0x07b1, 0x07bf, arabicLetter },
+            { 0x07c0, 0x07ea, rightToLeft },            { 0x07eb, 0x07f3, nonSpacingMark },
+            { 0x07f4, 0x07f5, rightToLeft },            { 0x07f6, 0x07f9, otherNeutral },
+            { 0x07fa, 0x0815, rightToLeft },            { 0x0816, 0x082d, nonSpacingMark },
+            { 0x082e, 0x0858, rightToLeft },            { 0x0859, 0x085b, nonSpacingMark },
+            { 0x085c, 0x085f, rightToLeft },            { 0x0860, 0x08d2, arabicLetter },
+            { 0x08d3, 0x08e1, nonSpacingMark },         { 0x08e2, 0x08e2, arabicNumber },
+            { 0x08e3, 0x08ff, nonSpacingMark },         { 0x0e3f, 0x0e3f, europeanTerminator },
+            { 0x1680, 0x1680, whitespace },             { 0x169b, 0x169c, otherNeutral },
+            { 0x17db, 0x17db, europeanTerminator },     { 0x180e, 0x180e, boundaryNeutral },
+            { 0x1ab0, 0x1aff, nonSpacingMark },         { 0x1dc0, 0x1dff, nonSpacingMark },
+            { 0x2000, 0x200a, whitespace },             { 0x200b, 0x200d, boundaryNeutral },
+            { 0x200f, 0x200f, rightToLeft },            { 0x2010, 0x2027, otherNeutral },
+            { 0x2028, 0x2028, whitespace },             { 0x2029, 0x2029, paragraphSeparator },
+            { 0x202a, 0x202a, leftToRightEmbedding },   { 0x202b, 0x202b, rightToLeftEmbedding },
+            { 0x202c, 0x202c, popDirectionalFormat },   { 0x202d, 0x202d, leftToRightOverride },
+            { 0x202e, 0x202e, rightToLeftOverride },    { 0x202f, 0x202f, commonSeparator },
+            { 0x2030, 0x2034, europeanTerminator },     { 0x2035, 0x2043, otherNeutral },
+            { 0x2044, 0x2044, commonSeparator },        { 0x2045, 0x205e, otherNeutral },
+            { 0x205f, 0x205f, whitespace },             { 0x2060, 0x2064, boundaryNeutral },
+            { 0x2066, 0x2066, leftToRightIsolate },     { 0x2067, 0x2067, rightToLeftIsolate },
+            { 0x2068, 0x2068, firstStrongIsolate },     { 0x2069, 0x2069, popDirectionalIsolate },
+            { 0x206a, 0x206f, boundaryNeutral },        { 0x2070, 0x2070, europeanNumber },
+            { 0x2074, 0x2079, europeanNumber },         { 0x207a, 0x207b, europeanSeparator },
+            { 0x207c, 0x207e, otherNeutral },           { 0x2080, 0x2089, europeanNumber },
+            { 0x208a, 0x208b, europeanSeparator },      { 0x208c, 0x208e, otherNeutral },
+            { 0x20a0, 0x20cf, europeanTerminator },     { 0x20d0, 0x20f0, nonSpacingMark },
+            { 0x2100, 0x2101, otherNeutral },           { 0x2103, 0x2106, otherNeutral },
+            { 0x2108, 0x2109, otherNeutral },           { 0x2114, 0x2114, otherNeutral },
+            { 0x2116, 0x2118, otherNeutral },           { 0x211e, 0x2123, otherNeutral },
+            { 0x2140, 0x2144, otherNeutral },           { 0x214a, 0x214d, otherNeutral },
+            { 0x2150, 0x215f, otherNeutral },           { 0x2189, 0x218b, otherNeutral },
+            { 0x2190, 0x2211, otherNeutral },           { 0x2212, 0x2212, europeanSeparator },
+            { 0x2213, 0x2213, europeanTerminator },     { 0x2214, 0x2335, otherNeutral },
+            { 0x237b, 0x2394, otherNeutral },           { 0x2396, 0x2426, otherNeutral },
+            { 0x2440, 0x244a, otherNeutral },           { 0x2460, 0x2487, otherNeutral },
+            { 0x2488, 0x249b, europeanNumber },         { 0x24ea, 0x26ab, otherNeutral },
+            { 0x26ad, 0x27ff, otherNeutral },           { 0x2900, 0x2b73, otherNeutral },
+            { 0x2ce5, 0x2cea, otherNeutral },           { 0x2e00, 0x2e5d, otherNeutral },
+            { 0x2e80, 0x2ffb, otherNeutral },           { 0x3000, 0x3000, whitespace },
+            { 0x3001, 0x3004, otherNeutral },           { 0x3008, 0x3020, otherNeutral },
+            { 0x3030, 0x3030, otherNeutral },           { 0x3036, 0x3037, otherNeutral },
+            { 0x303d, 0x303f, otherNeutral },           { 0x309b, 0x309c, otherNeutral },
+            { 0x30a0, 0x30a0, otherNeutral },           { 0x30fb, 0x30fb, otherNeutral },
+            { 0x31c0, 0x31e3, otherNeutral },           { 0x321d, 0x321e, otherNeutral },
+            { 0x3250, 0x325f, otherNeutral },           { 0x327c, 0x327e, otherNeutral },
+            { 0x32b1, 0x32bf, otherNeutral },           { 0x32cc, 0x32cf, otherNeutral },
+            { 0x3377, 0x337a, otherNeutral },           { 0x33de, 0x33df, otherNeutral },
+            { 0x33ff, 0x33ff, otherNeutral },           { 0x4dc0, 0x4dff, otherNeutral },
+            { 0xa490, 0xa4c6, otherNeutral },           { 0xa60d, 0xa60f, otherNeutral },
+            { 0xa673, 0xa673, otherNeutral },           { 0xa67e, 0xa67f, otherNeutral },
+            { 0xa700, 0xa721, otherNeutral },           { 0xa788, 0xa788, otherNeutral },
+            { 0xfb1d, 0xfb1d, rightToLeft },            { 0xfb1e, 0xfb1e, nonSpacingMark },
+            { 0xfb1f, 0xfb28, rightToLeft },            { 0xfb29, 0xfb29, europeanSeparator },
+            { 0xfb2a, 0xfb4f, rightToLeft },            { 0xfb50, 0xfd3d, arabicLetter },
+            { 0xfd3e, 0xfd3f, otherNeutral },           { 0xfd40, 0xfdcf, arabicLetter },
+            { 0xfdf0, 0xfdfc, arabicLetter },           { 0xfdfd, 0xfdfd, otherNeutral },
+            { 0xfe00, 0xfe0f, nonSpacingMark },         { 0xfe10, 0xfe19, otherNeutral },
+            { 0xfe20, 0xfe2f, nonSpacingMark },         { 0xfe30, 0xfe4f, otherNeutral },
+            { 0xfe50, 0xfe50, commonSeparator },        { 0xfe51, 0xfe51, otherNeutral },
+            { 0xfe52, 0xfe52, commonSeparator },        { 0xfe54, 0xfe54, otherNeutral },
+            { 0xfe55, 0xfe55, commonSeparator },        { 0xfe56, 0xfe5e, otherNeutral },
+            { 0xfe5f, 0xfe5f, europeanTerminator },     { 0xfe60, 0xfe61, otherNeutral },
+            { 0xfe62, 0xfe63, europeanSeparator },      { 0xfe64, 0xfe68, otherNeutral },
+            { 0xfe69, 0xfe6a, europeanTerminator },     { 0xfe6b, 0xfe6b, otherNeutral },
+            { 0xfe70, 0xfefe, arabicLetter },           { 0xfeff, 0xfeff, boundaryNeutral },
+            { 0xff01, 0xff02, otherNeutral },           { 0xff03, 0xff05, europeanTerminator },
+            { 0xff06, 0xff0a, otherNeutral },           { 0xff0b, 0xff0b, europeanSeparator },
+            { 0xff0c, 0xff0c, commonSeparator },        { 0xff0d, 0xff0d, europeanSeparator },
+            { 0xff0e, 0xff0f, commonSeparator },        { 0xff10, 0xff19, europeanNumber },
+            { 0xff1a, 0xff1a, commonSeparator },        { 0xff1b, 0xff20, otherNeutral },
+            { 0xff3b, 0xff40, otherNeutral },           { 0xff5b, 0xff65, otherNeutral },
+            { 0xffe0, 0xffe1, europeanTerminator },     { 0xffe2, 0xffe4, otherNeutral },
+            { 0xffe5, 0xffe6, europeanTerminator },     { 0xffe8, 0xffee, otherNeutral },
+            { 0xfff9, 0xfffd, otherNeutral },           { 0x10800, 0x10e5f, rightToLeft },
+            { 0x10e60, 0x10e7e, arabicNumber },         { 0x10e7f, 0x10fff, rightToLeft },
+            { 0x1d7ce, 0x1d7ff, europeanNumber },       { 0x1e800, 0x1edff, rightToLeft },
+            { 0x1ee00, 0x1eeff, arabicLetter },         { 0x1ef00, 0x1efff, rightToLeft },
+            { 0x1f100, 0x1f10a, europeanNumber },       { 0xe0001, 0xe007f, boundaryNeutral }
+        };
+
+        CharClass getCharClass (const juce_wchar c) noexcept
+        {
+            int start = 0, end = numElementsInArray (charClassRanges);
+
+            while (start < end)
+            {
+                const int mid = (start + end) / 2;
+                const CharClassRange& r = charClassRanges[mid];
+
+                if (c < r.first)        end = mid;
+                else if (c > r.last)    start = mid + 1;
+                else                    return r.type;
+            }
+
+            return leftToRight;
         }
-    };
 
-    struct RunAttribute
-    {
-        RunAttribute (const FontAndColour& fontAndColour_, const Range<int>& range_) noexcept
-            : fontAndColour (fontAndColour_), range (range_)
-        {}
+        bool isRightToLeft (const juce_wchar c) noexcept
+        {
+            if (c < 0x590)
+                return false;
 
-        FontAndColour fontAndColour;
-        Range<int> range;
-    };
+            const CharClass type = getCharClass (c);
+            return type == rightToLeft || type == arabicLetter || type == arabicNumber
+                    || type == rightToLeftEmbedding || type == rightToLeftOverride || type == rightToLeftIsolate;
+        }
 
-    struct Token
-    {
-        Token (const String& t, const Font& f, const Colour& c, const bool isWhitespace_)
-            : text (t), font (f), colour (c),
-              area (font.getStringWidth (t), roundToInt (f.getHeight())),
-              isWhitespace (isWhitespace_),
-              isNewLine (t.containsChar ('\n') || t.containsChar ('\r'))
+        bool isParagraphSeparator (const juce_wchar c) noexcept
         {
+            return c == '\n' || c == '\r' || (c < 0x2029 ? (c >= 0x1c && c <= 0x1e) || c == 0x85 : c == 0x2029);
         }
 
-        void draw (Graphics& g, const int xOffset, const int yOffset)
+        /** Returns the character that should be drawn in place of one that has a mirror-image
+            partner when it appears in right-to-left text, or 0 if it doesn't have one. */
+        juce_wchar getMirroredChar (const juce_wchar c) noexcept
         {
-            if (! isWhitespace)
+            static const juce_wchar pairs[] =
             {
-                g.setFont (font);
-                g.drawSingleLineText (text.trimEnd(),
-                                      xOffset + area.getX(),
-                                      yOffset + area.getY() + (lineHeight - area.getHeight()) + roundToInt (font.getAscent()));
-            }
-        }
+                '(', ')',  '<', '>',  '[', ']',  '{', '}',  0xab, 0xbb,  0x2039, 0x203a,  0x2045, 0x2046,
+                0x207d, 0x207e,  0x208d, 0x208e,  0x2264, 0x2265,  0x226a, 0x226b,  0x27e8, 0x27e9,
+                0x3008, 0x3009,  0x300a, 0x300b,  0x300c, 0x300d,  0x300e, 0x300f,  0x3010, 0x3011,
+                0xff08, 0xff09,  0xff1c, 0xff1e,  0xff3b, 0xff3d,  0xff5b, 0xff5d
+            };
 
-        const String text;
-        const Font font;
-        const Colour colour;
-        Rectangle<int> area;
-        int line, lineHeight;
-        const bool isWhitespace, isNewLine;
+            if (c < '(' || (c > 0xbb && c < 0x2039))
+                return 0;
 
-    private:
-        Token& operator= (const Token&);
-    };
+            for (int i = 0; i < numElementsInArray (pairs); ++i)
+                if (pairs[i] == c)
+                    return pairs [i ^ 1];
 
-    class TokenList
-    {
-    public:
-        TokenList() noexcept : totalLines (0) {}
+            return 0;
+        }
 
-        void createLayout (const AttributedString& text, GlyphLayout& glyphLayout)
+        /** If the character is one of a pair of brackets that rule N0 applies to, returns the
+            other one of the pair and sets isOpening to show which one this is. Otherwise returns 0.
+            (U+2329 and U+232A are returned as their canonical equivalents, U+3008 and U+3009).
+        */
+        juce_wchar getPairedBracket (juce_wchar c, bool& isOpening) noexcept
         {
-            tokens.ensureStorageAllocated (64);
-            glyphLayout.ensureStorageAllocated (totalLines);
+            static const juce_wchar pairs[] =
+            {
+                0x0f3a, 0x0f3b,  0x0f3c, 0x0f3d,  0x169b, 0x169c,  0x2045, 0x2046,  0x207d, 0x207e,
+                0x208d, 0x208e,  0x2308, 0x2309,  0x230a, 0x230b,  0x2768, 0x2769,  0x276a, 0x276b,
+                0x276c, 0x276d,  0x276e, 0x276f,  0x2770, 0x2771,  0x2772, 0x2773,  0x2774, 0x2775,
+                0x27c5, 0x27c6,  0x27e6, 0x27e7,  0x27e8, 0x27e9,  0x27ea, 0x27eb,  0x27ec, 0x27ed,
+                0x27ee, 0x27ef,  0x2983, 0x2984,  0x2985, 0x2986,  0x2987, 0x2988,  0x2989, 0x298a,
+                0x298b, 0x298c,  0x298d, 0x2990,  0x298f, 0x298e,  0x2991, 0x2992,  0x2993, 0x2994,
+                0x2995, 0x2996,  0x2997, 0x2998,  0x29d8, 0x29d9,  0x29da, 0x29db,  0x29fc, 0x29fd,
+                0x2e22, 0x2e23,  0x2e24, 0x2e25,  0x2e26, 0x2e27,  0x2e28, 0x2e29,  0x3008, 0x3009,
+                0x300a, 0x300b,  0x300c, 0x300d,  0x300e, 0x300f,  0x3010, 0x3011,  0x3014, 0x3015,
+                0x3016, 0x3017,  0x3018, 0x3019,  0x301a, 0x301b,  0xfe59, 0xfe5a,  0xfe5b, 0xfe5c,
+                0xfe5d, 0xfe5e,  0xff08, 0xff09,  0xff3b, 0xff3d,  0xff5b, 0xff5d,  0xff5f, 0xff60,
+                0xff62, 0xff63
+            };
+
+            if (c < 0x80)
+            {
+                switch (c)
+                {
+                    case '(':   isOpening = true;   return ')';
+                    case ')':   isOpening = false;  return '(';
+                    case '[':   isOpening = true;   return ']';
+                    case ']':   isOpening = false;  return '[';
+                    case '{':   isOpening = true;   return '}';
+                    case '}':   isOpening = false;  return '{';
+                    default:    return 0;
+                }
+            }
+
+            if (c < 0x0f3a)
+                return 0;
 
-            addTextRuns (text);
+            if (c == 0x2329)        c = 0x3008;
+            else if (c == 0x232a)   c = 0x3009;
 
-            layout ((int) glyphLayout.area.getWidth());
+            for (int i = 0; i < numElementsInArray (pairs); ++i)
+            {
+                if (pairs[i] == c)
+                {
+                    isOpening = (i & 1) == 0;
+                    return pairs [i ^ 1];
+                }
+            }
 
-            int charPosition = 0;
-            int lineStartPosition = 0;
-            int runStartPosition = 0;
+            return 0;
+        }
 
-            GlyphLayout::Line* glyphLine = new GlyphLayout::Line();
-            GlyphLayout::Run*  glyphRun  = new GlyphLayout::Run();
+        //==============================================================================
+        bool isIsolateInitiator (const int type) noexcept
+        {
+            return type == leftToRightIsolate || type == rightToLeftIsolate || type == firstStrongIsolate;
+        }
 
-            for (int i = 0; i < tokens.size(); ++i)
-            {
-                const Token* const t = tokens.getUnchecked (i);
-                const Point<float> tokenPos (t->area.getPosition().toFloat());
+        bool isRemovedByX9 (const int type) noexcept
+        {
+            return type == boundaryNeutral || (type >= leftToRightEmbedding && type <= popDirectionalFormat);
+        }
 
-                Array <int> newGlyphs;
-                Array <float> xOffsets;
-                t->font.getGlyphPositions (t->text.trimEnd(), newGlyphs, xOffsets);
+        bool isNeutral (const int type) noexcept
+        {
+            return (type >= paragraphSeparator && type <= otherNeutral) || type >= leftToRightIsolate;
+        }
 
-                glyphRun->ensureStorageAllocated (glyphRun->getNumGlyphs() + newGlyphs.size());
+        /** Finds the direction of the first strong character, skipping over any isolates, and
+            stopping at the end of the isolate that the search starts in. Returns 0 for
+            left-to-right, 1 for right-to-left, or -1 if there aren't any strong characters. */
+        int findFirstStrongDirection (const uint8* types, int start, const int end) noexcept
+        {
+            int isolateDepth = 0;
 
-                for (int j = 0; j < newGlyphs.size(); ++j)
-                {
-                    if (charPosition == lineStartPosition)
-                        glyphLine->setLineOrigin (tokenPos.translated (0, t->font.getAscent()));
+            for (; start < end; ++start)
+            {
+                const int type = types[start];
 
-                    glyphRun->addGlyph (new GlyphLayout::Glyph (newGlyphs.getUnchecked(j),
-                                                                (glyphLayout.area.getPosition() + glyphLine->getLineOrigin())
-                                                                    .translated (tokenPos.getX() + xOffsets.getUnchecked (j), 0)));
-                    ++charPosition;
+                if (type == paragraphSeparator)
+                    break;
+
+                if (isIsolateInitiator (type))
+                {
+                    ++isolateDepth;
+                }
+                else if (type == popDirectionalIsolate)
+                {
+                    if (--isolateDepth < 0)
+                        break;
+                }
+                else if (isolateDepth == 0)
+                {
+                    if (type == leftToRight)                                return 0;
+                    if (type == rightToLeft || type == arabicLetter)        return 1;
                 }
+            }
 
-                if (t->isWhitespace || t->isNewLine)
-                    ++charPosition;
+            return -1;
+        }
+
+        //==============================================================================
+        /** Returns the direction that a type counts as when rule N0 looks for strong text,
+            or -1 if it doesn't count as either. */
+        int getBracketContextDirection (const int type) noexcept
+        {
+            if (type == leftToRight)
+                return leftToRight;
 
-                const Token* const nextToken = tokens [i + 1];
+            if (type == rightToLeft || type == europeanNumber || type == arabicNumber)
+                return rightToLeft;
 
-                if (nextToken == nullptr) // this is the last token
-                {
-                    glyphRun->setStringRange (Range<int> (runStartPosition, charPosition));
-                    glyphRun->setFont (t->font);
-                    glyphRun->setColour (t->colour);
+            return -1;
+        }
+
+        struct BracketPair
+        {
+            int opening, closing;  // indexes into the level run's positions
+        };
+
+        struct BracketPairComparator
+        {
+            static int compareElements (const BracketPair& first, const BracketPair& second) noexcept
+            {
+                return first.opening < second.opening ? -1 : (first.opening > second.opening ? 1 : 0);
+            }
+        };
+
+        /** Applies rule N0 to a level run: a pair of brackets takes the embedding direction if
+            there's strong text of that direction inside it, or else the opposite direction if
+            there's strong text of that direction inside it and that's also the direction of the
+            strong text before it.
+        */
+        void resolveBracketPairs (const juce_wchar* text, const uint8* originalTypes, uint8* types,
+                                  const int* positions, const int numPositions,
+                                  const int sos, const int embeddingDirection)
+        {
+            // BD16: the pairs are found with a stack of the opening brackets, which gives up
+            // on finding any more of them if it overflows
+            enum { maxStackSize = 63 };
+            int openingIndexes [maxStackSize];
+            juce_wchar closingChars [maxStackSize];
+            int stackSize = 0;
+            Array <BracketPair> pairs;
+
+            for (int i = 0; i < numPositions; ++i)
+            {
+                if (types [positions[i]] != otherNeutral)
+                    continue;
+
+                bool isOpening = false;
+                const juce_wchar partner = getPairedBracket (text [positions[i]], isOpening);
 
-                    if (t->font.getDescent() > glyphLine->getDescent())
-                        glyphLine->setDescent (t->font.getDescent());
+                if (partner == 0)
+                    continue;
 
-                    glyphLine->addRun (glyphRun);
+                if (isOpening)
+                {
+                    if (stackSize >= maxStackSize)
+                        break;
 
-                    glyphLine->setStringRange (Range<int> (lineStartPosition, charPosition));
-                    glyphLayout.addLine (glyphLine);
+                    openingIndexes [stackSize] = i;
+                    closingChars [stackSize] = partner;
+                    ++stackSize;
                 }
                 else
                 {
-                    if (t->font != nextToken->font || t->colour != nextToken->colour)
+                    const juce_wchar c = text [positions[i]] == 0x232a ? (juce_wchar) 0x3009 : text [positions[i]];
+
+                    for (int j = stackSize; --j >= 0;)
                     {
-                        glyphRun->setStringRange (Range<int> (runStartPosition, charPosition));
-                        glyphRun->setFont (t->font);
-                        glyphRun->setColour (t->colour);
+                        if (closingChars[j] == c)
+                        {
+                            BracketPair pair = { openingIndexes[j], i };
+                            pairs.add (pair);
+                            stackSize = j;
+                            break;
+                        }
+                    }
+                }
+            }
 
-                        if (t->font.getDescent() > glyphLine->getDescent())
-                            glyphLine->setDescent (t->font.getDescent());
+            BracketPairComparator comparator;
+            pairs.sort (comparator);
 
-                        glyphLine->addRun (glyphRun);
+            const int oppositeDirection = embeddingDirection == leftToRight ? rightToLeft : leftToRight;
 
-                        runStartPosition = charPosition;
-                        glyphRun = new GlyphLayout::Run();
-                    }
+            for (int i = 0; i < pairs.size(); ++i)
+            {
+                const BracketPair& pair = pairs.getReference (i);
+                bool hasEmbeddingDirection = false, hasOppositeDirection = false;
 
-                    if (t->line != nextToken->line)
-                    {
-                        glyphRun->setStringRange (Range<int> (runStartPosition, charPosition));
-                        glyphRun->setFont (t->font);
-                        glyphRun->setColour (t->colour);
+                for (int j = pair.opening + 1; j < pair.closing && ! hasEmbeddingDirection; ++j)
+                {
+                    const int direction = getBracketContextDirection (types [positions[j]]);
+
+                    hasEmbeddingDirection = (direction == embeddingDirection);
+                    hasOppositeDirection = hasOppositeDirection || (direction == oppositeDirection);
+                }
 
-                        if (t->font.getDescent() > glyphLine->getDescent())
-                            glyphLine->setDescent (t->font.getDescent());
+                int newType;
 
-                        glyphLine->addRun (glyphRun);
+                if (hasEmbeddingDirection)
+                {
+                    newType = embeddingDirection;
+                }
+                else if (hasOppositeDirection)
+                {
+                    int directionBefore = sos;
 
-                        glyphLine->setStringRange (Range<int> (lineStartPosition, charPosition));
-                        glyphLayout.addLine (glyphLine);
+                    for (int j = pair.opening; --j >= 0;)
+                    {
+                        const int direction = getBracketContextDirection (types [positions[j]]);
 
-                        runStartPosition = charPosition;
-                        lineStartPosition = charPosition;
-                        glyphLine = new GlyphLayout::Line();
-                        glyphRun  = new GlyphLayout::Run();
+                        if (direction >= 0)
+                        {
+                            directionBefore = direction;
+                            break;
+                        }
                     }
+
+                    newType = directionBefore == oppositeDirection ? oppositeDirection : embeddingDirection;
+                }
+                else
+                {
+                    continue;
                 }
-            }
 
-            if (text.getTextAlignment() == AttributedString::right
-                 || text.getTextAlignment() == AttributedString::center)
-            {
-                const int totalW = (int) glyphLayout.area.getWidth();
+                // (any non-spacing marks after a bracket change along with it)
+                const int brackets[] = { pair.opening, pair.closing };
 
-                for (int i = 0; i < totalLines; ++i)
+                for (int j = 0; j < 2; ++j)
                 {
-                    const int lineW = getLineWidth (i);
-                    float dx = 0;
-
-                    if (text.getTextAlignment() == AttributedString::right)
-                        dx = (float) (totalW - lineW);
-                    else if (text.getTextAlignment() == AttributedString::center)
-                        dx = (totalW - lineW) / 2.0f;
+                    types [positions [brackets[j]]] = (uint8) newType;
 
-                    GlyphLayout::Line& glyphLine = glyphLayout.getLine (i);
-                    glyphLine.setLineOrigin (glyphLine.getLineOrigin().translated (dx, 0));
+                    for (int k = brackets[j] + 1; k < numPositions && originalTypes [positions[k]] == nonSpacingMark; ++k)
+                        types [positions[k]] = (uint8) newType;
                 }
             }
         }
 
-    private:
-        void appendText (const AttributedString& text, const Range<int>& stringRange,
-                         const Font& font, const Colour& colour)
+        /** Resolves the types of the characters in a level run, using the rules W1 to I2. The
+            positions are the indexes of the run's characters, which skip over any characters
+            that were removed by rule X9. */
+        void resolveLevelRun (const juce_wchar* text, const uint8* originalTypes, uint8* types, uint8* levels,
+                              const int* positions, const int numPositions, const int sos, const int eos)
         {
-            String stringText (text.getText().substring(stringRange.getStart(), stringRange.getEnd()));
-            String::CharPointerType t (stringText.getCharPointer());
-            String currentString;
-            int lastCharType = 0;
+            const int level = levels [positions[0]];
+            const int embeddingDirection = (level & 1) != 0 ? rightToLeft : leftToRight;
 
-            for (;;)
+            // W1: non-spacing marks take the type of the character before them
+            int previousType = sos;
+
+            for (int i = 0; i < numPositions; ++i)
             {
-                const juce_wchar c = t.getAndAdvance();
-                if (c == 0)
-                    break;
+                uint8& type = types [positions[i]];
 
-                int charType;
-                if (c == '\r' || c == '\n')
-                    charType = 0;
-                else if (CharacterFunctions::isWhitespace (c))
-                    charType = 2;
-                else
-                    charType = 1;
+                if (type == nonSpacingMark)
+                    type = (uint8) ((isIsolateInitiator (previousType) || previousType == popDirectionalIsolate)
+                                        ? otherNeutral : previousType);
 
-                if (charType == 0 || charType != lastCharType)
-                {
-                    if (currentString.isNotEmpty())
-                        tokens.add (new Token (currentString, font, colour,
-                                               lastCharType == 2 || lastCharType == 0));
+                previousType = type;
+            }
 
-                    currentString = String::charToString (c);
+            // W2 and W3: European numbers after Arabic letters become Arabic numbers,
+            // and then Arabic letters become right-to-left ones
+            int lastStrong = sos;
 
-                    if (c == '\r' && *t == '\n')
-                        currentString += t.getAndAdvance();
-                }
-                else
-                {
-                    currentString += c;
-                }
+            for (int i = 0; i < numPositions; ++i)
+            {
+                uint8& type = types [positions[i]];
 
-                lastCharType = charType;
+                if (type == leftToRight || type == rightToLeft || type == arabicLetter)
+                    lastStrong = type;
+                else if (type == europeanNumber && lastStrong == arabicLetter)
+                    type = arabicNumber;
             }
 
-            if (currentString.isNotEmpty())
-                tokens.add (new Token (currentString, font, colour, lastCharType == 2));
-        }
+            for (int i = 0; i < numPositions; ++i)
+                if (types [positions[i]] == arabicLetter)
+                    types [positions[i]] = rightToLeft;
 
-        void layout (const int maxWidth)
-        {
-            int x = 0, y = 0, h = 0;
-            int i;
+            // W4: a single separator between two numbers of the same kind becomes a number
+            for (int i = 1; i < numPositions - 1; ++i)
+            {
+                uint8& type = types [positions[i]];
+                const int before = types [positions[i - 1]];
+                const int after  = types [positions[i + 1]];
+
+                if (type == europeanSeparator && before == europeanNumber && after == europeanNumber)
+                    type = europeanNumber;
+                else if (type == commonSeparator && before == after && (before == europeanNumber || before == arabicNumber))
+                    type = (uint8) before;
+            }
 
-            for (i = 0; i < tokens.size(); ++i)
+            // W5: terminators next to a European number become part of it
+            for (int i = 0; i < numPositions;)
             {
-                Token* const t = tokens.getUnchecked(i);
-                t->area.setPosition (x, y);
-                t->line = totalLines;
-                x += t->area.getWidth();
-                h = jmax (h, t->area.getHeight());
+                if (types [positions[i]] != europeanTerminator)
+                {
+                    ++i;
+                    continue;
+                }
 
-                const Token* nextTok = tokens[i + 1];
+                int end = i;
 
-                if (nextTok == 0)
-                    break;
+                while (end < numPositions && types [positions[end]] == europeanTerminator)
+                    ++end;
 
-                if (t->isNewLine || ((! nextTok->isWhitespace) && x + nextTok->area.getWidth() > maxWidth))
+                if ((i > 0 && types [positions[i - 1]] == europeanNumber)
+                     || (end < numPositions && types [positions[end]] == europeanNumber))
                 {
-                    setLastLineHeight (i + 1, h);
-                    x = 0;
-                    y += h;
-                    h = 0;
-                    ++totalLines;
+                    for (int j = i; j < end; ++j)
+                        types [positions[j]] = europeanNumber;
                 }
+
+                i = end;
             }
 
-            setLastLineHeight (jmin (i + 1, tokens.size()), h);
-            ++totalLines;
-        }
+            // W6 and W7: any other separators are neutral, and European numbers after
+            // left-to-right text are left-to-right
+            lastStrong = sos;
 
-        void setLastLineHeight (int i, const int height)
-        {
-            while (--i >= 0)
+            for (int i = 0; i < numPositions; ++i)
             {
-                Token* const tok = tokens.getUnchecked (i);
-
-                if (tok->line == totalLines)
-                    tok->lineHeight = height;
-                else
-                    break;
+                uint8& type = types [positions[i]];
+
+                if (type == europeanSeparator || type == europeanTerminator || type == commonSeparator)
+                    type = otherNeutral;
+                else if (type == leftToRight || type == rightToLeft)
+                    lastStrong = type;
+                else if (type == europeanNumber && lastStrong == leftToRight)
+                    type = leftToRight;
             }
-        }
 
-        int getLineWidth (const int lineNumber) const
-        {
-            int maxW = 0;
+            // N0: pairs of brackets
+            resolveBracketPairs (text, originalTypes, types, positions, numPositions, sos, embeddingDirection);
 
-            for (int i = tokens.size(); --i >= 0;)
+            // N1 and N2: a run of neutrals takes the direction of the text on both sides of it if
+            // that's the same, or the embedding direction if it isn't
+            for (int i = 0; i < numPositions;)
             {
-                const Token* const t = tokens.getUnchecked (i);
+                if (! isNeutral (types [positions[i]]))
+                {
+                    ++i;
+                    continue;
+                }
+
+                int end = i;
+
+                while (end < numPositions && isNeutral (types [positions[end]]))
+                    ++end;
 
-                if (t->line == lineNumber && ! t->isWhitespace)
-                    maxW = jmax (maxW, t->area.getRight());
+                const int before = i > 0 ? types [positions[i - 1]] : sos;
+                const int after  = end < numPositions ? types [positions[end]] : eos;
+                const int beforeDirection = before == leftToRight ? leftToRight : rightToLeft;
+                const int afterDirection  = after  == leftToRight ? leftToRight : rightToLeft;
+                const uint8 newType = (uint8) (beforeDirection == afterDirection ? beforeDirection : embeddingDirection);
+
+                for (int j = i; j < end; ++j)
+                    types [positions[j]] = newType;
+
+                i = end;
             }
 
-            return maxW;
+            // I1 and I2
+            for (int i = 0; i < numPositions; ++i)
+            {
+                const int type = types [positions[i]];
+                uint8& l = levels [positions[i]];
+
+                if ((level & 1) == 0)
+                {
+                    if (type == rightToLeft)                                        l = (uint8) (level + 1);
+                    else if (type == arabicNumber || type == europeanNumber)        l = (uint8) (level + 2);
+                }
+                else if (type == leftToRight || type == arabicNumber || type == europeanNumber)
+                {
+                    l = (uint8) (level + 1);
+                }
+            }
         }
 
-        void addTextRuns (const AttributedString& text)
+        /** Works out the embedding levels for a paragraph, which may only contain a paragraph
+            separator as its last character (or a CR-LF pair). The baseLevel can be 0 or 1, or -1
+            to take the direction from the first strong character.
+        */
+        void resolveParagraph (const juce_wchar* const text, const int numChars, int baseLevel, uint8* const levels)
         {
-            Font defaultFont;
-            Array<RunAttribute> runAttributes;
+            HeapBlock<uint8> types ((size_t) numChars), originalTypes ((size_t) numChars);
+            HeapBlock<int> positions ((size_t) numChars);
+
+            for (int i = 0; i < numChars; ++i)
+                types[i] = originalTypes[i] = (uint8) getCharClass (text[i]);
 
+            // P2 and P3
+            if (baseLevel < 0)
+                baseLevel = jmax (0, findFirstStrongDirection (types, 0, numChars));
+
+            // X1 to X8: the explicit embeddings, overrides and isolates
+            struct StackEntry
             {
-                const int stringLength = text.getText().length();
-                int rangeStart = 0;
-                FontAndColour lastFontAndColour;
+                uint8 level, override;
+                bool isIsolate;
+            };
 
-                // Iterate through every character in the string
-                for (int i = 0; i < stringLength; ++i)
-                {
-                    FontAndColour newFontAndColour;
-                    newFontAndColour.font = &defaultFont;
+            StackEntry stack [maxDepth + 2];
+            int depth = 0, overflowIsolates = 0, overflowEmbeddings = 0, validIsolates = 0;
 
-                    const int numCharacterAttributes = text.getNumAttributes();
+            stack[0].level = (uint8) baseLevel;
+            stack[0].override = otherNeutral;
+            stack[0].isIsolate = false;
 
-                    for (int j = 0; j < numCharacterAttributes; ++j)
+            for (int i = 0; i < numChars; ++i)
+            {
+                uint8& type = types[i];
+                const StackEntry& current = stack [depth];
+
+                switch (type)
+                {
+                    case leftToRightEmbedding:
+                    case leftToRightOverride:
+                    case rightToLeftEmbedding:
+                    case rightToLeftOverride:
+                    {
+                        const bool isRTL = type == rightToLeftEmbedding || type == rightToLeftOverride;
+                        const int newLevel = isRTL ? ((current.level + 1) | 1) : ((current.level + 2) & ~1);
+                        levels[i] = current.level;
+
+                        if (newLevel <= maxDepth && overflowIsolates == 0 && overflowEmbeddings == 0)
+                        {
+                            StackEntry& e = stack [++depth];
+                            e.level = (uint8) newLevel;
+                            e.override = (uint8) (type == leftToRightOverride ? leftToRight
+                                                                              : (type == rightToLeftOverride ? rightToLeft : otherNeutral));
+                            e.isIsolate = false;
+                        }
+                        else if (overflowIsolates == 0)
+                        {
+                            ++overflowEmbeddings;
+                        }
+
+                        break;
+                    }
+
+                    case leftToRightIsolate:
+                    case rightToLeftIsolate:
+                    case firstStrongIsolate:
                     {
-                        const AttributedString::Attribute* const attr = text.getAttribute (j);
+                        levels[i] = current.level;
+
+                        bool isRTL = type == rightToLeftIsolate;
+
+                        if (type == firstStrongIsolate)
+                            isRTL = findFirstStrongDirection (types, i + 1, numChars) == 1;
 
-                        // Check if the current character falls within the range of a font attribute
-                        if (attr->getFont() != nullptr && (i >= attr->range.getStart()) && (i < attr->range.getEnd()))
-                            newFontAndColour.font = attr->getFont();
+                        if (current.override != otherNeutral)
+                            type = current.override;
 
-                        // Check if the current character falls within the range of a foreground colour attribute
-                        if (attr->getColour() != nullptr && (i >= attr->range.getStart()) && (i < attr->range.getEnd()))
-                            newFontAndColour.colour = *attr->getColour();
+                        const int newLevel = isRTL ? ((current.level + 1) | 1) : ((current.level + 2) & ~1);
+
+                        if (newLevel <= maxDepth && overflowIsolates == 0 && overflowEmbeddings == 0)
+                        {
+                            ++validIsolates;
+                            StackEntry& e = stack [++depth];
+                            e.level = (uint8) newLevel;
+                            e.override = otherNeutral;
+                            e.isIsolate = true;
+                        }
+                        else
+                        {
+                            ++overflowIsolates;
+                        }
+
+                        break;
                     }
 
-                    if (i > 0 && (newFontAndColour != lastFontAndColour || i == stringLength - 1))
+                    case popDirectionalIsolate:
                     {
-                        runAttributes.add (RunAttribute (lastFontAndColour,
-                                                         Range<int> (rangeStart, (i < stringLength - 1) ? i : (i + 1))));
-                        rangeStart = i;
+                        if (overflowIsolates > 0)
+                        {
+                            --overflowIsolates;
+                        }
+                        else if (validIsolates > 0)
+                        {
+                            overflowEmbeddings = 0;
+
+                            while (! stack [depth].isIsolate)
+                                --depth;
+
+                            --depth;
+                            --validIsolates;
+                        }
+
+                        levels[i] = stack [depth].level;
+
+                        if (stack [depth].override != otherNeutral)
+                            type = stack [depth].override;
+
+                        break;
                     }
 
-                    lastFontAndColour = newFontAndColour;
+                    case popDirectionalFormat:
+                        if (overflowIsolates == 0)
+                        {
+                            if (overflowEmbeddings > 0)
+                                --overflowEmbeddings;
+                            else if (depth > 0 && ! current.isIsolate)
+                                --depth;
+                        }
+
+                        levels[i] = stack [depth].level;
+                        break;
+
+                    case paragraphSeparator:
+                        levels[i] = (uint8) baseLevel;
+                        break;
+
+                    default:
+                        levels[i] = current.level;
+
+                        if (current.override != otherNeutral && type != boundaryNeutral)
+                            type = current.override;
+
+                        break;
                 }
             }
 
-            for (int i = 0; i < runAttributes.size(); ++i)
+            // X9 and X10: leaving out the removed characters, resolve each run of characters at the same level
+            int numPositions = 0;
+
+            for (int i = 0; i < numChars; ++i)
+                if (! isRemovedByX9 (types[i]))
+                    positions [numPositions++] = i;
+
+            for (int start = 0; start < numPositions;)
+            {
+                const int level = levels [positions [start]];
+                int end = start + 1;
+
+                while (end < numPositions && levels [positions [end]] == level)
+                    ++end;
+
+                const int levelBefore = start > 0 ? levels [positions [start - 1]] : baseLevel;
+                const int levelAfter = (end < numPositions && ! isIsolateInitiator (types [positions [end - 1]]))
+                                            ? levels [positions [end]] : baseLevel;
+
+                resolveLevelRun (text, originalTypes, types, levels, positions + start, end - start,
+                                 (jmax (level, levelBefore) & 1) != 0 ? rightToLeft : leftToRight,
+                                 (jmax (level, levelAfter)  & 1) != 0 ? rightToLeft : leftToRight);
+                start = end;
+            }
+
+            // The removed characters just take the level of the character before them..
+            for (int i = 0; i < numChars; ++i)
+                if (isRemovedByX9 (originalTypes[i]))
+                    levels[i] = i > 0 ? levels [i - 1] : (uint8) baseLevel;
+
+            // ..and then L1 puts separators and any whitespace before them, or at the end of the
+            // paragraph, back at the paragraph's level.
+            bool isBeforeSeparator = true;
+
+            for (int i = numChars; --i >= 0;)
             {
-                const RunAttribute& r = runAttributes.getReference(i);
-                appendText (text, r.range, *(r.fontAndColour.font), r.fontAndColour.colour);
+                const int type = originalTypes[i];
+
+                if (type == paragraphSeparator || type == segmentSeparator)
+                {
+                    levels[i] = (uint8) baseLevel;
+                    isBeforeSeparator = true;
+                }
+                else if (isBeforeSeparator && (type == whitespace || isIsolateInitiator (type)
+                                                 || type == popDirectionalIsolate || isRemovedByX9 (type)))
+                {
+                    levels[i] = (uint8) baseLevel;
+                }
+                else
+                {
+                    isBeforeSeparator = false;
+                }
             }
+
+            if (baseLevel != 0)
+                for (int i = 0; i < numChars; ++i)
+                    levels[i] |= rightToLeftParagraphFlag;
+        }
+
+        //==============================================================================
+        /** Returns true if some of the text needs to be given bidi levels. */
+        bool needsLevels (const AttributedString& text, const Range<int>& range)
+        {
+            if (text.getReadingDirection() == AttributedString::rightToLeft)
+                return true;
+
+            String::CharPointerType t (text.getText().getCharPointer() + range.getStart());
+
+            for (int i = range.getLength(); --i >= 0;)
+                if (isRightToLeft (t.getAndAdvance()))
+                    return true;
+
+            return false;
         }
 
-        OwnedArray<Token> tokens;
-        int totalLines;
+        /** Widens a range of characters to cover the whole paragraphs that contain it, including
+            the character before the range. */
+        Range<int> findParagraphs (const AttributedString& text, const Range<int>& range)
+        {
+            String::CharPointerType t (text.getText().getCharPointer());
+            const int textLength = text.getText().length();
+            const int firstChar = jmax (0, range.getStart() - 1);
+            int start = 0, paragraphStart = 0, position = 0;
 
-        JUCE_DECLARE_NON_COPYABLE (TokenList);
-    };
-}
+            while (position < textLength)
+            {
+                const juce_wchar c = t.getAndAdvance();
+                ++position;
 
-//==============================================================================
-void GlyphLayout::createStandardLayout (const AttributedString& text)
-{
-    GlyphLayoutHelpers::TokenList l;
-    l.createLayout (text, *this);
-}
+                if (isParagraphSeparator (c) || position == textLength)
+                {
+                    if (c == '\r' && position < textLength && *t == '\n')
+                    {
+                        ++t;
+                        ++position;
+                    }
+
+                    if (paragraphStart <= firstChar)
+                        start = paragraphStart;
+
+                    if (position > range.getEnd())
+                        break;
+
+                    paragraphStart = position;
+                }
+            }
+
+            return Range<int> (start, position);
+        }
+
+        /** Fills in the levels for the characters in a range, which must start at the beginning
+            of a paragraph and finish at the end of one. */
+        void resolveParagraphs (const AttributedString& text, const Range<int>& range, uint8* const levels)
+        {
+            const int baseLevel = text.getReadingDirection() == AttributedString::leftToRight ? 0
+                                    : (text.getReadingDirection() == AttributedString::rightToLeft ? 1 : -1);
+
+            HeapBlock<juce_wchar> chars ((size_t) range.getLength());
+            String::CharPointerType t (text.getText().getCharPointer() + range.getStart());
+
+            for (int i = 0; i < range.getLength(); ++i)
+                chars[i] = t.getAndAdvance();
+
+            for (int start = 0; start < range.getLength();)
+            {
+                int end = start;
+
+                while (end < range.getLength())
+                {
+                    const juce_wchar c = chars [end++];
+
+                    if (isParagraphSeparator (c))
+                    {
+                        if (c == '\r' && end < range.getLength() && chars [end] == '\n')
+                            ++end;
+
+                        break;
+                    }
+                }
+
+                resolveParagraph (chars + start, end - start, baseLevel, levels + start);
+                start = end;
+            }
+        }
+    }
+
+    //==============================================================================
+    /** A word, run of whitespace or line-break. Rather than holding a copy of its text, a
+        token refers to a range of the source string, and to the glyphs that were created
+        for it when it was measured.
+
+        A word is the text between two places where a line could be broken, so in a
+        language that isn't written with spaces, it may only be a single character.
+    */
+    struct Token
+    {
+        Token() noexcept
+            : text (nullptr), x (0), width (0), height (0),
+              isWhitespace (true), isNewLine (false), canBreakBefore (false)
+        {
+        }
+
+        Range<int> range, glyphRange;
+        String::CharPointerType text;
+        Font font;
+        Colour colour;
+        float x, width;
+        int height;
+        bool isWhitespace, isNewLine, canBreakBefore;
+    };
+
+    //==============================================================================
+    /** Splits an AttributedString into words, whitespace and line-breaks, starting from
+        any character position, and only reading as far into the text as it's asked to.
+
+        Words are split wherever a LineBreaker says a line could be broken. The start of
+        a line is always somewhere a line could be broken, so a reader that starts there
+        finds the same places as one that started at the beginning of the text.
+
+        The text is measured a chunk at a time, so that each word is passed through its
+        typeface once, and the same glyphs and offsets are used for both the word-wrapping
+        and the glyph positions.
+    */
+    class TokenReader
+    {
+    public:
+        TokenReader (const AttributedString& text_, const int startPosition, const uint8* const levels_)
+            : text (text_),
+              levels (levels_),
+              t (text_.getText().getCharPointer()),
+              position (0),
+              textLength (text_.getText().length()),
+              runEnd (0),
+              attributeIndex (0),
+              breakPosition (-1),
+              breakBefore (LineBreaker::noBreak),
+              colour (Colours::black),
+              measuredGlyphsMatchText (false)
+        {
+            t += startPosition;
+            position = startPosition;
+
+            // Binary-search for the first attribute that finishes after the start position
+            int end = text.getNumAttributes();
+
+            while (attributeIndex < end)
+            {
+                const int mid = (attributeIndex + end) / 2;
+
+                if (text.getAttribute (mid)->range.getEnd() <= position)
+                    attributeIndex = mid + 1;
+                else
+                    end = mid;
+            }
+        }
+
+        /** Reads the next token, appending the glyphs of a word to the arrays, with their
+            offsets relative to the start of the word.
+        */
+        bool readToken (Token& token, Array<int>& glyphs, Array<float>& glyphOffsets)
+        {
+            if (position >= textLength)
+                return false;
+
+            if (position >= runEnd)
+                findNextRun();
+
+            const String::CharPointerType tokenStart (t);
+            const int tokenStartPosition = position;
+            const juce_wchar c = *t;
+            const int charType = getCharType (c);
+
+            token.canBreakBefore = findBreakBefore (c) != LineBreaker::noBreak;
+            ++t;
+            ++position;
+
+            if (charType == lineBreak)
+            {
+                if (c == '\r' && *t == '\n' && position < runEnd)
+                {
+                    findBreakBefore ('\n');
+                    ++t;
+                    ++position;
+                }
+            }
+            else
+            {
+                for (;;)
+                {
+                    // ASCII letters and digits, and spaces, are skipped over quickly, and only
+                    // the other characters are passed to the LineBreaker one at a time
+                    position += lineBreaker.skipAsciiRun (t, runEnd - position);
+
+                    if (position >= runEnd || getCharType (*t) != charType
+                         || (findBreakBefore (*t) != LineBreaker::noBreak && charType != whitespace))
+                        break;
+
+                    ++t;
+                    ++position;
+                }
+            }
+
+            token.range = Range<int> (tokenStartPosition, position);
+            token.glyphRange = Range<int>::emptyRange (glyphs.size());
+            token.text = tokenStart;
+            token.font = font;
+            token.colour = colour;
+            token.x = 0;
+            token.width = 0;
+            token.height = roundToInt (font.getHeight());
+            token.isWhitespace = charType != word;
+            token.isNewLine = charType == lineBreak;
+
+            if (! token.isNewLine)
+                measure (token, tokenStart, glyphs, glyphOffsets);
+
+            return true;
+        }
+
+    private:
+        enum { lineBreak, word, whitespace };
+        enum { maxCharsToMeasure = 256 };
+
+        const AttributedString& text;
+        const uint8* const levels;
+        String::CharPointerType t;
+        int position, textLength, runEnd, attributeIndex;
+        LineBreaker lineBreaker;
+        int breakPosition;
+        LineBreaker::BreakType breakBefore;
+        Font font;
+        Colour colour;
+
+        Range<int> measuredRange;
+        Array<int> measuredGlyphs;
+        Array<float> measuredOffsets;
+        bool measuredGlyphsMatchText;
+
+        static int getCharType (const juce_wchar c) noexcept
+        {
+            if (c == '\r' || c == '\n')
+                return lineBreak;
+
+            return CharacterFunctions::isWhitespace (c) ? whitespace : word;
+        }
+
+        // Returns the kind of break before the character at the current position. Each
+        // character is only passed to the LineBreaker once, although this may be called
+        // for it both when looking for the end of one token and at the start of the next.
+        LineBreaker::BreakType findBreakBefore (const juce_wchar c) noexcept
+        {
+            if (breakPosition != position)
+            {
+                breakPosition = position;
+                breakBefore = lineBreaker.next (c);
+            }
+
+            return breakBefore;
+        }
+
+        void findNextRun()
+        {
+            const int numAttributes = text.getNumAttributes();
+
+            while (attributeIndex < numAttributes && text.getAttribute (attributeIndex)->range.getEnd() <= position)
+                ++attributeIndex;
+
+            font = Font();
+            colour = Colours::black;
+            runEnd = textLength;
+            measuredRange = Range<int>();
+
+            if (attributeIndex < numAttributes)
+            {
+                const AttributedString::Attribute* const attr = text.getAttribute (attributeIndex);
+
+                if (attr->range.getStart() <= position)
+                {
+                    if (attr->getFont() != nullptr)     font = *attr->getFont();
+                    if (attr->getColour() != nullptr)   colour = *attr->getColour();
+
+                    runEnd = jmin (runEnd, attr->range.getEnd());
+                }
+                else
+                {
+                    runEnd = jmin (runEnd, attr->range.getStart());
+                }
+            }
+        }
+
+        void measure (Token& token, const String::CharPointerType tokenStart,
+                      Array<int>& glyphs, Array<float>& glyphOffsets)
+        {
+            if (! measuredRange.contains (token.range))
+                measureChunk (tokenStart, token.range.getStart());
+
+            if (measuredGlyphsMatchText && measuredRange.contains (token.range))
+            {
+                const int start = token.range.getStart() - measuredRange.getStart();
+                const int end   = token.range.getEnd()   - measuredRange.getStart();
+                const float startX = measuredOffsets.getUnchecked (start);
+
+                token.width = measuredOffsets.getUnchecked (end) - startX;
+
+                if (! token.isWhitespace)
+                {
+                    for (int i = start; i < end; ++i)
+                    {
+                        glyphs.add (measuredGlyphs.getUnchecked (i));
+                        glyphOffsets.add (measuredOffsets.getUnchecked (i) - startX);
+                    }
+
+                    if (levels != nullptr)
+                        mirrorGlyphs (token, tokenStart, glyphs);
+                }
+            }
+            else
+            {
+                // Some of the characters didn't map onto exactly one glyph, so this token
+                // has to be measured on its own.
+                Array<int> newGlyphs;
+                Array<float> newOffsets;
+                font.getGlyphPositions (String (tokenStart, t), newGlyphs, newOffsets);
+
+                if (newOffsets.size() > 0)
+                    token.width = newOffsets.getLast();
+
+                if (! token.isWhitespace)
+                {
+                    glyphs.addArray (newGlyphs);
+                    glyphOffsets.addArray (newOffsets, 0, newGlyphs.size());
+
+                    // (the glyphs can only be mirrored if each one belongs to a single character)
+                    if (levels != nullptr && newGlyphs.size() == token.range.getLength())
+                        mirrorGlyphs (token, tokenStart, glyphs);
+                }
+            }
+
+            token.glyphRange.setEnd (glyphs.size());
+        }
+
+        void mirrorGlyphs (const Token& token, String::CharPointerType c, Array<int>& glyphs) const
+        {
+            // Characters like brackets are drawn as their mirror-images in right-to-left text
+            for (int i = token.range.getStart(); i < token.range.getEnd(); ++i)
+            {
+                const juce_wchar mirrored = (levels[i] & 1) != 0 ? Bidi::getMirroredChar (*c) : 0;
+                ++c;
+
+                if (mirrored != 0)
+                {
+                    Array<int> newGlyphs;
+                    Array<float> newOffsets;
+                    font.getGlyphPositions (String::charToString (mirrored), newGlyphs, newOffsets);
+
+                    if (newGlyphs.size() == 1)
+                        glyphs.set (token.glyphRange.getStart() + i - token.range.getStart(), newGlyphs.getUnchecked (0));
+                }
+            }
+        }
+
+        void measureChunk (String::CharPointerType start, const int startPosition)
+        {
+            // Measure up to the end of the run or the next line-break, and then carry on to the
+            // end of the current word, so that the chunk holds as many complete words as possible.
+            String::CharPointerType end (start);
+            int endPosition = startPosition;
+
+            while (endPosition < runEnd
+                    && (endPosition - startPosition < maxCharsToMeasure || getCharType (*end) == word))
+            {
+                if (getCharType (*end) == lineBreak)
+                    break;
+
+                ++end;
+                ++endPosition;
+            }
+
+            measuredRange = Range<int> (startPosition, endPosition);
+            measuredGlyphs.clearQuick();
+            measuredOffsets.clearQuick();
+            font.getGlyphPositions (String (start, end), measuredGlyphs, measuredOffsets);
+
+            measuredGlyphsMatchText = measuredGlyphs.size() == measuredRange.getLength()
+                                        && measuredOffsets.size() == measuredRange.getLength() + 1;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (TokenReader);
+    };
+
+    //==============================================================================
+    /** Word-wraps the tokens from a TokenReader, one line at a time.
+
+        When a word doesn't fit, the line is broken at the last place before it where a
+        break is allowed. If there's nowhere at all, the word is split between whichever
+        characters make the line as full as possible.
+    */
+    class LineWrapper
+    {
+    public:
+        LineWrapper (const AttributedString& text, const int startPosition, const float maxWidth_,
+                     const uint8* const bidiLevels = nullptr)
+            : reader (text, startPosition, bidiLevels),
+              maxWidth (maxWidth_),
+              lineWidth (0)
+        {
+        }
+
+        bool readLine()
+        {
+            tokens.clearQuick();
+            lineWidth = 0;
+
+            Array<Token> carried;
+            carried.swapWithArray (carriedTokens);
+
+            if (carried.size() > 0)
+            {
+                // The first words of this line were read while filling the previous one, so
+                // their glyphs have to be moved to the start of the arrays.
+                const int numToRemove = carried.getReference (0).glyphRange.getStart();
+                glyphs.removeRange (0, numToRemove);
+                glyphOffsets.removeRange (0, numToRemove);
+
+                for (int i = 0; i < carried.size(); ++i)
+                    carried.getReference (i).glyphRange -= numToRemove;
+            }
+            else
+            {
+                glyphs.clearQuick();
+                glyphOffsets.clearQuick();
+            }
+
+            Token token;
+            int numCarriedUsed = 0;
+
+            for (;;)
+            {
+                if (numCarriedUsed < carried.size())
+                    token = carried.getReference (numCarriedUsed++);
+                else if (! reader.readToken (token, glyphs, glyphOffsets))
+                    break;
+
+                if ((! token.isWhitespace) && lineWidth + token.width > maxWidth && wrapBefore (token))
+                {
+                    carriedTokens.addArray (carried, numCarriedUsed);
+                    break;
+                }
+
+                addToken (token);
+
+                if (token.isNewLine)
+                    break;
+            }
+
+            return tokens.size() > 0;
+        }
+
+        int getLineEnd() const noexcept      { return tokens.getReference (tokens.size() - 1).range.getEnd(); }
+
+        Array<Token> tokens;
+        Array<int> glyphs;
+        Array<float> glyphOffsets;
+
+    private:
+        TokenReader reader;
+        Array<Token> carriedTokens;
+        const float maxWidth;
+        float lineWidth;
+
+        void addToken (Token& token)
+        {
+            token.x = lineWidth;
+            lineWidth += token.width;
+            tokens.add (token);
+        }
+
+        // Ends the line somewhere before the end of a word that doesn't fit on it, leaving
+        // the tokens that have to go onto the next line in carriedTokens. Returns false if
+        // the word has to be added to the line even though it doesn't fit.
+        bool wrapBefore (Token& token)
+        {
+            if (token.canBreakBefore && tokens.size() > 0)
+            {
+                carriedTokens.add (token);
+                return true;
+            }
+
+            for (int i = tokens.size(); --i > 0;)
+            {
+                if (tokens.getReference (i).canBreakBefore)
+                {
+                    carriedTokens.addArray (tokens, i);
+                    carriedTokens.add (token);
+                    tokens.removeRange (i, tokens.size() - i);
+                    return true;
+                }
+            }
+
+            const int numChars = findEmergencyBreak (token);
+
+            if (numChars >= token.range.getLength())
+                return false;
+
+            if (numChars > 0)
+            {
+                Token remainder (token);
+                splitToken (token, remainder, numChars);
+                addToken (token);
+                carriedTokens.add (remainder);
+            }
+            else
+            {
+                carriedTokens.add (token);
+            }
+
+            return true;
+        }
+
+        // Finds the number of characters of a word that will fit onto the rest of the line.
+        // At least one character is always left on a line that would otherwise be empty,
+        // and a word is never split just before a combining mark.
+        int findEmergencyBreak (const Token& token) const
+        {
+            const int numChars = token.range.getLength();
+
+            if (token.glyphRange.getLength() != numChars)
+                return numChars; // (it can only be split if each character has its own glyph)
+
+            const float spaceLeft = maxWidth - lineWidth;
+            String::CharPointerType c (token.text);
+            int split = (tokens.size() > 0 && ! LineBreaker::isCombiningMark (*c)) ? 0 : -1;
+
+            for (int i = 1; i < numChars; ++i)
+            {
+                if (! LineBreaker::isCombiningMark (*++c))
+                {
+                    const bool fits = glyphOffsets.getUnchecked (token.glyphRange.getStart() + i) <= spaceLeft;
+
+                    if (fits || split < 0)
+                        split = i;
+
+                    if (! fits)
+                        break;
+                }
+            }
+
+            return split < 0 ? numChars : split;
+        }
+
+        void splitToken (Token& first, Token& second, const int numChars)
+        {
+            const int glyphIndex = first.glyphRange.getStart() + numChars;
+            const float splitX = glyphOffsets.getUnchecked (glyphIndex);
+
+            first.range.setEnd (first.range.getStart() + numChars);
+            first.glyphRange.setEnd (glyphIndex);
+            first.width = splitX;
+
+            second.range.setStart (first.range.getEnd());
+            second.glyphRange.setStart (glyphIndex);
+            second.text += numChars;
+            second.width -= splitX;
+            second.canBreakBefore = true;
+
+            for (int i = glyphIndex; i < second.glyphRange.getEnd(); ++i)
+                glyphOffsets.getReference (i) -= splitX;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (LineWrapper);
+    };
+
+    /** Returns the last place before the end position where a line could be broken, or -1
+        if there isn't one after the start position. The text is read from the start position
+        in the same way as a TokenReader that starts there.
+    */
+    int findLastBreak (const String& text, const int start, const int end) noexcept
+    {
+        String::CharPointerType t (text.getCharPointer());
+        t += start;
+
+        LineBreaker lineBreaker;
+        int lastBreak = -1;
+
+        for (int i = start; i < end; ++i)
+            if (lineBreaker.next (t.getAndAdvance()) != LineBreaker::noBreak)
+                lastBreak = i;
+
+        return lastBreak;
+    }
+
+    //==============================================================================
+    /** The dimensions of a wrapped line of tokens. */
+    struct LineMetrics
+    {
+        explicit LineMetrics (const Array<Token>& tokens) noexcept
+            : height (0), width (0), ascent (0), descent (0)
+        {
+            for (int i = 0; i < tokens.size(); ++i)
+            {
+                const Token& t = tokens.getReference (i);
+                height  = jmax (height, t.height);
+                ascent  = jmax (ascent, t.font.getAscent());
+                descent = jmax (descent, t.font.getDescent());
+
+                if (! t.isWhitespace)
+                    width = jmax (width, t.x + t.width);
+            }
+        }
+
+        int height;
+        float width, ascent, descent;
+    };
+
+    /** Starts a new run if a piece of text can't be added to the current one. */
+    GlyphLayout::Run* getRunFor (GlyphLayout& glyphLayout, GlyphLayout::Run* glyphRun,
+                                 const Token& t, const Range<int>& range)
+    {
+        if (glyphRun == nullptr || glyphRun->getFont() != t.font || glyphRun->getColour() != t.colour
+             || (range.getStart() != glyphRun->getStringRange().getEnd()
+                  && range.getEnd() != glyphRun->getStringRange().getStart()))
+        {
+            glyphRun = &glyphLayout.addRun (GlyphLayout::Run (range));
+            glyphRun->setFont (t.font);
+            glyphRun->setColour (t.colour);
+        }
+        else
+        {
+            glyphRun->setStringRange (glyphRun->getStringRange().getUnionWith (range));
+        }
+
+        return glyphRun;
+    }
+
+    /** A part of a token in which all the characters have the same bidi level. */
+    struct BidiPiece
+    {
+        const Token* token;
+        Range<int> range, glyphRange;
+        float start, end; // the distances of the piece's edges from the start of its token
+        int level;
+    };
+
+    /** Adds the runs for a line that contains some right-to-left text, in visual order.
+        Returns false without adding anything if all the text is left-to-right.
+    */
+    bool addBidiRuns (GlyphLayout& glyphLayout, const LineWrapper& line,
+                      const Point<float>& baseline, const uint8* const levels)
+    {
+        const Array<Token>& tokens = line.tokens;
+        int numTokens = tokens.size();
+
+        // Whitespace at the end of the line isn't drawn, so it can be left out of the reordering
+        while (numTokens > 0 && tokens.getReference (numTokens - 1).isWhitespace)
+            --numTokens;
+
+        Array<BidiPiece> pieces;
+        int highestLevel = 0, lowestOddLevel = Bidi::maxDepth + 1;
+
+        for (int i = 0; i < numTokens; ++i)
+        {
+            const Token& t = tokens.getReference (i);
+
+            // A word can only be split where its levels change if each character has one glyph
+            const bool canBeSplit = t.glyphRange.getLength() == t.range.getLength();
+
+            for (int pieceStart = t.range.getStart(); pieceStart < t.range.getEnd();)
+            {
+                const int level = levels [pieceStart] & ~Bidi::rightToLeftParagraphFlag;
+                int pieceEnd = t.range.getEnd();
+
+                if (canBeSplit)
+                {
+                    pieceEnd = pieceStart + 1;
+
+                    while (pieceEnd < t.range.getEnd() && (levels [pieceEnd] & ~Bidi::rightToLeftParagraphFlag) == level)
+                        ++pieceEnd;
+                }
+
+                BidiPiece piece;
+                piece.token = &t;
+                piece.range = Range<int> (pieceStart, pieceEnd);
+                piece.level = level;
+
+                if (canBeSplit)
+                {
+                    const int firstGlyph = t.glyphRange.getStart() - t.range.getStart();
+                    piece.glyphRange = piece.range + firstGlyph;
+                    piece.start = line.glyphOffsets.getUnchecked (pieceStart + firstGlyph);
+                    piece.end = pieceEnd < t.range.getEnd() ? line.glyphOffsets.getUnchecked (pieceEnd + firstGlyph) : t.width;
+                }
+                else
+                {
+                    piece.glyphRange = t.glyphRange;
+                    piece.start = 0;
+                    piece.end = t.width;
+                }
+
+                pieces.add (piece);
+                highestLevel = jmax (highestLevel, level);
+
+                if ((level & 1) != 0)
+                    lowestOddLevel = jmin (lowestOddLevel, level);
+
+                pieceStart = pieceEnd;
+            }
+        }
+
+        if (lowestOddLevel > highestLevel)
+            return false;
+
+        // L2: from the highest level down to the lowest odd one, reverse every sequence of
+        // pieces that are at that level or above
+        const int numPieces = pieces.size();
+        HeapBlock<int> order ((size_t) numPieces);
+
+        for (int i = 0; i < numPieces; ++i)
+            order[i] = i;
+
+        for (int level = highestLevel; level >= lowestOddLevel; --level)
+        {
+            for (int i = 0; i < numPieces;)
+            {
+                int end = i;
+
+                while (end < numPieces && pieces.getReference (order [end]).level >= level)
+                    ++end;
+
+                for (int j = i, k = end - 1; j < k; ++j, --k)
+                    std::swap (order[j], order[k]);
+
+                i = end + 1;
+            }
+        }
+
+        GlyphLayout::Run* glyphRun = nullptr;
+        float x = 0;
+
+        for (int i = 0; i < numPieces; ++i)
+        {
+            const BidiPiece& piece = pieces.getReference (order[i]);
+            glyphRun = getRunFor (glyphLayout, glyphRun, *piece.token, piece.range);
+
+            if ((piece.level & 1) == 0)
+            {
+                for (int j = piece.glyphRange.getStart(); j < piece.glyphRange.getEnd(); ++j)
+                    glyphLayout.addGlyph (line.glyphs.getUnchecked (j),
+                                          baseline.translated (x + line.glyphOffsets.getUnchecked (j) - piece.start, 0));
+            }
+            else
+            {
+                // A right-to-left piece is mirrored, so that each glyph ends where the one before it started
+                for (int j = piece.glyphRange.getEnd(); --j >= piece.glyphRange.getStart();)
+                {
+                    const float glyphEnd = j + 1 < piece.glyphRange.getEnd() ? line.glyphOffsets.getUnchecked (j + 1) : piece.end;
+
+                    glyphLayout.addGlyph (line.glyphs.getUnchecked (j),
+                                          baseline.translated (x + piece.end - glyphEnd, 0));
+                }
+            }
+
+            x += piece.end - piece.start;
+        }
+
+        for (int i = numTokens; i < tokens.size(); ++i)
+            glyphRun = getRunFor (glyphLayout, glyphRun, tokens.getReference (i), tokens.getReference (i).range);
+
+        return true;
+    }
+
+    /** Adds a wrapped line of tokens to a layout, and returns the height of the line. If the text
+        has bidi levels, any lines that contain right-to-left text are put into visual order.
+    */
+    int addLine (GlyphLayout& glyphLayout, const LineWrapper& line, const float top,
+                 AttributedString::TextAlignment alignment, const uint8* const bidiLevels = nullptr)
+    {
+        const Array<Token>& tokens = line.tokens;
+        const LineMetrics metrics (tokens);
+        const int lineStart = tokens.getReference (0).range.getStart();
+
+        // Like DirectWrite's leading and trailing alignments, these are mirrored in a right-to-left paragraph
+        if (bidiLevels != nullptr && (bidiLevels [lineStart] & Bidi::rightToLeftParagraphFlag) != 0)
+            alignment = alignment == AttributedString::right ? AttributedString::left
+                                                             : (alignment == AttributedString::center ? AttributedString::center
+                                                                                                      : AttributedString::right);
+
+        float dx = 0;
+
+        if (alignment == AttributedString::right)
+            dx = glyphLayout.area.getWidth() - metrics.width;
+        else if (alignment == AttributedString::center)
+            dx = (glyphLayout.area.getWidth() - metrics.width) / 2.0f;
+
+        const Point<float> lineOrigin (dx, top + metrics.ascent);
+
+        glyphLayout.addLine (GlyphLayout::Line (Range<int> (lineStart, line.getLineEnd()),
+                                                lineOrigin, metrics.ascent, metrics.descent, 0.0f))
+            .setWidth (metrics.width);
+
+        const Point<float> baseline (glyphLayout.area.getPosition() + lineOrigin);
+
+        if (bidiLevels != nullptr && addBidiRuns (glyphLayout, line, baseline, bidiLevels))
+            return metrics.height;
+
+        GlyphLayout::Run* glyphRun = nullptr;
+
+        for (int i = 0; i < tokens.size(); ++i)
+        {
+            const Token& t = tokens.getReference (i);
+            glyphRun = getRunFor (glyphLayout, glyphRun, t, t.range);
+
+            for (int j = t.glyphRange.getStart(); j < t.glyphRange.getEnd(); ++j)
+                glyphLayout.addGlyph (line.glyphs.getUnchecked (j),
+                                      baseline.translated (t.x + line.glyphOffsets.getUnchecked (j), 0));
+        }
+
+        return metrics.height;
+    }
+}
+
+//==============================================================================
+void GlyphLayout::createStandardLayout (const AttributedString& text)
+{
+    const int textLength = text.getText().length();
+
+    bidiLevels.clearQuick();
+
+    if (GlyphLayoutHelpers::Bidi::needsLevels (text, Range<int> (0, textLength)))
+    {
+        bidiLevels.insertMultiple (0, 0, textLength);
+        GlyphLayoutHelpers::Bidi::resolveParagraphs (text, Range<int> (0, textLength), bidiLevels.getRawDataPointer());
+    }
+
+    const uint8* const levels = bidiLevels.size() > 0 ? bidiLevels.getRawDataPointer() : nullptr;
+    GlyphLayoutHelpers::LineWrapper wrapper (text, 0, area.getWidth(), levels);
+    float top = 0;
+
+    ensureStorageAllocated (0, 0, textLength);
+
+    while (wrapper.readLine())
+        top += GlyphLayoutHelpers::addLine (*this, wrapper, top, text.getTextAlignment(), levels);
+}
+
+void GlyphLayout::measureStandardLayout (const AttributedString& text, const float width,
+                                         AttributedString::Measurement& result)
+{
+    GlyphLayoutHelpers::LineWrapper wrapper (text, 0, width);
+    float top = 0;
+
+    result.height = 0;
+    result.lineWidths.clearQuick();
+
+    while (wrapper.readLine())
+    {
+        const GlyphLayoutHelpers::LineMetrics metrics (wrapper.tokens);
+
+        result.lineWidths.add (metrics.width);
+        result.height = top + metrics.ascent + metrics.descent;
+        top += metrics.height;
+    }
+}
+
+void GlyphLayout::measureFullLayout (const AttributedString& text, const float width,
+                                     AttributedString::Measurement& result)
+{
+    // Native layouts can only be measured by creating them, in an area tall enough that
+    // none of the lines will be dropped
+    GlyphLayout layout (Rectangle<float> (0, 0, width, 1.0e7f));
+    layout.setText (text);
+
+    result.height = layout.getTextHeight();
+    result.lineWidths.clearQuick();
+
+    for (int i = 0; i < layout.lines.size(); ++i)
+        result.lineWidths.add (layout.lines.getReference (i).width);
+}
+
+void GlyphLayout::updateStandardLayout (const AttributedString& text, const Range<int>& changedRange)
+{
+    if (lines.size() == 0)
+    {
+        createStandardLayout (text);
+        return;
+    }
+
+    const int newLength = text.getText().length();
+    const int oldLength = lines.getReference (lines.size() - 1).stringRange.getEnd();
+    const int lengthDelta = newLength - oldLength;
+    const Range<int> changed (changedRange.getIntersectionWith (Range<int> (0, newLength)));
+
+    // Any lines whose bidi levels have changed may need to be put into a different order,
+    // so they're laid out again along with the lines that contain the change.
+    const Range<int> levelsChanged (updateBidiLevels (text, changed, lengthDelta));
+    const Range<int> relayout (levelsChanged.isEmpty() ? changed : changed.getUnionWith (levelsChanged));
+    const uint8* const levels = bidiLevels.size() > 0 ? bidiLevels.getRawDataPointer() : nullptr;
+
+    // A change can affect the wrapping as far back as the last place before it where a line
+    // could be broken: the text that follows that place might now fit onto the end of the line
+    // before, or no longer stop that line from fitting it. So the re-wrapping starts one line
+    // earlier than the line that holds that place, which may be several lines before the
+    // change if it's in a long word, or in text that can't be broken before punctuation.
+    int breakLine = findLineContaining (relayout.getStart());
+    int searchEnd = relayout.getStart();
+
+    for (;;)
+    {
+        const int lineStart = lines.getReference (breakLine).stringRange.getStart();
+        const int lastBreak = GlyphLayoutHelpers::findLastBreak (text.getText(), lineStart, searchEnd);
+
+        if (lastBreak >= 0)
+        {
+            breakLine = findLineContaining (lastBreak);
+            break;
+        }
+
+        if (breakLine == 0)
+            break;
+
+        --breakLine;
+        searchEnd = jmin (searchEnd, lineStart + 1);
+    }
+
+    const int firstLine = jmax (0, breakLine - 1);
+    const Line& first = lines.getReference (firstLine);
+    const float firstLineTop = first.lineOrigin.y - first.ascent;
+
+    GlyphLayout newLines (area);
+    GlyphLayoutHelpers::LineWrapper wrapper (text, first.stringRange.getStart(), area.getWidth(), levels);
+    float top = firstLineTop;
+    int endLine = lines.size();
+
+    while (wrapper.readLine())
+    {
+        top += GlyphLayoutHelpers::addLine (newLines, wrapper, top, text.getTextAlignment(), levels);
+
+        // Once a line ends beyond the change at the same place that one of the old lines
+        // started, all the lines that follow will wrap exactly as they did before.
+        const int nextLineStart = wrapper.getLineEnd();
+
+        if (nextLineStart >= relayout.getEnd() && nextLineStart < newLength)
+        {
+            const int oldIndex = findLineContaining (nextLineStart - lengthDelta);
+
+            if (oldIndex > firstLine && lines.getReference (oldIndex).stringRange.getStart() == nextLineStart - lengthDelta)
+            {
+                endLine = oldIndex;
+                break;
+            }
+        }
+    }
+
+    float yDelta = 0;
+
+    if (endLine < lines.size())
+    {
+        const Line& oldLine = lines.getReference (endLine);
+        yDelta = top - (oldLine.lineOrigin.y - oldLine.ascent);
+    }
+
+    replaceLines (firstLine, endLine, newLines, lengthDelta, yDelta);
+}
+
+Range<int> GlyphLayout::updateBidiLevels (const AttributedString& text, const Range<int>& changed, const int lengthDelta)
+{
+    using namespace GlyphLayoutHelpers;
+
+    if (bidiLevels.size() == 0)
+    {
+        if (! Bidi::needsLevels (text, changed))
+            return Range<int>();
+
+        // None of the old text needed any levels, so they would all have been zero
+        bidiLevels.insertMultiple (0, 0, text.getText().length() - lengthDelta);
+    }
+
+    const Range<int> paragraphs (Bidi::findParagraphs (text, changed));
+
+    Array<uint8> newLevels;
+    newLevels.insertMultiple (0, 0, paragraphs.getLength());
+    Bidi::resolveParagraphs (text, paragraphs, newLevels.getRawDataPointer());
+
+    // Find the characters either side of the change whose levels are different..
+    int start = paragraphs.getStart();
+
+    while (start < changed.getStart()
+            && bidiLevels.getUnchecked (start) == newLevels.getUnchecked (start - paragraphs.getStart()))
+        ++start;
+
+    int end = paragraphs.getEnd();
+
+    while (end > changed.getEnd()
+            && bidiLevels.getUnchecked (end - 1 - lengthDelta) == newLevels.getUnchecked (end - 1 - paragraphs.getStart()))
+        --end;
+
+    // ..and then replace the old paragraphs' levels with the new ones
+    bidiLevels.removeRange (paragraphs.getStart(), paragraphs.getLength() - lengthDelta);
+    bidiLevels.insertArray (paragraphs.getStart(), newLevels.getRawDataPointer(), newLevels.size());
+
+    return Range<int> (start, end);
+}
+
+int GlyphLayout::findLineContaining (const int characterIndex) const noexcept
+{
+    int start = 0, end = lines.size();
+
+    while (end - start > 1)
+    {
+        const int mid = (start + end) / 2;
+
+        if (lines.getReference (mid).stringRange.getStart() <= characterIndex)
+            start = mid;
+        else
+            end = mid;
+    }
+
+    return start;
+}
+
+void GlyphLayout::replaceLines (const int startLine, const int endLine, GlyphLayout& newLines,
+                                const int stringDelta, const float yDelta)
+{
+    const int runStart   = startLine < lines.size() ? lines.getReference (startLine).runRange.getStart() : runs.size();
+    const int runEnd     = endLine   < lines.size() ? lines.getReference (endLine).runRange.getStart()   : runs.size();
+    const int glyphStart = runStart  < runs.size()  ? runs.getReference (runStart).glyphRange.getStart() : glyphCodes.size();
+    const int glyphEnd   = runEnd    < runs.size()  ? runs.getReference (runEnd).glyphRange.getStart()   : glyphCodes.size();
+
+    const int runDelta   = newLines.runs.size() - (runEnd - runStart);
+    const int glyphDelta = newLines.glyphCodes.size() - (glyphEnd - glyphStart);
+
+    // Move along the lines that follow the replaced section..
+    for (int i = endLine; i < lines.size(); ++i)
+    {
+        Line& line = lines.getReference (i);
+        line.runRange += runDelta;
+        line.stringRange += stringDelta;
+        line.lineOrigin.y += yDelta;
+    }
+
+    for (int i = runEnd; i < runs.size(); ++i)
+    {
+        Run& run = runs.getReference (i);
+        run.glyphRange += glyphDelta;
+        run.stringRange += stringDelta;
+    }
+
+    if (yDelta != 0)
+        for (int i = glyphEnd; i < glyphAnchors.size(); ++i)
+            glyphAnchors.getReference (i).y += yDelta;
+
+    // ..and then swap in the new section, with its indexes offset to its new position
+    for (int i = 0; i < newLines.lines.size(); ++i)
+        newLines.lines.getReference (i).runRange += runStart;
+
+    for (int i = 0; i < newLines.runs.size(); ++i)
+        newLines.runs.getReference (i).glyphRange += glyphStart;
+
+    lines.removeRange (startLine, endLine - startLine);
+    lines.insertArray (startLine, newLines.lines.getRawDataPointer(), newLines.lines.size());
+
+    runs.removeRange (runStart, runEnd - runStart);
+    runs.insertArray (runStart, newLines.runs.getRawDataPointer(), newLines.runs.size());
+
+    glyphCodes.removeRange (glyphStart, glyphEnd - glyphStart);
+    glyphCodes.insertArray (glyphStart, newLines.glyphCodes.getRawDataPointer(), newLines.glyphCodes.size());
+
+    glyphAnchors.removeRange (glyphStart, glyphEnd - glyphStart);
+    glyphAnchors.insertArray (glyphStart, newLines.glyphAnchors.getRawDataPointer(), newLines.glyphAnchors.size());
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class GlyphLayoutTests  : public UnitTest
+{
+public:
+    GlyphLayoutTests() : UnitTest ("GlyphLayout") {}
+
+    // Every character of this typeface is one unit wide, so a line's width is just the
+    // number of characters on it
+    Font createFixedWidthFont()
+    {
+        CustomTypeface* const typeface = new CustomTypeface();
+        typeface->setCharacteristics ("Fixed", 0.8f, false, false, ' ');
+
+        for (juce_wchar c = 32; c < 127; ++c)
+            typeface->addGlyph (c, Path(), 1.0f);
+
+        Font font ((Typeface::Ptr (typeface)));
+        font.setHeight (10.0f);
+        return font;
+    }
+
+    static String getLineRanges (const GlyphLayout& layout)
+    {
+        String ranges;
+
+        for (int i = 0; i < layout.getNumLines(); ++i)
+        {
+            const Range<int> range (layout.getLine (i).getStringRange());
+            ranges << '[' << range.getStart() << ',' << range.getEnd() << ')';
+        }
+
+        return ranges;
+    }
+
+    // Lays out the old text, changes it, and checks that the updated layout is wrapped the
+    // same way as a new one
+    void expectUpdateMatchesNewLayout (const Font& font, const float width, const String& oldText,
+                                       const String& newText, const Range<int>& changedRange)
+    {
+        AttributedString oldString (oldText), newString (newText);
+        oldString.setFont (Range<int> (0, oldText.length()), font);
+        newString.setFont (Range<int> (0, newText.length()), font);
+
+        GlyphLayout updated (Rectangle<float> (0, 0, width, 1000.0f));
+        updated.setText (oldString);
+        updated.updateText (newString, changedRange);
+
+        GlyphLayout created (Rectangle<float> (0, 0, width, 1000.0f));
+        created.setText (newString);
+
+        expectEquals (getLineRanges (updated), getLineRanges (created));
+    }
+
+    void runTest()
+    {
+        const Font font (createFixedWidthFont());
+
+        beginTest ("Updating the text");
+
+        expectUpdateMatchesNewLayout (font, 45.0f, "one two three", "one two thre", Range<int> (11, 11));
+        expectUpdateMatchesNewLayout (font, 45.0f, "one two three", "one twothree", Range<int> (7, 7));
+        expectUpdateMatchesNewLayout (font, 45.0f, "one two three", "one t two three", Range<int> (4, 6));
+
+        // The "." can't be put onto a line without the word before it, so that word was moved
+        // onto a line of its own, leaving "-" at the end of the line before that
+        expectUpdateMatchesNewLayout (font, 30.5f, "-a- .", "-a- ", Range<int> (4, 4));
+
+        // A long word is split between lines, and a change to its end affects where it starts
+        expectUpdateMatchesNewLayout (font, 30.5f, "a well-known .x", "a well-known x", Range<int> (13, 13));
+        expectUpdateMatchesNewLayout (font, 30.5f, "a wellknownword", "a wellknownword .", Range<int> (15, 17));
+    }
+};
+
+static GlyphLayoutTests glyphLayoutTests;
+
+#endif
 
 
 END_JUCE_NAMESPACE
@@ -32,6 +32,12 @@
 
 //==============================================================================
 /**
+    A set of glyphs, arranged into lines and runs.
+
+    All the glyph codes and anchors of a layout are held in a pair of flat arrays
+    owned by the layout, and each Run just refers to a range of indexes into them.
+    In the same way, each Line refers to a range of the layout's runs, so building a
+    layout only needs a handful of allocations however many glyphs it contains.
 */
 class JUCE_API  GlyphLayout
 {
@@ -42,22 +48,6 @@ public:
     /** Destructor. */
     ~GlyphLayout();
 
-    //==============================================================================
-    /**
-    */
-    class JUCE_API  Glyph
-    {
-    public:
-        Glyph (int glyphCode, const Point<float>& anchor);
-        ~Glyph();
-
-        const int glyphCode;
-        const Point<float> anchor;
-
-    private:
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Glyph);
-    };
-
     //==============================================================================
     /**
     */
@@ -65,28 +55,26 @@ public:
     {
     public:
         Run();
-        Run (int numGlyphs, const Range<int>& range);
+        Run (const Range<int>& stringRange);
         ~Run();
 
-        int getNumGlyphs() const noexcept       { return glyphs.size(); }
-        const Font& getFont() const noexcept    { return font; }
-        const Colour& getColour() const         { return colour; }
-        Glyph& getGlyph (int index) const;
+        int getNumGlyphs() const noexcept                       { return glyphRange.getLength(); }
+        const Range<int>& getGlyphRange() const noexcept        { return glyphRange; }
+        const Range<int>& getStringRange() const noexcept       { return stringRange; }
+        const Font& getFont() const noexcept                    { return font; }
+        const Colour& getColour() const noexcept                { return colour; }
 
         void setStringRange (const Range<int>& newStringRange) noexcept;
         void setFont (const Font& newFont);
         void setColour (const Colour& newColour) noexcept;
 
-        void addGlyph (Glyph* glyph);
-        void ensureStorageAllocated (int numGlyphsNeeded);
-
     private:
-        OwnedArray<Glyph> glyphs;
-        Range<int> stringRange;
+        friend class GlyphLayout;
+        Range<int> stringRange, glyphRange;
         Font font;
         Colour colour;
 
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Run);
+        JUCE_LEAK_DETECTOR (Run);
     };
 
     //==============================================================================
@@ -96,8 +84,7 @@ public:
     {
     public:
         Line();
-        Line (int numRuns, const Range<int>& stringRange,
-              const Point<float>& lineOrigin,
+        Line (const Range<int>& stringRange, const Point<float>& lineOrigin,
               float ascent, float descent, float leading);
         ~Line();
 
@@ -106,52 +93,118 @@ public:
         float getAscent() const noexcept                        { return ascent; }
         float getDescent() const noexcept                       { return descent; }
         float getLeading() const noexcept                       { return leading; }
+        /** Returns the distance from the line origin to the end of its last glyph. */
+        float getWidth() const noexcept                         { return width; }
 
-        int getNumRuns() const noexcept                         { return runs.size(); }
-        Run& getRun (int index) const;
+        /** Returns the box that encloses the line, relative to the top-left of the layout's area. */
+        Rectangle<float> getBounds() const noexcept;
 
-        void setStringRange (const Range<int>& newStringRange);
-        void setLineOrigin (const Point<float>& newLineOrigin);
-        void setDescent (float newDescent);
+        int getNumRuns() const noexcept                         { return runRange.getLength(); }
+        const Range<int>& getRunRange() const noexcept          { return runRange; }
+        const Range<int>& getStringRange() const noexcept       { return stringRange; }
 
-        void addRun (Run* run);
+        void setStringRange (const Range<int>& newStringRange) noexcept;
+        void setLineOrigin (const Point<float>& newLineOrigin) noexcept;
+        void setAscent (float newAscent) noexcept;
+        void setDescent (float newDescent) noexcept;
+        void setWidth (float newWidth) noexcept;
 
     private:
-        OwnedArray<Run> runs;
-        Range<int> stringRange;
+        friend class GlyphLayout;
+        Range<int> stringRange, runRange;
         Point<float> lineOrigin;
-        float ascent, descent, leading;
+        float ascent, descent, leading, width;
 
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Line);
+        JUCE_LEAK_DETECTOR (Line);
     };
 
     //==============================================================================
     /** */
-    int getNumLines() const noexcept    { return lines.size(); }
+    int getNumLines() const noexcept                            { return lines.size(); }
+    /** */
+    Line& getLine (int index) const noexcept;
+
+    /** Returns the total number of runs in all the lines. */
+    int getNumRuns() const noexcept                             { return runs.size(); }
+    /** Returns one of the runs from the layout's flat list of runs. */
+    Run& getRun (int index) const noexcept;
+    /** Returns one of the runs in a line, where the index is from 0 to line.getNumRuns(). */
+    Run& getRun (const Line& line, int index) const noexcept;
 
+    /** Returns the total number of glyphs in all the runs. */
+    int getNumGlyphs() const noexcept                           { return glyphCodes.size(); }
     /** */
-    float getTextHeight() const;
+    int getGlyphCode (int glyphIndex) const noexcept            { return glyphCodes.getUnchecked (glyphIndex); }
     /** */
-    Line& getLine (int index) const;
+    const Point<float>& getGlyphAnchor (int glyphIndex) const noexcept  { return glyphAnchors.getReference (glyphIndex); }
 
     /** */
-    void setText (const AttributedString& text);
+    float getTextHeight() const;
 
     /** */
-    void addLine (const Line* line);
-    /** */
-    void ensureStorageAllocated (int numLinesNeeded);
+    void setText (const AttributedString& text);
 
-    /** */
+    /** Updates a layout that was created with setText() after its text has been edited.
+        The changedRange is the range of characters in the new text that were inserted or
+        re-attributed; where possible, only the lines around it are laid out again.
+    */
+    void updateText (const AttributedString& text, const Range<int>& changedRange);
+
+    /** Works out the height and line widths of the layout that setText() would create for a string
+        in an area of the given width, without creating its glyphs where possible.
+        @see AttributedString::measure
+    */
+    static void measureText (const AttributedString& text, float width, AttributedString::Measurement& result);
+
+    /** Removes all the lines, runs and glyphs. */
+    void clear();
+
+    /** Replaces this layout's contents with the lines from another layout, which is left empty.
+        The glyphs are moved by the distance between the positions of the two layouts' areas.
+    */
+    void moveLinesFrom (GlyphLayout& source);
+
+    //==============================================================================
+    /** Appends a line to the layout, and returns a reference to the copy that was added.
+        Any runs added after this will belong to the new line.
+    */
+    Line& addLine (const Line& line);
+
+    /** Appends a run to the last line, and returns a reference to the copy that was added.
+        Any glyphs added after this will belong to the new run.
+    */
+    Run& addRun (const Run& run);
+
+    /** Appends a glyph to the last run. */
+    void addGlyph (int glyphCode, const Point<float>& anchor);
+
+    /** Pre-allocates space for the given number of lines, runs and glyphs. */
+    void ensureStorageAllocated (int numLinesNeeded, int numRunsNeeded, int numGlyphsNeeded);
+
+    /** Draws the layout.
+
+        Only the lines that overlap the graphics context's clip region are drawn. The lines are
+        assumed to be in top-to-bottom order, so that the first one can be found with a binary search.
+    */
     void draw (const Graphics& g) const;
 
     /** */
     const Rectangle<float> area;
 
 private:
-    OwnedArray<Line> lines;
+    Array<Line> lines;
+    Array<Run> runs;
+    Array<int> glyphCodes;
+    Array<Point<float> > glyphAnchors;
+    Array<uint8> bidiLevels; // the embedding level of each character, or empty if the text is all left-to-right
 
     void createStandardLayout (const AttributedString&);
+    void updateStandardLayout (const AttributedString&, const Range<int>& changedRange);
+    static void measureStandardLayout (const AttributedString&, float width, AttributedString::Measurement&);
+    static void measureFullLayout (const AttributedString&, float width, AttributedString::Measurement&);
+    Range<int> updateBidiLevels (const AttributedString&, const Range<int>& changedRange, int lengthDelta);
+    int findLineContaining (int characterIndex) const noexcept;
+    void replaceLines (int startLine, int endLine, GlyphLayout& newLines, int stringDelta, float yDelta);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GlyphLayout);
 };
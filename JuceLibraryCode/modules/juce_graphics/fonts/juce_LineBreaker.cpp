@@ -0,0 +1,524 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+BEGIN_JUCE_NAMESPACE
+
+namespace LineBreakerHelpers
+{
+    // The line-break classes of UAX #14. The classes that the standard leaves to be resolved
+    // by the implementation have been mapped onto these in the table of ranges: AI, SA, SG
+    // and XX became AL (or CM for the marks of the SA scripts), CJ became NS, and HL and CB
+    // are treated as AL and ID.
+    enum BreakClass
+    {
+        OP, CL, CP, QU, GL, NS, EX, SY, IS, PR, PO, NU, AL, ID,
+        IN, HY, BA, BB, B2, ZW, CM, WJ, H2, H3, JL, JV, JT, RI,
+        numPairClasses,  // the classes after this aren't in the pair table
+        BK = numPairClasses, CR, LF, NL, SP
+    };
+
+    struct ClassRange
+    {
+        juce_wchar first, last;
+        uint8 breakClass;
+    };
+
+    // Any character that isn't in one of these ranges is AL. The Hangul syllables are all
+    // listed as H2, but the ones that end with a trailing consonant are actually H3.
+    const ClassRange classRanges[] =
+    {
+        { 0x0000, 0x0008, CM }, { 0x0009, 0x0009, BA }, { 0x000a, 0x000a, LF }, { 0x000b, 0x000c, BK },
+        { 0x000d, 0x000d, CR }, { 0x000e, 0x001f, CM }, { 0x0020, 0x0020, SP }, { 0x0021, 0x0021, EX },
+        { 0x0022, 0x0022, QU }, { 0x0024, 0x0024, PR }, { 0x0025, 0x0025, PO }, { 0x0027, 0x0027, QU },
+        { 0x0028, 0x0028, OP }, { 0x0029, 0x0029, CP }, { 0x002b, 0x002b, PR }, { 0x002c, 0x002c, IS },
+        { 0x002d, 0x002d, HY }, { 0x002e, 0x002e, IS }, { 0x002f, 0x002f, SY }, { 0x0030, 0x0039, NU },
+        { 0x003a, 0x003b, IS }, { 0x003f, 0x003f, EX }, { 0x005b, 0x005b, OP }, { 0x005c, 0x005c, PR },
+        { 0x005d, 0x005d, CP }, { 0x007b, 0x007b, OP }, { 0x007c, 0x007c, BA }, { 0x007d, 0x007d, CL },
+        { 0x007f, 0x0084, CM }, { 0x0085, 0x0085, NL }, { 0x0086, 0x009f, CM }, { 0x00a0, 0x00a0, GL },
+        { 0x00a1, 0x00a1, OP }, { 0x00a2, 0x00a2, PO }, { 0x00a3, 0x00a5, PR }, { 0x00ab, 0x00ab, QU },
+        { 0x00ad, 0x00ad, BA }, { 0x00b0, 0x00b0, PO }, { 0x00b1, 0x00b1, PR }, { 0x00b4, 0x00b4, BB },
+        { 0x00bb, 0x00bb, QU }, { 0x00bf, 0x00bf, OP }, { 0x02c8, 0x02c8, BB }, { 0x02cc, 0x02cc, BB },
+        { 0x02df, 0x02df, BB }, { 0x0300, 0x034e, CM }, { 0x034f, 0x034f, GL }, { 0x0350, 0x035b, CM },
+        { 0x035c, 0x0362, GL }, { 0x0363, 0x036f, CM }, { 0x037e, 0x037e, IS }, { 0x0483, 0x0489, CM },
+        { 0x0589, 0x0589, IS }, { 0x058a, 0x058a, BA }, { 0x0591, 0x05bd, CM }, { 0x05be, 0x05be, BA },
+        { 0x05bf, 0x05bf, CM }, { 0x05c1, 0x05c2, CM }, { 0x05c4, 0x05c5, CM }, { 0x05c6, 0x05c6, EX },
+        { 0x05c7, 0x05c7, CM }, { 0x0609, 0x060b, PO }, { 0x060c, 0x060d, IS }, { 0x0610, 0x061a, CM },
+        { 0x061b, 0x061b, EX }, { 0x061e, 0x061f, EX }, { 0x064b, 0x065f, CM }, { 0x0660, 0x0669, NU },
+        { 0x066a, 0x066a, PO }, { 0x066b, 0x066c, NU }, { 0x0670, 0x0670, CM }, { 0x06d4, 0x06d4, EX },
+        { 0x06d6, 0x06dc, CM }, { 0x06df, 0x06e4, CM }, { 0x06e7, 0x06e8, CM }, { 0x06ea, 0x06ed, CM },
+        { 0x06f0, 0x06f9, NU }, { 0x0711, 0x0711, CM }, { 0x0730, 0x074a, CM }, { 0x07a6, 0x07b0, CM },
+        { 0x07c0, 0x07c9, NU }, { 0x07eb, 0x07f3, CM }, { 0x07f8, 0x07f8, IS }, { 0x07f9, 0x07f9, EX },
+        { 0x0900, 0x0903, CM }, { 0x093a, 0x093c, CM }, { 0x093e, 0x094f, CM }, { 0x0951, 0x0957, CM },
+        { 0x0962, 0x0963, CM }, { 0x0964, 0x0965, BA }, { 0x0966, 0x096f, NU }, { 0x0981, 0x0983, CM },
+        { 0x09bc, 0x09bc, CM }, { 0x09be, 0x09cd, CM }, { 0x09d7, 0x09d7, CM }, { 0x09e2, 0x09e3, CM },
+        { 0x09e6, 0x09ef, NU }, { 0x0a01, 0x0a03, CM }, { 0x0a3c, 0x0a51, CM }, { 0x0a66, 0x0a6f, NU },
+        { 0x0a70, 0x0a71, CM }, { 0x0a75, 0x0a75, CM }, { 0x0a81, 0x0a83, CM }, { 0x0abc, 0x0acd, CM },
+        { 0x0ae2, 0x0ae3, CM }, { 0x0ae6, 0x0aef, NU }, { 0x0b01, 0x0b03, CM }, { 0x0b3c, 0x0b57, CM },
+        { 0x0b62, 0x0b63, CM }, { 0x0b66, 0x0b6f, NU }, { 0x0b82, 0x0b82, CM }, { 0x0bbe, 0x0bd7, CM },
+        { 0x0be6, 0x0bef, NU }, { 0x0c01, 0x0c03, CM }, { 0x0c3e, 0x0c56, CM }, { 0x0c62, 0x0c63, CM },
+        { 0x0c66, 0x0c6f, NU }, { 0x0c82, 0x0c83, CM }, { 0x0cbc, 0x0cd6, CM }, { 0x0ce2, 0x0ce3, CM },
+        { 0x0ce6, 0x0cef, NU }, { 0x0d02, 0x0d03, CM }, { 0x0d3e, 0x0d57, CM }, { 0x0d62, 0x0d63, CM },
+        { 0x0d66, 0x0d6f, NU }, { 0x0d82, 0x0d83, CM }, { 0x0dca, 0x0df3, CM }, { 0x0e31, 0x0e31, CM },
+        { 0x0e34, 0x0e3a, CM }, { 0x0e3f, 0x0e3f, PR }, { 0x0e47, 0x0e4e, CM }, { 0x0e50, 0x0e59, NU },
+        { 0x0e5a, 0x0e5b, BA }, { 0x0eb1, 0x0eb1, CM }, { 0x0eb4, 0x0ebc, CM }, { 0x0ec8, 0x0ecd, CM },
+        { 0x0ed0, 0x0ed9, NU }, { 0x0f01, 0x0f04, BB }, { 0x0f06, 0x0f06, BB }, { 0x0f07, 0x0f08, GL },
+        { 0x0f09, 0x0f09, BB }, { 0x0f0b, 0x0f0b, BA }, { 0x0f0c, 0x0f0c, GL }, { 0x0f0d, 0x0f11, EX },
+        { 0x0f12, 0x0f12, GL }, { 0x0f14, 0x0f14, EX }, { 0x0f18, 0x0f19, CM }, { 0x0f20, 0x0f29, NU },
+        { 0x0f35, 0x0f35, CM }, { 0x0f37, 0x0f37, CM }, { 0x0f39, 0x0f39, CM }, { 0x0f3a, 0x0f3a, OP },
+        { 0x0f3b, 0x0f3b, CL }, { 0x0f3c, 0x0f3c, OP }, { 0x0f3d, 0x0f3d, CL }, { 0x0f3e, 0x0f3f, CM },
+        { 0x0f71, 0x0f84, CM }, { 0x0f86, 0x0f87, CM }, { 0x0f8d, 0x0fbc, CM }, { 0x0fc6, 0x0fc6, CM },
+        { 0x102b, 0x103e, CM }, { 0x1040, 0x1049, NU }, { 0x104a, 0x104b, BA }, { 0x1056, 0x1059, CM },
+        { 0x1100, 0x115f, JL }, { 0x1160, 0x11a7, JV }, { 0x11a8, 0x11ff, JT }, { 0x1361, 0x1361, BA },
+        { 0x1680, 0x1680, BA }, { 0x17b4, 0x17d3, CM }, { 0x17d4, 0x17d5, BA }, { 0x17d8, 0x17d8, BA },
+        { 0x17da, 0x17da, BA }, { 0x17db, 0x17db, PR }, { 0x17dd, 0x17dd, CM }, { 0x17e0, 0x17e9, NU },
+        { 0x1802, 0x1803, EX }, { 0x1804, 0x1805, BA }, { 0x1806, 0x1806, BB }, { 0x1808, 0x1809, EX },
+        { 0x180b, 0x180d, CM }, { 0x180e, 0x180e, GL }, { 0x1810, 0x1819, NU }, { 0x1dc0, 0x1dff, CM },
+        { 0x2000, 0x2006, BA }, { 0x2007, 0x2007, GL }, { 0x2008, 0x200a, BA }, { 0x200b, 0x200b, ZW },
+        { 0x200c, 0x200f, CM }, { 0x2010, 0x2010, BA }, { 0x2011, 0x2011, GL }, { 0x2012, 0x2013, BA },
+        { 0x2014, 0x2014, B2 }, { 0x2018, 0x2019, QU }, { 0x201a, 0x201a, OP }, { 0x201b, 0x201d, QU },
+        { 0x201e, 0x201e, OP }, { 0x201f, 0x201f, QU }, { 0x2024, 0x2026, IN }, { 0x2027, 0x2027, BA },
+        { 0x2028, 0x2029, BK }, { 0x202a, 0x202e, CM }, { 0x202f, 0x202f, GL }, { 0x2030, 0x2037, PO },
+        { 0x2039, 0x203a, QU }, { 0x203c, 0x203d, NS }, { 0x2044, 0x2044, IS }, { 0x2045, 0x2045, OP },
+        { 0x2046, 0x2046, CL }, { 0x2047, 0x2049, NS }, { 0x2056, 0x2056, BA }, { 0x2058, 0x205b, BA },
+        { 0x205d, 0x205f, BA }, { 0x2060, 0x2060, WJ }, { 0x2066, 0x206f, CM }, { 0x207d, 0x207d, OP },
+        { 0x207e, 0x207e, CL }, { 0x208d, 0x208d, OP }, { 0x208e, 0x208e, CL }, { 0x20a0, 0x20a6, PR },
+        { 0x20a7, 0x20a7, PO }, { 0x20a8, 0x20b5, PR }, { 0x20b6, 0x20b6, PO }, { 0x20b7, 0x20cf, PR },
+        { 0x20d0, 0x20f0, CM }, { 0x2103, 0x2103, PO }, { 0x2109, 0x2109, PO }, { 0x2116, 0x2116, PR },
+        { 0x2212, 0x2213, PR }, { 0x2308, 0x2308, OP }, { 0x2309, 0x2309, CL }, { 0x230a, 0x230a, OP },
+        { 0x230b, 0x230b, CL }, { 0x2329, 0x2329, OP }, { 0x232a, 0x232a, CL }, { 0x2768, 0x2768, OP },
+        { 0x2769, 0x2769, CL }, { 0x276a, 0x276a, OP }, { 0x276b, 0x276b, CL }, { 0x276c, 0x276c, OP },
+        { 0x276d, 0x276d, CL }, { 0x276e, 0x276e, OP }, { 0x276f, 0x276f, CL }, { 0x2770, 0x2770, OP },
+        { 0x2771, 0x2771, CL }, { 0x2772, 0x2772, OP }, { 0x2773, 0x2773, CL }, { 0x2774, 0x2774, OP },
+        { 0x2775, 0x2775, CL }, { 0x27c5, 0x27c5, OP }, { 0x27c6, 0x27c6, CL }, { 0x27e6, 0x27e6, OP },
+        { 0x27e7, 0x27e7, CL }, { 0x27e8, 0x27e8, OP }, { 0x27e9, 0x27e9, CL }, { 0x27ea, 0x27ea, OP },
+        { 0x27eb, 0x27eb, CL }, { 0x27ec, 0x27ec, OP }, { 0x27ed, 0x27ed, CL }, { 0x27ee, 0x27ee, OP },
+        { 0x27ef, 0x27ef, CL }, { 0x2983, 0x2983, OP }, { 0x2984, 0x2984, CL }, { 0x2985, 0x2985, OP },
+        { 0x2986, 0x2986, CL }, { 0x2987, 0x2987, OP }, { 0x2988, 0x2988, CL }, { 0x2989, 0x2989, OP },
+        { 0x298a, 0x298a, CL }, { 0x298b, 0x298b, OP }, { 0x298c, 0x298c, CL }, { 0x298d, 0x298d, OP },
+        { 0x298e, 0x298e, CL }, { 0x298f, 0x298f, OP }, { 0x2990, 0x2990, CL }, { 0x2991, 0x2991, OP },
+        { 0x2992, 0x2992, CL }, { 0x2993, 0x2993, OP }, { 0x2994, 0x2994, CL }, { 0x2995, 0x2995, OP },
+        { 0x2996, 0x2996, CL }, { 0x2997, 0x2997, OP }, { 0x2998, 0x2998, CL }, { 0x29d8, 0x29d8, OP },
+        { 0x29d9, 0x29d9, CL }, { 0x29da, 0x29da, OP }, { 0x29db, 0x29db, CL }, { 0x29fc, 0x29fc, OP },
+        { 0x29fd, 0x29fd, CL }, { 0x2cef, 0x2cf1, CM }, { 0x2cf9, 0x2cfc, BA }, { 0x2cfe, 0x2cff, BA },
+        { 0x2de0, 0x2dff, CM }, { 0x2e0e, 0x2e15, BA }, { 0x2e17, 0x2e17, BA }, { 0x2e18, 0x2e18, OP },
+        { 0x2e19, 0x2e19, BA }, { 0x2e22, 0x2e22, OP }, { 0x2e23, 0x2e23, CL }, { 0x2e24, 0x2e24, OP },
+        { 0x2e25, 0x2e25, CL }, { 0x2e26, 0x2e26, OP }, { 0x2e27, 0x2e27, CL }, { 0x2e28, 0x2e28, OP },
+        { 0x2e29, 0x2e29, CL }, { 0x2e2e, 0x2e2e, EX }, { 0x2e30, 0x2e31, BA }, { 0x2e80, 0x2fff, ID },
+        { 0x3000, 0x3000, BA }, { 0x3001, 0x3002, CL }, { 0x3003, 0x3004, ID }, { 0x3005, 0x3005, NS },
+        { 0x3006, 0x3007, ID }, { 0x3008, 0x3008, OP }, { 0x3009, 0x3009, CL }, { 0x300a, 0x300a, OP },
+        { 0x300b, 0x300b, CL }, { 0x300c, 0x300c, OP }, { 0x300d, 0x300d, CL }, { 0x300e, 0x300e, OP },
+        { 0x300f, 0x300f, CL }, { 0x3010, 0x3010, OP }, { 0x3011, 0x3011, CL }, { 0x3012, 0x3013, ID },
+        { 0x3014, 0x3014, OP }, { 0x3015, 0x3015, CL }, { 0x3016, 0x3016, OP }, { 0x3017, 0x3017, CL },
+        { 0x3018, 0x3018, OP }, { 0x3019, 0x3019, CL }, { 0x301a, 0x301a, OP }, { 0x301b, 0x301b, CL },
+        { 0x301c, 0x301c, NS }, { 0x301d, 0x301d, OP }, { 0x301e, 0x301f, CL }, { 0x3020, 0x3029, ID },
+        { 0x302a, 0x302f, CM }, { 0x3030, 0x303a, ID }, { 0x303b, 0x303c, NS }, { 0x303d, 0x3040, ID },
+        { 0x3041, 0x3041, NS }, { 0x3042, 0x3042, ID }, { 0x3043, 0x3043, NS }, { 0x3044, 0x3044, ID },
+        { 0x3045, 0x3045, NS }, { 0x3046, 0x3046, ID }, { 0x3047, 0x3047, NS }, { 0x3048, 0x3048, ID },
+        { 0x3049, 0x3049, NS }, { 0x304a, 0x3062, ID }, { 0x3063, 0x3063, NS }, { 0x3064, 0x3082, ID },
+        { 0x3083, 0x3083, NS }, { 0x3084, 0x3084, ID }, { 0x3085, 0x3085, NS }, { 0x3086, 0x3086, ID },
+        { 0x3087, 0x3087, NS }, { 0x3088, 0x308d, ID }, { 0x308e, 0x308e, NS }, { 0x308f, 0x3094, ID },
+        { 0x3095, 0x3096, NS }, { 0x3097, 0x3098, ID }, { 0x3099, 0x309a, CM }, { 0x309b, 0x309e, NS },
+        { 0x309f, 0x309f, ID }, { 0x30a0, 0x30a1, NS }, { 0x30a2, 0x30a2, ID }, { 0x30a3, 0x30a3, NS },
+        { 0x30a4, 0x30a4, ID }, { 0x30a5, 0x30a5, NS }, { 0x30a6, 0x30a6, ID }, { 0x30a7, 0x30a7, NS },
+        { 0x30a8, 0x30a8, ID }, { 0x30a9, 0x30a9, NS }, { 0x30aa, 0x30c2, ID }, { 0x30c3, 0x30c3, NS },
+        { 0x30c4, 0x30e2, ID }, { 0x30e3, 0x30e3, NS }, { 0x30e4, 0x30e4, ID }, { 0x30e5, 0x30e5, NS },
+        { 0x30e6, 0x30e6, ID }, { 0x30e7, 0x30e7, NS }, { 0x30e8, 0x30ed, ID }, { 0x30ee, 0x30ee, NS },
+        { 0x30ef, 0x30f4, ID }, { 0x30f5, 0x30f6, NS }, { 0x30f7, 0x30fa, ID }, { 0x30fb, 0x30fe, NS },
+        { 0x30ff, 0x31ef, ID }, { 0x31f0, 0x31ff, NS }, { 0x3200, 0x4dbf, ID }, { 0x4e00, 0xa014, ID },
+        { 0xa015, 0xa015, NS }, { 0xa016, 0xa4cf, ID }, { 0xa4fe, 0xa4ff, BA }, { 0xa60d, 0xa60d, BA },
+        { 0xa60e, 0xa60e, EX }, { 0xa60f, 0xa60f, BA }, { 0xa620, 0xa629, NU }, { 0xa66f, 0xa672, CM },
+        { 0xa67c, 0xa67d, CM }, { 0xa802, 0xa802, CM }, { 0xa823, 0xa827, CM }, { 0xa880, 0xa881, CM },
+        { 0xa8b4, 0xa8c4, CM }, { 0xa8ce, 0xa8cf, BA }, { 0xa8d0, 0xa8d9, NU }, { 0xa960, 0xa97c, JL },
+        { 0xac00, 0xd7a3, H2 }, { 0xd7b0, 0xd7c6, JV }, { 0xd7cb, 0xd7fb, JT }, { 0xf900, 0xfaff, ID },
+        { 0xfb1e, 0xfb1e, CM }, { 0xfd3e, 0xfd3e, OP }, { 0xfd3f, 0xfd3f, CL }, { 0xfe00, 0xfe0f, CM },
+        { 0xfe10, 0xfe10, IS }, { 0xfe11, 0xfe12, CL }, { 0xfe13, 0xfe14, IS }, { 0xfe15, 0xfe16, EX },
+        { 0xfe17, 0xfe17, OP }, { 0xfe18, 0xfe18, CL }, { 0xfe19, 0xfe19, IN }, { 0xfe20, 0xfe2f, CM },
+        { 0xfe30, 0xfe34, ID }, { 0xfe35, 0xfe35, OP }, { 0xfe36, 0xfe36, CL }, { 0xfe37, 0xfe37, OP },
+        { 0xfe38, 0xfe38, CL }, { 0xfe39, 0xfe39, OP }, { 0xfe3a, 0xfe3a, CL }, { 0xfe3b, 0xfe3b, OP },
+        { 0xfe3c, 0xfe3c, CL }, { 0xfe3d, 0xfe3d, OP }, { 0xfe3e, 0xfe3e, CL }, { 0xfe3f, 0xfe3f, OP },
+        { 0xfe40, 0xfe40, CL }, { 0xfe41, 0xfe41, OP }, { 0xfe42, 0xfe42, CL }, { 0xfe43, 0xfe43, OP },
+        { 0xfe44, 0xfe44, CL }, { 0xfe45, 0xfe46, ID }, { 0xfe47, 0xfe47, OP }, { 0xfe48, 0xfe48, CL },
+        { 0xfe49, 0xfe4f, ID }, { 0xfe50, 0xfe50, CL }, { 0xfe51, 0xfe51, ID }, { 0xfe52, 0xfe52, CL },
+        { 0xfe54, 0xfe55, NS }, { 0xfe56, 0xfe57, EX }, { 0xfe58, 0xfe58, ID }, { 0xfe59, 0xfe59, OP },
+        { 0xfe5a, 0xfe5a, CL }, { 0xfe5b, 0xfe5b, OP }, { 0xfe5c, 0xfe5c, CL }, { 0xfe5d, 0xfe5d, OP },
+        { 0xfe5e, 0xfe5e, CL }, { 0xfe5f, 0xfe68, ID }, { 0xfe69, 0xfe69, PR }, { 0xfe6a, 0xfe6a, PO },
+        { 0xfe6b, 0xfe6b, ID }, { 0xfeff, 0xfeff, WJ }, { 0xff01, 0xff01, EX }, { 0xff02, 0xff03, ID },
+        { 0xff04, 0xff04, PR }, { 0xff05, 0xff05, PO }, { 0xff06, 0xff07, ID }, { 0xff08, 0xff08, OP },
+        { 0xff09, 0xff09, CL }, { 0xff0a, 0xff0b, ID }, { 0xff0c, 0xff0c, CL }, { 0xff0d, 0xff0d, ID },
+        { 0xff0e, 0xff0e, CL }, { 0xff0f, 0xff19, ID }, { 0xff1a, 0xff1b, NS }, { 0xff1c, 0xff1e, ID },
+        { 0xff1f, 0xff1f, EX }, { 0xff20, 0xff3a, ID }, { 0xff3b, 0xff3b, OP }, { 0xff3c, 0xff3c, ID },
+        { 0xff3d, 0xff3d, CL }, { 0xff3e, 0xff5a, ID }, { 0xff5b, 0xff5b, OP }, { 0xff5c, 0xff5c, ID },
+        { 0xff5d, 0xff5d, CL }, { 0xff5e, 0xff5e, ID }, { 0xff5f, 0xff5f, OP }, { 0xff60, 0xff61, CL },
+        { 0xff62, 0xff62, OP }, { 0xff63, 0xff64, CL }, { 0xff65, 0xff65, NS }, { 0xff66, 0xff66, ID },
+        { 0xff67, 0xff70, NS }, { 0xff71, 0xff9d, ID }, { 0xff9e, 0xff9f, NS }, { 0xffa0, 0xffdc, ID },
+        { 0xffe0, 0xffe0, PO }, { 0xffe1, 0xffe1, PR }, { 0xffe2, 0xffe4, ID }, { 0xffe5, 0xffe6, PR },
+        { 0xfff9, 0xfffb, CM }, { 0xfffc, 0xfffc, ID }, { 0x101fd, 0x101fd, CM }, { 0x104a0, 0x104a9, NU },
+        { 0x1d165, 0x1d169, CM }, { 0x1d16d, 0x1d182, CM }, { 0x1d185, 0x1d18b, CM }, { 0x1d1aa, 0x1d1ad, CM },
+        { 0x1d7ce, 0x1d7ff, NU }, { 0x1f000, 0x1f0ff, ID }, { 0x1f1e6, 0x1f1ff, RI }, { 0x1f200, 0x1faff, ID },
+        { 0x20000, 0x3fffd, ID }, { 0xe0001, 0xe007f, CM }, { 0xe0100, 0xe01ef, CM }
+    };
+
+    // The rule for a break between each pair of classes, indexed by the class before it and then the class after it:
+    //  '_' = the line can be broken between them
+    //  '%' = the line can only be broken if there are spaces between them
+    //  '#' = the character after is a mark that attaches to the one before, unless it follows a space
+    //  '@' = as for '#', but the line can't be broken even if the mark follows a space
+    //  '^' = the line can't be broken, even if there are spaces between them
+    const char* const pairTable[] =
+    {
+        // (the columns are in the same order as the rows)
+        "^^^^^^^^^^^^^^^^^^^^@^^^^^^^",    // OP
+        "_^^%%^^^^%%____%%__^#^______",    // CL
+        "_^^%%^^^^%%%%__%%__^#^______",    // CP
+        "^^^%%%^^^%%%%%%%%%%^#^%%%%%%",    // QU
+        "%^^%%%^^^%%%%%%%%%%^#^%%%%%%",    // GL
+        "_^^%%%^^^______%%__^#^______",    // NS
+        "_^^%%%^^^_____%%%__^#^______",    // EX
+        "_^^%%%^^^__%___%%__^#^______",    // SY
+        "_^^%%%^^^__%%__%%__^#^______",    // IS
+        "%^^%%%^^^__%%%_%%__^#^%%%%%_",    // PR
+        "%^^%%%^^^__%%__%%__^#^______",    // PO
+        "%^^%%%^^^%%%%_%%%__^#^______",    // NU
+        "%^^%%%^^^__%%_%%%__^#^______",    // AL
+        "_^^%%%^^^_%___%%%__^#^______",    // ID
+        "_^^%%%^^^_____%%%__^#^______",    // IN
+        "_^^%_%^^^__%___%%__^#^______",    // HY
+        "_^^%_%^^^______%%__^#^______",    // BA
+        "%^^%%%^^^%%%%%%%%%%^#^%%%%%%",    // BB
+        "_^^%%%^^^______%%_^^#^______",    // B2
+        "___________________^________",    // ZW
+        "%^^%%%^^^__%%_%%%__^#^______",    // CM
+        "%^^%%%^^^%%%%%%%%%%^#^%%%%%%",    // WJ
+        "_^^%%%^^^_%___%%%__^#^___%%_",    // H2
+        "_^^%%%^^^_%___%%%__^#^____%_",    // H3
+        "_^^%%%^^^_%___%%%__^#^%%%%__",    // JL
+        "_^^%%%^^^_%___%%%__^#^___%%_",    // JV
+        "_^^%%%^^^_%___%%%__^#^____%_",    // JT
+        "_^^%%%^^^______%%__^#^_____%",    // RI
+    };
+
+    static int getClassInRange (const ClassRange& range, const juce_wchar c) noexcept
+    {
+        if (range.breakClass == H2 && ((c - 0xac00) % 28) != 0)
+            return H3;
+
+        return range.breakClass;
+    }
+
+    //==============================================================================
+    /** Looks up the line-break classes of characters using a two-stage table.
+
+        The high bits of a character select one of the blocks of the second stage, and the
+        low bits are the index of its class within that block. All the blocks that contain
+        only one class are shared, so the table only takes a few kilobytes. It's built from
+        the list of ranges while the statics are being initialised, rather than the first time
+        that it's needed, because LineBreakers can be used on more than one thread at once.
+    */
+    class ClassTable
+    {
+    public:
+        ClassTable()
+        {
+            int uniformBlocks [numPairClasses + 5];
+
+            for (int i = 0; i < numElementsInArray (uniformBlocks); ++i)
+                uniformBlocks[i] = -1;
+
+            const ClassRange* range = classRanges;
+            const ClassRange* const rangesEnd = classRanges + numElementsInArray (classRanges);
+            uint8 block [blockSize];
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                bool isUniform = true;
+
+                for (int j = 0; j < blockSize; ++j)
+                {
+                    const juce_wchar c = (juce_wchar) ((i << blockBits) + j);
+
+                    while (range != rangesEnd && range->last < c)
+                        ++range;
+
+                    block[j] = (uint8) ((range != rangesEnd && range->first <= c) ? getClassInRange (*range, c) : AL);
+                    isUniform = isUniform && block[j] == block[0];
+                }
+
+                if (isUniform)
+                {
+                    int& index = uniformBlocks [block[0]];
+
+                    if (index < 0)
+                        index = addBlock (block);
+
+                    blockIndexes[i] = (uint16) index;
+                }
+                else
+                {
+                    blockIndexes[i] = (uint16) addBlock (block);
+                }
+            }
+        }
+
+        int getClass (const juce_wchar c) const noexcept
+        {
+            if ((uint32) c < (uint32) (numBlocks << blockBits))
+                return classes.getUnchecked ((blockIndexes [c >> blockBits] << blockBits) + (c & (blockSize - 1)));
+
+            // The planes above the table are nearly all unassigned, so they're just searched
+            int start = 0, end = numElementsInArray (classRanges);
+
+            while (start < end)
+            {
+                const int mid = (start + end) / 2;
+
+                if (classRanges[mid].last < c)
+                    start = mid + 1;
+                else
+                    end = mid;
+            }
+
+            return (start < numElementsInArray (classRanges) && classRanges[start].first <= c)
+                       ? getClassInRange (classRanges[start], c) : AL;
+        }
+
+    private:
+        enum { blockBits = 7, blockSize = 1 << blockBits, numBlocks = 0x40000 >> blockBits };
+
+        uint16 blockIndexes [numBlocks];
+        Array<uint8> classes;
+
+        int addBlock (const uint8* const block)
+        {
+            const int index = classes.size() >> blockBits;
+            classes.addArray (block, blockSize);
+            return index;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (ClassTable);
+    };
+
+    const ClassTable classTable;
+}
+
+//==============================================================================
+LineBreaker::LineBreaker() noexcept
+    : previousClass (-1), previousCharacter (0), previousWasSpace (false)
+{
+}
+
+void LineBreaker::reset() noexcept
+{
+    previousClass = -1;
+    previousCharacter = 0;
+    previousWasSpace = false;
+}
+
+LineBreaker::BreakType LineBreaker::next (const juce_wchar character) noexcept
+{
+    using namespace LineBreakerHelpers;
+    static_jassert ((int) digitClass == (int) NU && (int) letterClass == (int) AL);
+
+    const int breakClass = classTable.getClass (character);
+    BreakType result = noBreak;
+
+    previousCharacter = character;
+
+    if (previousClass == BK || (previousClass == CR && breakClass != LF))
+    {
+        result = mustBreak;
+        previousClass = -1;
+    }
+
+    if (previousClass < 0)
+    {
+        // Spaces at the start of a line stop it being broken before the first word
+        if (breakClass == SP)               previousClass = WJ;
+        else if (breakClass == LF || breakClass == NL)  previousClass = BK;
+        else                                previousClass = breakClass;
+
+        previousWasSpace = false;
+        return result;
+    }
+
+    switch (breakClass)
+    {
+        case BK: case LF: case NL:  previousClass = BK; previousWasSpace = false; return noBreak;
+        case CR:                    previousClass = CR; previousWasSpace = false; return noBreak;
+        case SP:                    previousWasSpace = true; return noBreak;
+        default:                    break;
+    }
+
+    const char rule = pairTable [previousClass][breakClass];
+
+    if (rule == '_')
+    {
+        result = canBreak;
+    }
+    else if (rule == '%')
+    {
+        result = previousWasSpace ? canBreak : noBreak;
+    }
+    else if (rule == '#' || rule == '@')
+    {
+        // A mark takes on the class of the character that it's attached to
+        if (! previousWasSpace)
+            return noBreak;
+
+        result = (rule == '#') ? canBreak : noBreak;
+    }
+
+    previousClass = breakClass;
+    previousWasSpace = false;
+    return result;
+}
+
+bool LineBreaker::isCombiningMark (const juce_wchar character) noexcept
+{
+    return LineBreakerHelpers::classTable.getClass (character) == LineBreakerHelpers::CM;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class LineBreakerTests  : public UnitTest
+{
+public:
+    LineBreakerTests() : UnitTest ("LineBreaker") {}
+
+    // Each character of the expected string is '|' if a line can be broken before the character
+    // at that position in the text, '!' if it has to be, or '.' if it can't be.
+    void expectBreaks (const String& text, const String& expected)
+    {
+        String breaks, breaksWithSkipping;
+
+        {
+            LineBreaker lineBreaker;
+
+            for (String::CharPointerType t (text.getCharPointer()); ! t.isEmpty();)
+                breaks << getSymbol (lineBreaker.next (t.getAndAdvance()));
+        }
+
+        {
+            LineBreaker lineBreaker;
+            String::CharPointerType t (text.getCharPointer());
+
+            for (;;)
+            {
+                breaksWithSkipping << String::repeatedString (".", lineBreaker.skipAsciiRun (t, std::numeric_limits<int>::max()));
+
+                if (t.isEmpty())
+                    break;
+
+                breaksWithSkipping << getSymbol (lineBreaker.next (t.getAndAdvance()));
+            }
+        }
+
+        expectEquals (breaks, expected);
+        expectEquals (breaksWithSkipping, expected);
+    }
+
+    static char getSymbol (const LineBreaker::BreakType type) noexcept
+    {
+        return type == LineBreaker::canBreak ? '|' : (type == LineBreaker::mustBreak ? '!' : '.');
+    }
+
+    static String fromUTF32 (const juce_wchar* const text)
+    {
+        return String (CharPointer_UTF32 (text));
+    }
+
+    void runTest()
+    {
+        beginTest ("Latin text");
+
+        expectBreaks ("The quick (brown) fox.",
+                      "....|.....|.......|...");
+        expectBreaks ("well-known",
+                      ".....|....");
+        expectBreaks ("costs $10.50 or 20%!",
+                      "......|......|..|...");
+        expectBreaks ("\"Quoted\" text",
+                      ".........|...");
+
+        beginTest ("CJK text");
+
+        const juce_wchar japanese[] = { 0x65e5, 0x672c, 0x8a9e, 0x306e, 0x30c6, 0x30ad, 0x30b9, 0x30c8, 0 };
+        expectBreaks (fromUTF32 (japanese), ".|||||||");
+
+        const juce_wchar smallKana[] = { 0x3061, 0x3087, 0x3063, 0x3068, 0 };
+        expectBreaks (fromUTF32 (smallKana), "...|");
+
+        const juce_wchar chinesePunctuation[] = { 0x4e2d, 0x6587, 0xff0c, 0x6d4b, 0x8bd5, 0x3002, 0 };
+        expectBreaks (fromUTF32 (chinesePunctuation), ".|.||.");
+
+        const juce_wchar mixed[] = { 0x65e5, 0x672c, 'a', 'b', 'c', 0x65e5, 0 };
+        expectBreaks (fromUTF32 (mixed), ".||..|");
+
+        beginTest ("Line separators");
+
+        expectBreaks ("a\r\nb",   "...!");
+        expectBreaks ("a\rb",      "..!");
+        expectBreaks ("a\nb",      "..!");
+        expectBreaks ("a\n\nb",   "..!!");
+        expectBreaks ("a \r\n b", "....!.");
+
+        beginTest ("Combining marks");
+
+        const juce_wchar accented[] = { 'e', 0x0301, 't', 'e', 0 };
+        expectBreaks (fromUTF32 (accented), "....");
+
+        const juce_wchar markAfterSpace[] = { 'a', ' ', 0x0301, 'b', 0 };
+        expectBreaks (fromUTF32 (markAfterSpace), "..|.");
+
+        const juce_wchar markAfterIdeograph[] = { 0x65e5, 0x3099, 0x672c, 0 };
+        expectBreaks (fromUTF32 (markAfterIdeograph), "..|");
+
+        expect (LineBreaker::isCombiningMark (0x0301));
+        expect (LineBreaker::isCombiningMark (0x3099));
+        expect (! LineBreaker::isCombiningMark ('a'));
+        expect (! LineBreaker::isCombiningMark (0x65e5));
+
+        beginTest ("ASCII runs");
+
+        LineBreaker lineBreaker;
+        String text ("abcdef  ghi");
+        String::CharPointerType t (text.getCharPointer());
+
+        expectEquals (lineBreaker.skipAsciiRun (t, 100), 0);
+        lineBreaker.next (t.getAndAdvance());
+        expectEquals (lineBreaker.skipAsciiRun (t, 3), 3);
+        expect (*t == 'e');
+        expectEquals (lineBreaker.skipAsciiRun (t, 100), 2);
+        lineBreaker.next (t.getAndAdvance());
+        expectEquals (lineBreaker.skipAsciiRun (t, 100), 1);
+        expect (lineBreaker.next (t.getAndAdvance()) == LineBreaker::canBreak);
+    }
+};
+
+static LineBreakerTests lineBreakerTests;
+
+#endif
+
+END_JUCE_NAMESPACE
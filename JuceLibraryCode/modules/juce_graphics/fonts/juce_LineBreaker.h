@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_LINEBREAKER_JUCEHEADER__
+#define __JUCE_LINEBREAKER_JUCEHEADER__
+
+
+//==============================================================================
+/**
+    Finds the places where a line of text can be wrapped, using the line breaking
+    algorithm of Unicode Standard Annex #14.
+
+    The characters of the text are passed to next() one at a time, and for each one it
+    says whether a line may (or must) be broken before it. This means that words are
+    separated properly in text like Chinese or Japanese that doesn't use spaces, and
+    that punctuation is kept with the word that it belongs to.
+
+    Each character's line-break class is found in a two-stage lookup table, and the
+    rule for each pair of classes in a pair table, so the amount of work done for
+    each character is constant.
+
+    @see GlyphLayout, GlyphArrangement::addJustifiedText
+*/
+class JUCE_API  LineBreaker
+{
+public:
+    /** Creates a LineBreaker that's at the start of a text. */
+    LineBreaker() noexcept;
+
+    //==============================================================================
+    /** The kinds of line-break that next() can return. */
+    enum BreakType
+    {
+        noBreak,        /**< The line mustn't be broken before the character. */
+        canBreak,       /**< The line may be broken before the character. */
+        mustBreak       /**< The line has to be broken before the character, because it follows a line separator. */
+    };
+
+    /** Moves on to the next character of the text, and returns the kind of line-break
+        that's allowed just before it.
+
+        For the first character of a text, this always returns noBreak.
+    */
+    BreakType next (juce_wchar character) noexcept;
+
+    /** Moves a pointer past any ASCII characters that a line couldn't be broken before,
+        without the work of passing each of them to next().
+
+        If the last character passed to next() was an ASCII letter or digit, this skips the
+        letters and digits that follow it, and if it was a space that came after some other
+        character, it skips the spaces that follow. It stops at any other character, or after
+        maxChars characters, and returns the number of characters that it skipped. The
+        LineBreaker is left in the same state as if they'd been passed to next(), which would
+        have returned noBreak for each of them.
+    */
+    template <typename CharPointerType>
+    int skipAsciiRun (CharPointerType& text, const int maxChars) noexcept
+    {
+        int numSkipped = 0;
+
+        if (previousWasSpace)
+        {
+            while (numSkipped < maxChars && *text == ' ')
+            {
+                ++text;
+                ++numSkipped;
+            }
+        }
+        else if (isAsciiLetterOrDigit (previousCharacter))
+        {
+            while (numSkipped < maxChars && isAsciiLetterOrDigit (*text))
+            {
+                previousCharacter = *text;
+                ++text;
+                ++numSkipped;
+            }
+
+            // (the last one decides the class that the next character is paired with)
+            previousClass = (previousCharacter <= '9') ? digitClass : letterClass;
+        }
+
+        return numSkipped;
+    }
+
+    /** Goes back to the start of a text, so the next character is treated as the first one. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Returns true if this character is a mark that combines with the one before it.
+
+        Even when a word is too long to fit on a line and has to be split up anywhere
+        it can be, it should never be split just before one of these.
+    */
+    static bool isCombiningMark (juce_wchar character) noexcept;
+
+private:
+    //==============================================================================
+    int previousClass;
+    juce_wchar previousCharacter;
+    bool previousWasSpace;
+
+    enum { digitClass = 11, letterClass = 12 };   // (the NU and AL classes in LineBreakerHelpers)
+
+    static bool isAsciiLetterOrDigit (const juce_wchar c) noexcept
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+};
+
+
+#endif   // __JUCE_LINEBREAKER_JUCEHEADER__
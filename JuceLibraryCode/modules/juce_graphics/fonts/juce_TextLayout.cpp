@@ -135,52 +135,45 @@ bool TextLayout::isEmpty() const
 void TextLayout::appendText (const String& text, const Font& font)
 {
     String::CharPointerType t (text.getCharPointer());
-    String currentString;
-    int lastCharType = 0;
 
-    for (;;)
+    while (! t.isEmpty())
     {
+        const String::CharPointerType start (t);
         const juce_wchar c = t.getAndAdvance();
-        if (c == 0)
-            break;
+        size_t numChars = 1;
+        bool isWhitespace;
 
-        int charType;
         if (c == '\r' || c == '\n')
         {
-            charType = 0;
-        }
-        else if (CharacterFunctions::isWhitespace (c))
-        {
-            charType = 2;
+            if (c == '\r' && *t == '\n')
+            {
+                ++t;
+                ++numChars;
+            }
+
+            // (a line-break at the very end of the text isn't counted as whitespace)
+            isWhitespace = ! t.isEmpty();
         }
         else
         {
-            charType = 1;
-        }
+            isWhitespace = CharacterFunctions::isWhitespace (c);
 
-        if (charType == 0 || charType != lastCharType)
-        {
-            if (currentString.isNotEmpty())
+            for (;;)
             {
-                tokens.add (new Token (currentString, font,
-                                       lastCharType == 2 || lastCharType == 0));
-            }
+                numChars += CharacterFunctions::skipAsciiRun (t, std::numeric_limits<size_t>::max(), isWhitespace);
 
-            currentString = String::charToString (c);
+                const juce_wchar next = *t;
 
-            if (c == '\r' && *t == '\n')
-                currentString += t.getAndAdvance();
-        }
-        else
-        {
-            currentString += c;
+                if (next == 0 || next == '\r' || next == '\n' || CharacterFunctions::isWhitespace (next) != isWhitespace)
+                    break;
+
+                ++t;
+                ++numChars;
+            }
         }
 
-        lastCharType = charType;
+        tokens.add (new Token (String (start, numChars), font, isWhitespace));
     }
-
-    if (currentString.isNotEmpty())
-        tokens.add (new Token (currentString, font, lastCharType == 2));
 }
 
 void TextLayout::setText (const String& text, const Font& font)
@@ -27,7 +27,7 @@ BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
 Typeface::Typeface (const String& name_) noexcept
-    : name (name_)
+    : name (name_), advanceTable (nullptr), hasCheckedAdvanceTable (false)
 {
 }
 
@@ -52,4 +52,203 @@ EdgeTable* Typeface::getEdgeTableForGlyph (int glyphNumber, const AffineTransfor
     return nullptr;
 }
 
+//==============================================================================
+namespace TypefaceHelpers
+{
+    // Marks a row of pairs that can't be measured with the table, because the typeface
+    // changes the glyphs depending on the characters around them
+    static float unusablePairAdvances [1];
+}
+
+Typeface::AdvanceTable::AdvanceTable (Typeface& typeface_) noexcept
+    : typeface (typeface_)
+{
+}
+
+Typeface::AdvanceTable::~AdvanceTable()
+{
+    for (int i = 0; i < numCharacters; ++i)
+        if (pairAdvances[i].value != TypefaceHelpers::unusablePairAdvances)
+            delete[] pairAdvances[i].value;
+}
+
+bool Typeface::AdvanceTable::build()
+{
+    Array <int> newGlyphs;
+    Array <float> newOffsets;
+    juce_wchar text[2] = { 0 };
+
+    for (int i = 0; i < numCharacters; ++i)
+    {
+        text[0] = (juce_wchar) (firstCharacter + i);
+        newGlyphs.clearQuick();
+        newOffsets.clearQuick();
+        typeface.getGlyphPositions (String (CharPointer_UTF32 (text)), newGlyphs, newOffsets);
+
+        if (newGlyphs.size() != 1 || newOffsets.size() != 2)
+            return false;
+
+        glyphs[i] = newGlyphs.getUnchecked (0);
+        advances[i] = newOffsets.getUnchecked (1) - newOffsets.getUnchecked (0);
+    }
+
+    return true;
+}
+
+float* Typeface::AdvanceTable::measurePairs (const int index)
+{
+    // Each pair is measured on its own, so that the advances are exactly the same as the
+    // ones the typeface would have produced for a longer string
+    float* const row = new float [numCharacters];
+    float* newRow = row;
+
+    Array <int> newGlyphs;
+    Array <float> newOffsets;
+    juce_wchar text[3] = { (juce_wchar) (firstCharacter + index), 0, 0 };
+
+    for (int j = 0; j < numCharacters; ++j)
+    {
+        text[1] = (juce_wchar) (firstCharacter + j);
+        newGlyphs.clearQuick();
+        newOffsets.clearQuick();
+        typeface.getGlyphPositions (String (CharPointer_UTF32 (text)), newGlyphs, newOffsets);
+
+        if (newGlyphs.size() != 2 || newOffsets.size() != 3
+             || newGlyphs.getUnchecked (0) != glyphs[index] || newGlyphs.getUnchecked (1) != glyphs[j])
+        {
+            newRow = TypefaceHelpers::unusablePairAdvances;
+            break;
+        }
+
+        row[j] = newOffsets.getUnchecked (1) - newOffsets.getUnchecked (0);
+    }
+
+    if (newRow != row)
+        delete[] row;
+
+    // If another thread has measured the same row in the meantime, its copy is used instead
+    if (pairAdvances[index].compareAndSetBool (newRow, nullptr))
+        return newRow;
+
+    if (newRow == row)
+        delete[] row;
+
+    return pairAdvances[index].get();
+}
+
+bool Typeface::AdvanceTable::prepare (String::CharPointerType t)
+{
+    juce_wchar c = t.getAndAdvance();
+
+    while (c != 0)
+    {
+        if (! contains (c))
+            return false;
+
+        const juce_wchar next = t.getAndAdvance();
+
+        if (next != 0)
+        {
+            const float* row = pairAdvances [c - firstCharacter].value;
+
+            if (row == nullptr)
+                row = measurePairs (c - firstCharacter);
+
+            if (row == TypefaceHelpers::unusablePairAdvances)
+                return false;
+        }
+
+        c = next;
+    }
+
+    // Makes sure that the contents of the rows are read after the pointers to them
+    Atomic<int>::memoryBarrier();
+    return true;
+}
+
+bool Typeface::AdvanceTable::getGlyphPositions (const String& text, Array <int>& resultGlyphs, Array<float>& xOffsets)
+{
+    String::CharPointerType t (text.getCharPointer());
+
+    if (! prepare (t))
+        return false;
+
+    const int numChars = (int) t.length();
+    resultGlyphs.ensureStorageAllocated (resultGlyphs.size() + numChars);
+    xOffsets.ensureStorageAllocated (xOffsets.size() + numChars + 1);
+    xOffsets.add (0);
+
+    float x = 0;
+    juce_wchar c = t.getAndAdvance();
+
+    while (c != 0)
+    {
+        const juce_wchar next = t.getAndAdvance();
+        x += getAdvance (c, next);
+        resultGlyphs.add (getGlyph (c));
+        xOffsets.add (x);
+        c = next;
+    }
+
+    return true;
+}
+
+bool Typeface::AdvanceTable::getStringWidth (const String& text, float& width)
+{
+    String::CharPointerType t (text.getCharPointer());
+
+    if (! prepare (t))
+        return false;
+
+    float x = 0;
+    juce_wchar c = t.getAndAdvance();
+
+    while (c != 0)
+    {
+        const juce_wchar next = t.getAndAdvance();
+        x += getAdvance (c, next);
+        c = next;
+    }
+
+    width = x;
+    return true;
+}
+
+Typeface::AdvanceTable* Typeface::getAdvanceTable()
+{
+    {
+        const SpinLock::ScopedLockType sl (advanceTableLock);
+
+        if (hasCheckedAdvanceTable)
+            return advanceTable;
+    }
+
+    // The table is built without holding the lock, because measuring the characters may
+    // make the typeface load glyphs, and a subclass may call resetAdvanceTable() while it does so.
+    ScopedPointer<AdvanceTable> newTable (new AdvanceTable (*this));
+
+    if (! newTable->build())
+        newTable = nullptr;
+
+    const SpinLock::ScopedLockType sl (advanceTableLock);
+
+    if (! hasCheckedAdvanceTable)
+    {
+        advanceTable = newTable.release();
+        hasCheckedAdvanceTable = true;
+
+        if (advanceTable != nullptr)
+            advanceTables.add (advanceTable);
+    }
+
+    return advanceTable;
+}
+
+void Typeface::resetAdvanceTable()
+{
+    const SpinLock::ScopedLockType sl (advanceTableLock);
+    hasCheckedAdvanceTable = false;
+    advanceTable = nullptr;
+}
+
 END_JUCE_NAMESPACE
@@ -45,9 +45,12 @@ class AffineTransform;
     Normally you should never need to deal directly with Typeface objects - the Font
     class does everything you typically need for rendering text.
 
+    A typeface may be used by more than one thread at a time, so subclasses must make
+    sure that their measuring and outline methods are safe to call concurrently.
+
     @see CustomTypeface, Font
 */
-class JUCE_API  Typeface  : public SingleThreadedReferenceCountedObject
+class JUCE_API  Typeface  : public ReferenceCountedObject
 {
 public:
     //==============================================================================
@@ -74,6 +77,21 @@ public:
     */
     virtual bool isSuitableForFont (const Font&) const          { return true; }
 
+    /** Returns a number that identifies the font file that this typeface's glyphs come from,
+        so that glyphs rendered from it can be kept between runs.
+        The value must change if the file does. The default returns 0, which means that the
+        typeface can't be identified and its rendered glyphs won't be kept. Only the glyphs that
+        hasGlyph() says the typeface contains are kept, so a typeface that returns a value must
+        use the characters as its glyph numbers.
+    */
+    virtual int64 getFontFileHash() const                       { return 0; }
+
+    /** Returns true if the typeface contains a glyph for the given character.
+        This is used to choose between a font's fallback typefaces. The default returns true,
+        for typefaces that can't tell.
+    */
+    virtual bool hasGlyph (juce_wchar /*character*/)            { return true; }
+
     /** Returns the ascent of the font, as a proportion of its height.
         The height is considered to always be normalised as 1.0, so this will be a
         value less that 1.0, indicating the proportion of the font that lies above
@@ -116,6 +134,77 @@ public:
     /** Returns true if the typeface uses hinting. */
     virtual bool isHinted() const                           { return false; }
 
+    //==============================================================================
+    /**
+        A dense table of the glyph numbers and advance widths of the printable ASCII
+        characters, including the kerning between every pair of them.
+
+        The kerning of the pairs that begin with a particular character is only measured the
+        first time that character is followed by another one. Once an entry has been measured
+        it never changes, so any number of threads can use the table to measure text without
+        locking. Like the typeface's own measurements, its distances are based on a normalised
+        font height of 1.0, so one table serves every size of the font.
+
+        A table belongs to its typeface and is deleted along with it, so it can be used for as
+        long as the caller keeps a reference to the typeface.
+
+        @see getAdvanceTable, Font::getGlyphPositions
+    */
+    class JUCE_API  AdvanceTable
+    {
+    public:
+        /** Destructor. */
+        ~AdvanceTable();
+
+        /** Returns true if the table has an entry for the given character. */
+        static bool contains (const juce_wchar c) noexcept      { return (uint32) (c - firstCharacter) < (uint32) numCharacters; }
+
+        /** Returns the glyph number for a character. */
+        int getGlyph (const juce_wchar c) const noexcept        { return glyphs [c - firstCharacter]; }
+
+        /** Does the same job as Typeface::getGlyphPositions().
+            If any of the characters can't be measured with the table, this returns false
+            without changing the arrays.
+        */
+        bool getGlyphPositions (const String& text, Array <int>& glyphs, Array<float>& xOffsets);
+
+        /** Does the same job as Typeface::getStringWidth().
+            If any of the characters can't be measured with the table, this returns false.
+        */
+        bool getStringWidth (const String& text, float& width);
+
+    private:
+        enum { firstCharacter = 32, numCharacters = 95 };
+
+        Typeface& typeface;
+        int glyphs [numCharacters];
+        float advances [numCharacters];
+        Atomic<float*> pairAdvances [numCharacters];
+
+        friend class Typeface;
+        explicit AdvanceTable (Typeface&) noexcept;
+        bool build();
+        bool prepare (String::CharPointerType text);
+        float* measurePairs (int index);
+
+        float getAdvance (const juce_wchar c, const juce_wchar next) const noexcept
+        {
+            return next == 0 ? advances [c - firstCharacter]
+                             : pairAdvances [c - firstCharacter].value [next - firstCharacter];
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (AdvanceTable);
+    };
+
+    /** Returns a table of the typeface's ASCII glyphs and advances, building it the first time
+        it's needed.
+
+        This returns nullptr if the typeface can't be measured with a table, e.g. if it's missing
+        some of the characters. The table stays valid for as long as the typeface does, even if
+        the typeface discards it in the meantime.
+    */
+    AdvanceTable* getAdvanceTable();
+
     //==============================================================================
     /** Changes the number of fonts that are cached in memory. */
     static void setTypefaceCacheSize (int numFontsToCache);
@@ -128,7 +217,19 @@ protected:
 
     static Ptr getFallbackTypeface();
 
+    /** Discards the advance table, so that it'll be rebuilt when it's next needed.
+        A subclass must call this if the glyphs or kerning of its ASCII characters are changed
+        after it has been used. Threads that are already measuring text with the old table can
+        carry on using it, so it isn't deleted until the typeface is.
+    */
+    void resetAdvanceTable();
+
 private:
+    OwnedArray<AdvanceTable> advanceTables;  // the current table, and any that have been discarded
+    AdvanceTable* advanceTable;
+    SpinLock advanceTableLock;
+    bool hasCheckedAdvanceTable;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Typeface);
 };
 
@@ -161,6 +161,67 @@ EdgeTable::EdgeTable (const RectangleList& rectanglesToAdd)
     sanitiseLevels (true);
 }
 
+EdgeTable::EdgeTable (const Rectangle<int>& area, const uint8* const mask, const int maskLineStride)
+   : bounds (area),
+     maxEdgesPerLine (1),
+     lineStrideElements (3),
+     needToCheckEmptinesss (true)
+{
+    const int width = bounds.getWidth();
+
+    // find the line with the most changes of level, so that the table only needs allocating once..
+    for (int y = 0; y < bounds.getHeight(); ++y)
+    {
+        const uint8* m = mask + y * maskLineStride;
+        int numEdges = 0, lastLevel = 0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            if (m[x] != lastLevel)
+            {
+                lastLevel = m[x];
+                ++numEdges;
+            }
+        }
+
+        if (lastLevel != 0)
+            ++numEdges;
+
+        maxEdgesPerLine = jmax (maxEdgesPerLine, numEdges);
+    }
+
+    lineStrideElements = (maxEdgesPerLine << 1) + 1;
+    table.malloc ((size_t) jmax (1, bounds.getHeight()) * lineStrideElements);
+    table[0] = 0;
+
+    int* t = table;
+
+    for (int y = 0; y < bounds.getHeight(); ++y)
+    {
+        const uint8* m = mask + y * maskLineStride;
+        int destIndex = 0, lastLevel = 0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            if (m[x] != lastLevel)
+            {
+                lastLevel = m[x];
+                t[++destIndex] = (bounds.getX() + x) << 8;
+                t[++destIndex] = lastLevel;
+            }
+        }
+
+        if (lastLevel != 0)
+        {
+            t[++destIndex] = bounds.getRight() << 8;
+            t[++destIndex] = 0;
+        }
+
+        t[0] = destIndex >> 1;
+        t += lineStrideElements;
+    }
+}
+
 EdgeTable::EdgeTable (const Rectangle<float>& rectangleToAdd)
    : bounds (Rectangle<int> ((int) std::floor (rectangleToAdd.getX()),
                              roundToInt (rectangleToAdd.getY() * 256.0f) >> 8,
@@ -393,6 +454,11 @@ void EdgeTable::addEdgePoint (const int x, const int y, const int winding)
     line[0]++;
 }
 
+size_t EdgeTable::getAllocatedSize() const noexcept
+{
+    return (size_t) (jmax (1, bounds.getHeight()) + 1) * (size_t) lineStrideElements * sizeof (int);
+}
+
 void EdgeTable::translate (float dx, const int dy) noexcept
 {
     bounds.translate ((int) std::floor (dx), dy);
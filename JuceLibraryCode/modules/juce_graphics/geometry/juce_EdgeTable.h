@@ -65,6 +65,14 @@ public:
     /** Creates an edge table containing a rectangle. */
     explicit EdgeTable (const Rectangle<float>& rectangleToAdd);
 
+    /** Creates an edge table from an 8-bit mask of alpha levels.
+
+        @param area             the area that the mask covers
+        @param mask             the top-left pixel of the mask, which has one byte per pixel
+        @param maskLineStride   the number of bytes between the starts of the mask's lines
+    */
+    EdgeTable (const Rectangle<int>& area, const uint8* mask, int maskLineStride);
+
     /** Creates a copy of another edge table. */
     EdgeTable (const EdgeTable& other);
 
@@ -83,6 +91,9 @@ public:
     const Rectangle<int>& getMaximumBounds() const noexcept      { return bounds; }
     void translate (float dx, int dy) noexcept;
 
+    /** Returns the number of bytes that the table has allocated for its data. */
+    size_t getAllocatedSize() const noexcept;
+
     /** Reduces the amount of space the table has allocated.
 
         This will shrink the table down to use as little memory as possible - useful for
@@ -89,6 +89,7 @@
 #include "fonts/juce_Font.cpp"
 #include "fonts/juce_GlyphArrangement.cpp"
 #include "fonts/juce_GlyphLayout.cpp"
+#include "fonts/juce_LineBreaker.cpp"
 #include "fonts/juce_TextLayout.cpp"
 #include "fonts/juce_Typeface.cpp"
 #include "effects/juce_DropShadowEffect.cpp"
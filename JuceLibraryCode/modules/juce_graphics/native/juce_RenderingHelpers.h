@@ -135,14 +135,33 @@ private:
 };
 
 //==============================================================================
+/** A cache of rendered glyphs, shared by all the contexts of one type of renderer.
+
+    The glyphs are found through a hash table keyed on their typeface, size and glyph number,
+    and the least-recently used ones are discarded when the cache grows beyond its memory limit.
+    The table is split into independently-locked shards, so that several threads can render
+    text at the same time.
+
+    Each glyph can be cached at a few different horizontal subpixel offsets, so that text laid
+    out at fractional positions keeps its spacing, but can still be drawn at whole pixels.
+    Glyphs that are scaled, rotated or sheared are cached too, keyed on their transform's
+    matrix after it has been rounded to a fine grid.
+
+    The CachedGlyphType must be a ReferenceCountedObject that has these methods:
+    @code
+    // (the transform is applied after the glyph has been scaled to the font's size)
+    void generate (const Font& font, int glyphNumber, const AffineTransform& transform);
+    void draw (RenderTargetType& target, int x, int y) const;
+    size_t getMemorySize() const noexcept;
+    @endcode
+*/
 template <class CachedGlyphType, class RenderTargetType>
 class GlyphCache  : private DeletedAtShutdown
 {
 public:
     GlyphCache()
-        : accessCounter (0), hits (0), misses (0)
+        : maxMemoryPerShard (defaultMemoryLimit / numShards)
     {
-        addNewGlyphSlots (120);
     }
 
     ~GlyphCache()
@@ -161,55 +180,309 @@ public:
     }
 
     //==============================================================================
+    typedef ReferenceCountedObjectPtr<CachedGlyphType> GlyphPtr;
+
     void drawGlyph (RenderTargetType& target, const Font& font, const int glyphNumber, float x, float y)
     {
-        ++accessCounter;
-        int oldestCounter = std::numeric_limits<int>::max();
-        CachedGlyphType* oldest = nullptr;
+        int glyphX;
+        const int phase = getSubpixelPhase (x, glyphX);
+
+        getGlyph (font, glyphNumber, phase)->draw (target, glyphX, roundToInt (y));
+    }
+
+    /** Draws a glyph with a transform that may scale, rotate or shear it as well as moving it.
+
+        The transform is applied after the glyph has been scaled to the font's size. If the glyph
+        would be too big to be worth keeping, nothing is drawn and this returns false.
+    */
+    bool drawTransformedGlyph (RenderTargetType& target, const Font& font, const int glyphNumber, const AffineTransform& transform)
+    {
+        const float maxScale = jmax (std::abs (transform.mat00) + std::abs (transform.mat01),
+                                     std::abs (transform.mat10) + std::abs (transform.mat11));
+
+        if (font.getHeight() * maxScale > (float) maxTransformedGlyphSize)
+            return false;
+
+        int glyphX, glyphY;
+        const int phaseX = getSubpixelPhase (transform.getTranslationX(), glyphX);
+        const int phaseY = getSubpixelPhase (transform.getTranslationY(), glyphY);
+
+        getGlyph (Key (font, glyphNumber, phaseX + phaseY * numSubpixelPhases, transform), font, glyphNumber)
+            ->draw (target, glyphX, glyphY);
+
+        return true;
+    }
+
+    /** Finds or creates the glyph that has been rendered at the given subpixel phase. */
+    GlyphPtr getGlyph (const Font& font, const int glyphNumber, const int phase)
+    {
+        return getGlyph (Key (font, glyphNumber, phase, AffineTransform::identity), font, glyphNumber);
+    }
+
+    /** Splits an x position into a whole pixel and the phase of the glyph variant
+        that should be drawn there.
+    */
+    static int getSubpixelPhase (const float x, int& wholePixelX) noexcept
+    {
+        wholePixelX = (int) std::floor (x);
+        const int phase = roundToInt ((x - (float) wholePixelX) * (float) numSubpixelPhases);
+
+        if (phase < numSubpixelPhases)
+            return phase;
+
+        ++wholePixelX;
+        return 0;
+    }
+
+    /** Changes the number of bytes that the cached glyphs may use before the least-recently
+        used ones start being discarded.
+    */
+    void setMemoryLimit (const size_t maxNumBytes)
+    {
+        maxMemoryPerShard = jmax ((size_t) 1, maxNumBytes / numShards);
+
+        for (int i = 0; i < numShards; ++i)
+            shards[i].trim (maxMemoryPerShard);
+    }
+
+private:
+    //==============================================================================
+    enum { numShards = 8 };
+    enum { numSubpixelPhases = 4 };
+    enum { defaultMemoryLimit = 4 * 1024 * 1024 };
+    enum { maxTransformedGlyphSize = 256 };
+    enum { matrixResolution = 4096 };
+
+    struct Key
+    {
+        Key (const Font& font, const int glyphNumber_, const int subpixelPhase_, const AffineTransform& transform) noexcept
+            : typeface (font.getTypeface()),
+              height (font.getHeight()),
+              horizontalScale (font.getHorizontalScale()),
+              glyphNumber (glyphNumber_),
+              subpixelPhase (subpixelPhase_)
+        {
+            matrix[0] = roundToInt (transform.mat00 * matrixResolution);
+            matrix[1] = roundToInt (transform.mat01 * matrixResolution);
+            matrix[2] = roundToInt (transform.mat10 * matrixResolution);
+            matrix[3] = roundToInt (transform.mat11 * matrixResolution);
+
+            const uint64 typefaceAddress = (uint64) (pointer_sized_uint) typeface;
+
+            uint32 h = 2166136261u;
+            h = (h ^ (uint32) typefaceAddress) * 16777619u;
+            h = (h ^ (uint32) (typefaceAddress >> 32)) * 16777619u;
+            h = (h ^ getBits (height)) * 16777619u;
+            h = (h ^ getBits (horizontalScale)) * 16777619u;
+            h = (h ^ (uint32) glyphNumber) * 16777619u;
+            h = (h ^ (uint32) subpixelPhase) * 16777619u;
+
+            for (int i = 0; i < 4; ++i)
+                h = (h ^ (uint32) matrix[i]) * 16777619u;
+
+            // Mix the bits thoroughly, because the top ones are used to choose the shard
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35u;
+            hash = h ^ (h >> 16);
+        }
+
+        bool operator== (const Key& other) const noexcept
+        {
+            return glyphNumber == other.glyphNumber
+                    && subpixelPhase == other.subpixelPhase
+                    && typeface == other.typeface
+                    && height == other.height
+                    && horizontalScale == other.horizontalScale
+                    && matrix[0] == other.matrix[0] && matrix[1] == other.matrix[1]
+                    && matrix[2] == other.matrix[2] && matrix[3] == other.matrix[3];
+        }
+
+        /** Returns the rounded transform, moved by the key's subpixel offset. */
+        AffineTransform getGlyphTransform() const noexcept
+        {
+            const float scale = 1.0f / matrixResolution;
 
-        for (int i = glyphs.size(); --i >= 0;)
+            return AffineTransform (matrix[0] * scale, matrix[1] * scale, (subpixelPhase % numSubpixelPhases) / (float) numSubpixelPhases,
+                                    matrix[2] * scale, matrix[3] * scale, (subpixelPhase / numSubpixelPhases) / (float) numSubpixelPhases);
+        }
+
+        int getShardIndex() const noexcept      { return (int) (hash >> 29); }
+
+        Typeface* typeface;
+        float height, horizontalScale;
+        int glyphNumber, subpixelPhase;
+        int matrix[4];
+        uint32 hash;
+
+    private:
+        static uint32 getBits (const float value) noexcept
+        {
+            union { float asFloat; uint32 asInt; } u;
+            u.asFloat = value;
+            return u.asInt;
+        }
+    };
+
+    struct KeyHashFunction
+    {
+        static int generateHash (const Key& key, const int upperLimit) noexcept
         {
-            CachedGlyphType* const glyph = glyphs.getUnchecked (i);
+            return (int) (key.hash % (uint32) upperLimit);
+        }
+    };
 
-            if (glyph->glyph == glyphNumber && glyph->font == font)
+    struct Entry
+    {
+        Entry (const Key& key_, const GlyphPtr& glyph_)
+            : key (key_), typeface (key_.typeface), glyph (glyph_),
+              memorySize (sizeof (Entry) + glyph_->getMemorySize()),
+              moreRecent (nullptr), lessRecent (nullptr)
+        {
+        }
+
+        Key key;
+        Typeface::Ptr typeface; // keeps the typeface alive, so its address can't be re-used while it's in a key
+        GlyphPtr glyph;
+        size_t memorySize;
+        Entry* moreRecent;
+        Entry* lessRecent;
+
+        JUCE_DECLARE_NON_COPYABLE (Entry);
+    };
+
+    //==============================================================================
+    class Shard
+    {
+    public:
+        Shard() noexcept
+            : mostRecent (nullptr), leastRecent (nullptr), memoryUsed (0)
+        {
+        }
+
+        ~Shard()
+        {
+            while (mostRecent != nullptr)
             {
-                ++hits;
-                glyph->lastAccessCount = accessCounter;
-                glyph->draw (target, x, y);
-                return;
+                Entry* const e = mostRecent;
+                mostRecent = e->lessRecent;
+                delete e;
             }
+        }
+
+        GlyphPtr find (const Key& key)
+        {
+            const ScopedLock sl (lock);
+            Entry* const e = entries [key];
 
-            if (glyph->lastAccessCount <= oldestCounter)
+            if (e == nullptr)
+                return nullptr;
+
+            moveToFront (e);
+            return e->glyph;
+        }
+
+        GlyphPtr add (const Key& key, const GlyphPtr& glyph, const size_t maxMemory)
+        {
+            const ScopedLock sl (lock);
+            Entry* e = entries [key];
+
+            if (e == nullptr)
+            {
+                e = new Entry (key, glyph);
+                entries.set (key, e);
+                memoryUsed += e->memorySize;
+                linkAtFront (e);
+                trimLocked (maxMemory);
+            }
+            else
             {
-                oldestCounter = glyph->lastAccessCount;
-                oldest = glyph;
+                // another thread has added the same glyph while this one was rendering it
+                moveToFront (e);
             }
+
+            return e->glyph;
         }
 
-        if (hits + ++misses > (glyphs.size() << 4))
+        void trim (const size_t maxMemory)
         {
-            if (misses * 2 > hits)
-                addNewGlyphSlots (32);
+            const ScopedLock sl (lock);
+            trimLocked (maxMemory);
+        }
+
+    private:
+        CriticalSection lock;
+        HashMap<Key, Entry*, KeyHashFunction> entries;
+        Entry* mostRecent;
+        Entry* leastRecent;
+        size_t memoryUsed;
 
-            hits = misses = 0;
-            oldest = glyphs.getLast();
+        void trimLocked (const size_t maxMemory)
+        {
+            // (the most recently used glyph is always kept, even if it's bigger than the limit)
+            while (memoryUsed > maxMemory && leastRecent != mostRecent)
+            {
+                Entry* const e = leastRecent;
+                unlink (e);
+                entries.remove (e->key);
+                memoryUsed -= e->memorySize;
+                delete e;
+            }
         }
 
-        jassert (oldest != nullptr);
-        oldest->lastAccessCount = accessCounter;
-        oldest->generate (font, glyphNumber);
-        oldest->draw (target, x, y);
-    }
+        void moveToFront (Entry* const e) noexcept
+        {
+            if (e != mostRecent)
+            {
+                unlink (e);
+                linkAtFront (e);
+            }
+        }
 
-private:
-    friend class OwnedArray <CachedGlyphType>;
-    OwnedArray <CachedGlyphType> glyphs;
-    int accessCounter, hits, misses;
+        void linkAtFront (Entry* const e) noexcept
+        {
+            e->moreRecent = nullptr;
+            e->lessRecent = mostRecent;
 
-    void addNewGlyphSlots (int num)
+            if (mostRecent != nullptr)
+                mostRecent->moreRecent = e;
+            else
+                leastRecent = e;
+
+            mostRecent = e;
+        }
+
+        void unlink (Entry* const e) noexcept
+        {
+            if (e->moreRecent != nullptr)   e->moreRecent->lessRecent = e->lessRecent;
+            else                            mostRecent = e->lessRecent;
+
+            if (e->lessRecent != nullptr)   e->lessRecent->moreRecent = e->moreRecent;
+            else                            leastRecent = e->moreRecent;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (Shard);
+    };
+
+    Shard shards [numShards];
+    size_t maxMemoryPerShard;
+
+    GlyphPtr getGlyph (const Key& key, const Font& font, const int glyphNumber)
     {
-        while (--num >= 0)
-            glyphs.add (new CachedGlyphType());
+        Shard& shard = shards [key.getShardIndex()];
+        GlyphPtr glyph (shard.find (key));
+
+        if (glyph == nullptr)
+        {
+            // The glyph is rendered without holding the shard's lock, so that other
+            // threads can carry on drawing the glyphs that it already contains.
+            glyph = new CachedGlyphType();
+            glyph->generate (font, glyphNumber, key.getGlyphTransform());
+            glyph = shard.add (key, glyph, maxMemoryPerShard);
+        }
+
+        return glyph;
     }
 
     static GlyphCache*& getSingletonPointer() noexcept
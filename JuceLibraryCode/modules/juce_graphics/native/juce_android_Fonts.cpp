@@ -218,3 +218,19 @@ Typeface::Ptr Typeface::createSystemTypefaceFor (const Font& font)
 {
     return new AndroidTypeface (font);
 }
+
+void GlyphLayout::setText (const AttributedString& text)
+{
+    clear();
+    createStandardLayout (text);
+}
+
+void GlyphLayout::updateText (const AttributedString& text, const Range<int>& changedRange)
+{
+    updateStandardLayout (text, changedRange);
+}
+
+void GlyphLayout::measureText (const AttributedString& text, const float width, AttributedString::Measurement& result)
+{
+    measureStandardLayout (text, width, result);
+}
@@ -42,6 +42,11 @@ struct FTLibWrapper     : public ReferenceCountedObject
 
     FT_Library library;
 
+    /** FreeType doesn't allow faces to be created or destroyed on more than one thread at once
+        when they share a library, so this must be held while doing either.
+    */
+    CriticalSection lock;
+
     typedef ReferenceCountedObjectPtr <FTLibWrapper> Ptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FTLibWrapper);
@@ -50,21 +55,29 @@ struct FTLibWrapper     : public ReferenceCountedObject
 //==============================================================================
 struct FTFaceWrapper     : public ReferenceCountedObject
 {
-    FTFaceWrapper (const FTLibWrapper::Ptr& ftLib, const File& file, int faceIndex)
-        : face (0), library (ftLib)
+    FTFaceWrapper (const FTLibWrapper::Ptr& ftLib, const File& file_, int faceIndex_)
+        : face (0), library (ftLib), file (file_), faceIndex (faceIndex_)
     {
+        const ScopedLock sl (ftLib->lock);
+
         if (FT_New_Face (ftLib->library, file.getFullPathName().toUTF8(), faceIndex, &face) != 0)
             face = 0;
     }
 
     ~FTFaceWrapper()
     {
+        // (the last reference to a face can be dropped on any thread)
         if (face != 0)
+        {
+            const ScopedLock sl (library->lock);
             FT_Done_Face (face);
+        }
     }
 
     FT_Face face;
     FTLibWrapper::Ptr library;
+    const File file;
+    const int faceIndex;
 
     typedef ReferenceCountedObjectPtr <FTFaceWrapper> Ptr;
 
@@ -104,7 +117,7 @@ public:
     {
         if (iter != nullptr)
         {
-            while (iter->next())
+            while (iter->next (nullptr, nullptr, nullptr, &modificationTime, nullptr, nullptr))
                 if (getFile().hasFileExtension ("ttf;pfb;pcf"))
                     return true;
         }
@@ -116,12 +129,14 @@ public:
         return next();
     }
 
-    File getFile() const    { jassert (iter != nullptr); return iter->getFile(); }
+    File getFile() const                    { jassert (iter != nullptr); return iter->getFile(); }
+    Time getModificationTime() const        { return modificationTime; }
 
 private:
     StringArray fontDirs;
     int index;
     ScopedPointer<DirectoryIterator> iter;
+    Time modificationTime;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinuxFontFileIterator);
 };
@@ -133,29 +148,64 @@ public:
     FTTypefaceList()
         : library (new FTLibWrapper())
     {
+        // The faces found by earlier runs are loaded from an index file, so that only the
+        // font files that have changed since then need to be opened with FreeType. The font
+        // directories are still listed, to find each file's modification time.
+        FontIndex index;
+        const File indexFile (FontIndex::getIndexFile());
+        index.read (indexFile);
+
+        MemoryOutputStream newIndex;
+        newIndex.writeInt (FontIndex::fileMagic);
+        bool indexHasChanged = false;
+        int numFiles = 0;
+        HashMap<String, int> filesFound;
+
         LinuxFontFileIterator fontFileIterator;
 
         while (fontFileIterator.next())
         {
-            int faceIndex = 0;
-            int numFaces = 0;
+            const File file (fontFileIterator.getFile());
+
+            // A file can be reached more than once if one font directory is inside another,
+            // but the index only holds one record for each path.
+            if (filesFound.contains (file.getFullPathName()))
+                continue;
 
-            do
+            filesFound.set (file.getFullPathName(), 0);
+            const int64 modificationTime = fontFileIterator.getModificationTime().toMilliseconds();
+            const int firstFace = faces.size();
+
+            if (! index.getFaces (file, modificationTime, faces))
             {
-                FTFaceWrapper face (library, fontFileIterator.getFile(), faceIndex);
+                scanFontFile (file);
+                indexHasChanged = true;
+            }
 
-                if (face.face != 0)
-                {
-                    if (faceIndex == 0)
-                        numFaces = face.face->num_faces;
+            FontIndex::writeFile (newIndex, file, modificationTime, faces, firstFace);
+            ++numFiles;
+        }
 
-                    if ((face.face->face_flags & FT_FACE_FLAG_SCALABLE) != 0)
-                        faces.add (new KnownTypeface (fontFileIterator.getFile(), faceIndex, face));
-                }
+        if (indexHasChanged || numFiles != index.getNumFiles())
+        {
+            newIndex.writeByte (0);
+            newIndex.writeInt (numFiles);
 
-                ++faceIndex;
+            indexFile.getParentDirectory().createDirectory();
+            indexFile.replaceWithData (newIndex.getData(), newIndex.getDataSize());
+        }
+
+        for (int i = 0; i < faces.size(); ++i)
+        {
+            const KnownTypeface* const face = faces.getUnchecked(i);
+
+            if (! familyIndexes.contains (face->family))
+            {
+                familyIndexes.set (face->family, families.size());
+                families.add (new Array<const KnownTypeface*>());
             }
-            while (faceIndex < numFaces);
+
+            families.getUnchecked (familyIndexes [face->family])->add (face);
         }
     }
 
@@ -178,6 +228,18 @@ public:
         {
         }
 
+        KnownTypeface (const File& file_, const int faceIndex_, const String& family_,
+                       const bool isBold_, const bool isItalic_, const bool isMonospaced_)
+           : file (file_),
+             family (family_),
+             faceIndex (faceIndex_),
+             isBold (isBold_),
+             isItalic (isItalic_),
+             isMonospaced (isMonospaced_),
+             isSansSerif (isFaceSansSerif (family))
+        {
+        }
+
         const File file;
         const String family;
         const int faceIndex;
@@ -224,8 +286,8 @@ public:
     //==============================================================================
     void getFamilyNames (StringArray& familyNames) const
     {
-        for (int i = 0; i < faces.size(); i++)
-            familyNames.addIfNotAlreadyThere (faces.getUnchecked(i)->family);
+        for (int i = 0; i < families.size(); i++)
+            familyNames.addIfNotAlreadyThere (families.getUnchecked(i)->getFirst()->family);
     }
 
     void getMonospacedNames (StringArray& monoSpaced) const
@@ -249,22 +311,180 @@ public:
                 sansSerif.addIfNotAlreadyThere (faces.getUnchecked(i)->family);
     }
 
-    juce_DeclareSingleton_SingleThreaded_Minimal (FTTypefaceList);
+    juce_DeclareSingleton (FTTypefaceList, false);
 
 private:
     FTLibWrapper::Ptr library;
     OwnedArray<KnownTypeface> faces;
+    OwnedArray<Array<const KnownTypeface*> > families;
+    HashMap<String, int> familyIndexes;
+
+    //==============================================================================
+    /** The list of faces that was saved by an earlier run.
+
+        The file holds a magic number, and then a record for each font file, giving its path,
+        modification time and the details of its scalable faces. It ends with an empty path and the
+        number of files that it contains.
+    */
+    class FontIndex
+    {
+    public:
+        FontIndex() {}
+
+        enum { fileMagic = 0x3178646a };  // "jdx1"
+
+        static File getIndexFile()
+        {
+            const String path (CharPointer_UTF8 (getenv ("JUCE_FONT_INDEX")));
+
+            return path.isNotEmpty() ? File (path)
+                                     : File ("~/.cache/juce_font_index");
+        }
+
+        void read (const File& indexFile)
+        {
+            MemoryMappedFile mappedFile (indexFile, MemoryMappedFile::readOnly);
+
+            if (mappedFile.getData() != nullptr)
+            {
+                MemoryInputStream in (mappedFile.getData(), mappedFile.getSize(), false);
+
+                if (in.readInt() == fileMagic)
+                {
+                    for (;;)
+                    {
+                        const String path (in.readString());
+
+                        if (path.isEmpty() || in.isExhausted())
+                            break;
+
+                        FileRecord record;
+                        record.modificationTime = in.readInt64();
+                        record.firstFace = cachedFaces.size();
+
+                        for (int i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+                        {
+                            const String family (in.readString());
+                            const int faceIndex = in.readInt();
+                            const int flags = in.readByte();
+
+                            cachedFaces.add (new KnownTypeface (File (path), faceIndex, family,
+                                                                (flags & boldFlag) != 0,
+                                                                (flags & italicFlag) != 0,
+                                                                (flags & monospacedFlag) != 0));
+                        }
+
+                        record.numFaces = cachedFaces.size() - record.firstFace;
+                        files.set (path, record);
+                    }
+
+                    // an index that was cut short can't be trusted
+                    if (in.readInt() != files.size())
+                    {
+                        files.clear();
+                        cachedFaces.clear();
+                    }
+                }
+            }
+        }
+
+        int getNumFiles() const noexcept        { return files.size(); }
+
+        /** Copies the faces for a file into a list, if the file hasn't changed since it was indexed. */
+        bool getFaces (const File& file, const int64 modificationTime, OwnedArray<KnownTypeface>& results) const
+        {
+            const String path (file.getFullPathName());
+
+            if (! files.contains (path))
+                return false;
+
+            const FileRecord record (files [path]);
+
+            if (record.modificationTime != modificationTime)
+                return false;
+
+            for (int i = 0; i < record.numFaces; ++i)
+            {
+                const KnownTypeface* const face = cachedFaces.getUnchecked (record.firstFace + i);
+                results.add (new KnownTypeface (file, face->faceIndex, face->family,
+                                                face->isBold, face->isItalic, face->isMonospaced));
+            }
+
+            return true;
+        }
+
+        static void writeFile (OutputStream& out, const File& file, const int64 modificationTime,
+                               const OwnedArray<KnownTypeface>& faces, const int firstFace)
+        {
+            out.writeString (file.getFullPathName());
+            out.writeInt64 (modificationTime);
+            out.writeInt (faces.size() - firstFace);
+
+            for (int i = firstFace; i < faces.size(); ++i)
+            {
+                const KnownTypeface* const face = faces.getUnchecked(i);
+
+                out.writeString (face->family);
+                out.writeInt (face->faceIndex);
+                out.writeByte ((char) ((face->isBold ? boldFlag : 0)
+                                        | (face->isItalic ? italicFlag : 0)
+                                        | (face->isMonospaced ? monospacedFlag : 0)));
+            }
+        }
+
+    private:
+        struct FileRecord
+        {
+            FileRecord() noexcept : modificationTime (0), firstFace (0), numFaces (0) {}
+
+            int64 modificationTime;
+            int firstFace, numFaces;
+        };
+
+        enum { boldFlag = 1, italicFlag = 2, monospacedFlag = 4 };
+
+        HashMap<String, FileRecord> files;
+        OwnedArray<KnownTypeface> cachedFaces;
+
+        JUCE_DECLARE_NON_COPYABLE (FontIndex);
+    };
+
+    void scanFontFile (const File& file)
+    {
+        int faceIndex = 0;
+        int numFaces = 0;
+
+        do
+        {
+            FTFaceWrapper face (library, file, faceIndex);
+
+            if (face.face != 0)
+            {
+                if (faceIndex == 0)
+                    numFaces = face.face->num_faces;
+
+                if ((face.face->face_flags & FT_FACE_FLAG_SCALABLE) != 0)
+                    faces.add (new KnownTypeface (file, faceIndex, face));
+            }
+
+            ++faceIndex;
+        }
+        while (faceIndex < numFaces);
+    }
 
     const KnownTypeface* matchTypeface (const String& familyName, const bool wantBold, const bool wantItalic) const noexcept
     {
-        for (int i = 0; i < faces.size(); ++i)
+        if (familyIndexes.contains (familyName))
         {
-            const KnownTypeface* const face = faces.getUnchecked(i);
+            const Array<const KnownTypeface*>& family = *families.getUnchecked (familyIndexes [familyName]);
 
-            if (face->family == familyName
-                  && face->isBold == wantBold
-                  && face->isItalic == wantItalic)
-                return face;
+            for (int i = 0; i < family.size(); ++i)
+            {
+                const KnownTypeface* const face = family.getUnchecked(i);
+
+                if (face->isBold == wantBold && face->isItalic == wantItalic)
+                    return face;
+            }
         }
 
         return nullptr;
@@ -284,7 +504,7 @@ private:
     JUCE_DECLARE_NON_COPYABLE (FTTypefaceList);
 };
 
-juce_ImplementSingleton_SingleThreaded (FTTypefaceList)
+juce_ImplementSingleton (FTTypefaceList)
 
 
 //==============================================================================
@@ -293,14 +513,23 @@ class FreeTypeTypeface   : public CustomTypeface
 public:
     FreeTypeTypeface (const Font& font)
         : faceWrapper (FTTypefaceList::getInstance()
-                           ->createFace (font.getTypefaceName(), font.isBold(), font.isItalic()))
+                           ->createFace (font.getTypefaceName(), font.isBold(), font.isItalic())),
+          fontFileHash (0),
+          hasFallbackFonts (font.getFallbackFontNames().size() > 0)
     {
         if (faceWrapper != nullptr)
         {
+            const File& file = faceWrapper->file;
+            fontFileHash = (file.getFullPathName() + ":" + String (faceWrapper->faceIndex)
+                              + ":" + String (file.getSize())
+                              + ":" + String (file.getLastModificationTime().toMilliseconds())).hashCode64();
+
             setCharacteristics (font.getTypefaceName(),
                                 faceWrapper->face->ascender / (float) (faceWrapper->face->ascender - faceWrapper->face->descender),
                                 font.isBold(), font.isItalic(),
                                 L' ');
+
+            setFallbackFontNames (font.getFallbackFontNames());
         }
         else
         {
@@ -309,6 +538,11 @@ public:
         }
     }
 
+    int64 getFontFileHash() const
+    {
+        return fontFileHash;
+    }
+
     bool loadGlyphIfPossible (const juce_wchar character)
     {
         if (faceWrapper != nullptr)
@@ -316,6 +550,12 @@ public:
             FT_Face face = faceWrapper->face;
             const unsigned int glyphIndex = FT_Get_Char_Index (face, character);
 
+            // A character that the face doesn't contain would get its .notdef glyph, so if there's
+            // a fallback typeface that might have it, it's reported as missing instead.
+            if (glyphIndex == 0 && (hasFallbackFonts || (Font::getFallbackFontName().isNotEmpty()
+                                                           && Font::getFallbackFontName() != getName())))
+                return false;
+
             if (FT_Load_Glyph (face, glyphIndex, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP | FT_LOAD_IGNORE_TRANSFORM) == 0
                   && face->glyph->format == ft_glyph_format_outline)
             {
@@ -325,10 +565,7 @@ public:
                 if (getGlyphShape (destShape, face->glyph->outline, scale))
                 {
                     addGlyph (character, destShape, face->glyph->metrics.horiAdvance * scale);
-
-                    if ((face->face_flags & FT_FACE_FLAG_KERNING) != 0)
-                        addKerning (face, character, glyphIndex);
-
+                    glyphIndexes.set ((int) character, (int) glyphIndex);
                     return true;
                 }
             }
@@ -337,8 +574,150 @@ public:
         return false;
     }
 
+    float getKerningForPair (const juce_wchar char1, const juce_wchar char2)
+    {
+        // This is only called while the typeface's read lock is held, so the glyph indexes
+        // can't be changed by loadGlyphIfPossible() while they're being read.
+        if (faceWrapper == nullptr || ! FT_HAS_KERNING (faceWrapper->face)
+             || ! glyphIndexes.contains ((int) char1) || ! glyphIndexes.contains ((int) char2))
+            return 0;
+
+        const uint32 leftGlyph  = (uint32) glyphIndexes [(int) char1];
+        const uint32 rightGlyph = (uint32) glyphIndexes [(int) char2];
+
+        // Glyph indexes are 16-bit in the sfnt fonts that have kerning, so each pair fits in a
+        // 32-bit key. (Zero is the .notdef glyph, which never has any kerning).
+        if (leftGlyph == 0 || rightGlyph == 0 || leftGlyph > 0xffff || rightGlyph > 0xffff)
+            return 0;
+
+        const uint32 glyphPair = (leftGlyph << 16) | rightGlyph;
+        float amount;
+
+        if (kerningCache.find (glyphPair, amount))
+            return amount;
+
+        // Several threads can be reading the typeface at once, so the face is only asked for
+        // a pair's kerning by one of them at a time.
+        const ScopedLock sl (kerningLock);
+
+        if (kerningCache.find (glyphPair, amount))
+            return amount;
+
+        FT_Face face = faceWrapper->face;
+        FT_Vector kerning;
+        amount = 0;
+
+        if (FT_Get_Kerning (face, leftGlyph, rightGlyph, ft_kerning_unscaled, &kerning) == 0)
+            amount = kerning.x / (float) (face->ascender - face->descender);
+
+        kerningCache.add (glyphPair, amount);
+        return amount;
+    }
+
 private:
+    //==============================================================================
+    /** A hash table of the kerning amounts that have been looked up, keyed on their pair of glyphs.
+
+        Any number of threads can search it without locking, while one thread at a time adds
+        entries to it. An entry's amount is written before its key, and neither ever changes
+        after that. When the table is half full, it's copied into a new one twice the size, and
+        the old one is kept until the typeface is deleted in case a thread is still searching it.
+    */
+    class KerningCache
+    {
+    public:
+        KerningCache()  : numEntries (0)
+        {
+            table = new Table (256);
+            tables.add (table.value);
+        }
+
+        bool find (const uint32 glyphPair, float& amount) const noexcept
+        {
+            const Table* const t = table.value;
+            Atomic<int>::memoryBarrier();
+
+            for (int i = t->getFirstSlot (glyphPair);; i = (i + 1) & t->mask)
+            {
+                const uint32 key = t->keys[i];
+
+                if (key == 0)
+                    return false;
+
+                if (key == glyphPair)
+                {
+                    Atomic<int>::memoryBarrier();
+                    amount = t->amounts[i];
+                    return true;
+                }
+            }
+        }
+
+        void add (const uint32 glyphPair, const float amount)
+        {
+            if (2 * (numEntries + 1) > table.value->mask + 1)
+            {
+                const Table* const oldTable = table.value;
+                Table* const newTable = new Table (2 * (oldTable->mask + 1));
+                tables.add (newTable);
+
+                for (int i = 0; i <= oldTable->mask; ++i)
+                    if (oldTable->keys[i] != 0)
+                        newTable->add (oldTable->keys[i], oldTable->amounts[i]);
+
+                table = newTable;
+            }
+
+            table.value->add (glyphPair, amount);
+            ++numEntries;
+        }
+
+    private:
+        struct Table
+        {
+            Table (const int numSlots)  : amounts ((size_t) numSlots), mask (numSlots - 1)
+            {
+                keys.calloc ((size_t) numSlots);
+            }
+
+            int getFirstSlot (const uint32 glyphPair) const noexcept
+            {
+                const uint32 h = glyphPair * 2654435761u;
+                return (int) ((h ^ (h >> 16)) & (uint32) mask);
+            }
+
+            void add (const uint32 glyphPair, const float amount) noexcept
+            {
+                int i = getFirstSlot (glyphPair);
+
+                while (keys[i] != 0)
+                    i = (i + 1) & mask;
+
+                amounts[i] = amount;
+                Atomic<int>::memoryBarrier();
+                keys[i] = glyphPair;
+            }
+
+            HeapBlock<uint32> keys;
+            HeapBlock<float> amounts;
+            const int mask;
+
+            JUCE_DECLARE_NON_COPYABLE (Table);
+        };
+
+        OwnedArray<Table> tables;
+        Atomic<Table*> table;
+        int numEntries;
+
+        JUCE_DECLARE_NON_COPYABLE (KerningCache);
+    };
+
     FTFaceWrapper::Ptr faceWrapper;
+    int64 fontFileHash;
+    const bool hasFallbackFonts;
+    HashMap<int, int> glyphIndexes;
+    CriticalSection kerningLock;
+    KerningCache kerningCache;
 
     bool getGlyphShape (Path& destShape, const FT_Outline& outline, const float scaleX)
     {
@@ -427,25 +806,6 @@ private:
         return true;
     }
 
-    void addKerning (FT_Face face, const uint32 character, const uint32 glyphIndex)
-    {
-        const float height = (float) (face->ascender - face->descender);
-
-        uint32 rightGlyphIndex;
-        uint32 rightCharCode = FT_Get_First_Char (face, &rightGlyphIndex);
-
-        while (rightGlyphIndex != 0)
-        {
-            FT_Vector kerning;
-
-            if (FT_Get_Kerning (face, glyphIndex, rightGlyphIndex, ft_kerning_unscaled, &kerning) == 0
-                   && kerning.x != 0)
-                addKerningPair (character, rightCharCode, kerning.x / height);
-
-            rightCharCode = FT_Get_Next_Char (face, rightCharCode, &rightGlyphIndex);
-        }
-    }
-
     JUCE_DECLARE_NON_COPYABLE (FreeTypeTypeface);
 };
 
@@ -542,3 +902,19 @@ Typeface::Ptr Font::getDefaultTypefaceForFont (const Font& font)
     f.setTypefaceName (faceName);
     return Typeface::createSystemTypefaceFor (f);
 }
+
+void GlyphLayout::setText (const AttributedString& text)
+{
+    clear();
+    createStandardLayout (text);
+}
+
+void GlyphLayout::updateText (const AttributedString& text, const Range<int>& changedRange)
+{
+    updateStandardLayout (text, changedRange);
+}
+
+void GlyphLayout::measureText (const AttributedString& text, const float width, AttributedString::Measurement& result)
+{
+    measureStandardLayout (text, width, result);
+}
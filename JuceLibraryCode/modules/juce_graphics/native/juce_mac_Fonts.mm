@@ -186,7 +186,7 @@ namespace CoreTextTypeLayout
         CFArrayRef lines = CTFrameGetLines (frame);
         const CFIndex numLines = CFArrayGetCount (lines);
 
-        glyphLayout.ensureStorageAllocated (numLines);
+        glyphLayout.ensureStorageAllocated ((int) numLines, 0, text.getText().length());
 
         for (CFIndex i = 0; i < numLines; ++i)
         {
@@ -205,11 +205,11 @@ namespace CoreTextTypeLayout
             Point<float> lineOrigin ((float) cgpLineOrigin.x, glyphLayout.area.getHeight() - (float) cgpLineOrigin.y);
 
             CGFloat ascent, descent, leading;
-            CTLineGetTypographicBounds (line, &ascent,  &descent, &leading);
+            const double lineWidth = CTLineGetTypographicBounds (line, &ascent,  &descent, &leading);
 
-            GlyphLayout::Line* const glyphLine = new GlyphLayout::Line ((int) numRuns, lineStringRange, lineOrigin,
-                                                                        (float) ascent, (float) descent, (float) leading);
-            glyphLayout.addLine (glyphLine);
+            GlyphLayout::Line& glyphLine = glyphLayout.addLine (GlyphLayout::Line (lineStringRange, lineOrigin,
+                                                                                   (float) ascent, (float) descent, (float) leading));
+            glyphLine.setWidth ((float) lineWidth);
 
             for (CFIndex j = 0; j < numRuns; ++j)
             {
@@ -218,10 +218,8 @@ namespace CoreTextTypeLayout
                 const CFRange runStringRange = CTRunGetStringRange (run);
                 const CFIndex runStringEnd = runStringRange.location + runStringRange.length - 1;
 
-                GlyphLayout::Run* const glyphRun = new GlyphLayout::Run ((int) numGlyphs,
-                                                                         Range<int> ((int) runStringRange.location,
-                                                                                     (int) runStringEnd));
-                glyphLine->addRun (glyphRun);
+                GlyphLayout::Run& glyphRun = glyphLayout.addRun (GlyphLayout::Run (Range<int> ((int) runStringRange.location,
+                                                                                               (int) runStringEnd)));
 
                 CFDictionaryRef runAttributes = CTRunGetAttributes (run);
 
@@ -240,7 +238,7 @@ namespace CoreTextTypeLayout
                     const float fontHeightToCGSizeFactor = CGFontGetUnitsPerEm (cgFontRef) / (float) totalHeight;
                     CGFontRelease (cgFontRef);
 
-                    glyphRun->setFont (Font (fontName, CTFontGetSize (ctRunFont) / fontHeightToCGSizeFactor, 0));
+                    glyphRun.setFont (Font (fontName, CTFontGetSize (ctRunFont) / fontHeightToCGSizeFactor, 0));
                 }
 
                 CGColorRef cgRunColor;
@@ -249,7 +247,7 @@ namespace CoreTextTypeLayout
                 {
                     const CGFloat* const components = CGColorGetComponents (cgRunColor);
 
-                    glyphRun->setColour (Colour::fromFloatRGBA (components[0], components[1], components[2], components[3]));
+                    glyphRun.setColour (Colour::fromFloatRGBA (components[0], components[1], components[2], components[3]));
                 }
 
                 const CGGlyph* glyphsPtr = CTRunGetGlyphsPtr (run);
@@ -269,11 +267,10 @@ namespace CoreTextTypeLayout
                     CTRunGetPositions (run, CFRangeMake (0, 0), positionBuffer);
                 }
 
-                const Point<float> linePos (glyphLayout.area.getPosition() + glyphLine->getLineOrigin());
+                const Point<float> linePos (glyphLayout.area.getPosition() + glyphLine.getLineOrigin());
 
                 for (CFIndex k = 0; k < numGlyphs; ++k)
-                    glyphRun->addGlyph (new GlyphLayout::Glyph (glyphsPtr[k], linePos.translated (posPtr[k].x,
-                                                                                                  posPtr[k].y)));
+                    glyphLayout.addGlyph (glyphsPtr[k], linePos.translated (posPtr[k].x, posPtr[k].y));
             }
         }
 
@@ -1032,9 +1029,30 @@ Typeface::Ptr Font::getDefaultTypefaceForFont (const Font& font)
 
 void GlyphLayout::setText (const AttributedString& text)
 {
+    clear();
+
    #if JUCE_CORETEXT_AVAILABLE
     CoreTextTypeLayout::createLayout (*this, text);
    #else
     createStandardLayout (text);
    #endif
 }
+
+void GlyphLayout::updateText (const AttributedString& text, const Range<int>& changedRange)
+{
+   #if JUCE_CORETEXT_AVAILABLE
+    (void) changedRange;
+    setText (text);
+   #else
+    updateStandardLayout (text, changedRange);
+   #endif
+}
+
+void GlyphLayout::measureText (const AttributedString& text, const float width, AttributedString::Measurement& result)
+{
+   #if JUCE_CORETEXT_AVAILABLE
+    measureFullLayout (text, width, result);
+   #else
+    measureStandardLayout (text, width, result);
+   #endif
+}
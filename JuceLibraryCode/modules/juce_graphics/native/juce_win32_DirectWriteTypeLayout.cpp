@@ -26,10 +26,28 @@
 class CustomDirectWriteTextRenderer   : public ComBaseClassHelper <IDWriteTextRenderer>
 {
 public:
-    CustomDirectWriteTextRenderer()
-        : currentLine (-1),
-          lastOriginY (-10000.0f)
+    CustomDirectWriteTextRenderer (const DWRITE_LINE_METRICS* const lineMetrics, const int numLines)
+        : currentLine (-1)
     {
+        lineStringRanges.ensureStorageAllocated (numLines);
+        lineBaselines.ensureStorageAllocated (numLines);
+        lineAscents.ensureStorageAllocated (numLines);
+        lineDescents.ensureStorageAllocated (numLines);
+
+        int lineStart = 0;
+        float lineTop = 0.0f;
+
+        for (int i = 0; i < numLines; ++i)
+        {
+            lineStringRanges.add (Range<int> (lineStart, lineStart + (int) lineMetrics[i].length));
+            lineBaselines.add (lineTop + lineMetrics[i].baseline);
+            lineAscents.add (lineMetrics[i].baseline);
+            lineDescents.add (lineMetrics[i].height - lineMetrics[i].baseline);
+
+            lineStart += (int) lineMetrics[i].length;
+            lineTop += lineMetrics[i].height;
+        }
+
         resetReferenceCount();
     }
 
@@ -61,45 +79,53 @@ public:
     {
         GlyphLayout* const glyphLayout = static_cast<GlyphLayout*> (clientDrawingContext);
 
-        if (baselineOriginY != lastOriginY)
+        // The runs arrive in line order, but an empty line has no runs, so the line that this
+        // run belongs to is found from its string position rather than from its baseline
+        int lineIndex = jmax (0, currentLine);
+
+        while (lineIndex < lineStringRanges.size() - 1
+                && (int) runDescription->textPosition >= lineStringRanges.getReference (lineIndex).getEnd())
+            ++lineIndex;
+
+        if (lineIndex > currentLine)
         {
-            lastOriginY = baselineOriginY;
+            addLinesUpTo (*glyphLayout, lineIndex - 1);
             ++currentLine;
 
             // The x value is only correct when dealing with LTR text
-            glyphLayout->getLine (currentLine)
-                .setLineOrigin (Point<float> (baselineOriginX - glyphLayout->area.getX(),
-                                              baselineOriginY - glyphLayout->area.getY()));
+            glyphLayout->addLine (GlyphLayout::Line (lineStringRanges [currentLine],
+                                                     Point<float> (baselineOriginX - glyphLayout->area.getX(),
+                                                                   baselineOriginY - glyphLayout->area.getY()),
+                                                     0.0f, 0.0f, 0.0f));
         }
 
-        if (currentLine < 0)
-            return S_OK;
-
         GlyphLayout::Line& glyphLine = glyphLayout->getLine (currentLine);
 
         DWRITE_FONT_METRICS dwFontMetrics;
         glyphRun->fontFace->GetMetrics (&dwFontMetrics);
 
+        const float ascent  = (std::abs ((float) dwFontMetrics.ascent)  / (float) dwFontMetrics.designUnitsPerEm) * glyphRun->fontEmSize;
         const float descent = (std::abs ((float) dwFontMetrics.descent) /  (float) dwFontMetrics.designUnitsPerEm) * glyphRun->fontEmSize;
 
+        if (ascent > glyphLine.getAscent())
+            glyphLine.setAscent (ascent);
+
         if (descent > glyphLine.getDescent())
             glyphLine.setDescent (descent);
 
         int styleFlags = 0;
         const String fontName (getFontName (glyphRun, styleFlags));
 
-        GlyphLayout::Run* const glyphRunLayout = new GlyphLayout::Run (glyphRun->glyphCount,
-                                                                       Range<int> (runDescription->textPosition,
-                                                                                   runDescription->textPosition + runDescription->stringLength));
-        glyphLine.addRun (glyphRunLayout);
+        GlyphLayout::Run& glyphRunLayout = glyphLayout->addRun (GlyphLayout::Run (Range<int> (runDescription->textPosition,
+                                                                                              runDescription->textPosition + runDescription->stringLength)));
 
         glyphRun->fontFace->GetMetrics (&dwFontMetrics);
 
         const float totalHeight = std::abs ((float) dwFontMetrics.ascent) + std::abs ((float) dwFontMetrics.descent);
         const float fontHeightToEmSizeFactor = (float) dwFontMetrics.designUnitsPerEm / totalHeight;
 
-        glyphRunLayout->setFont (Font (fontName, glyphRun->fontEmSize / fontHeightToEmSizeFactor, styleFlags));
-        glyphRunLayout->setColour (getColourOf (clientDrawingEffect));
+        glyphRunLayout.setFont (Font (fontName, glyphRun->fontEmSize / fontHeightToEmSizeFactor, styleFlags));
+        glyphRunLayout.setColour (getColourOf (clientDrawingEffect));
 
         float x = baselineOriginX;
 
@@ -108,19 +134,40 @@ public:
             if ((glyphRun->bidiLevel & 1) != 0)
                 x -= glyphRun->glyphAdvances[i];  // RTL text
 
-            glyphRunLayout->addGlyph (new GlyphLayout::Glyph (glyphRun->glyphIndices[i], Point<float> (x, baselineOriginY)));
+            glyphLayout->addGlyph (glyphRun->glyphIndices[i], Point<float> (x, baselineOriginY));
 
             if ((glyphRun->bidiLevel & 1) == 0)
                 x += glyphRun->glyphAdvances[i];  // LTR text
         }
 
+        const float runEnd = jmax (x, baselineOriginX) - glyphLayout->area.getX() - glyphLine.getLineOrigin().getX();
+
+        if (runEnd > glyphLine.getWidth())
+            glyphLine.setWidth (runEnd);
+
         return S_OK;
     }
 
+    /** Adds any lines up to and including lastLine that haven't been reached by a glyph run. */
+    void addLinesUpTo (GlyphLayout& glyphLayout, const int lastLine)
+    {
+        while (currentLine < lastLine)
+        {
+            ++currentLine;
+
+            glyphLayout.addLine (GlyphLayout::Line (lineStringRanges [currentLine],
+                                                    Point<float> (0.0f, lineBaselines [currentLine]),
+                                                    lineAscents [currentLine], lineDescents [currentLine], 0.0f));
+        }
+    }
+
+    int getNumLines() const noexcept    { return lineStringRanges.size(); }
+
 private:
     UINT refCount;
+    Array<Range<int> > lineStringRanges;
+    Array<float> lineBaselines, lineAscents, lineDescents;
     int currentLine;
-    float lastOriginY;
 
     static Colour getColourOf (IUnknown* clientDrawingEffect)
     {
@@ -298,34 +345,47 @@ namespace DirectWriteTypeLayout
         UINT32 actualLineCount = 0;
         hr = dwTextLayout->GetLineMetrics (nullptr, 0, &actualLineCount);
 
-        glyphLayout.ensureStorageAllocated (actualLineCount);
+        glyphLayout.ensureStorageAllocated ((int) actualLineCount, 0, textLen);
 
         HeapBlock <DWRITE_LINE_METRICS> dwLineMetrics (actualLineCount);
         hr = dwTextLayout->GetLineMetrics (dwLineMetrics, actualLineCount, &actualLineCount);
-        int lastLocation = 0;
 
-        for (UINT32 i = 0; i < actualLineCount; ++i)
-        {
-            const Range<int> lineStringRange (lastLocation, (int) lastLocation + dwLineMetrics[i].length);
-            lastLocation = dwLineMetrics[i].length;
-
-            GlyphLayout::Line* glyphLine = new GlyphLayout::Line();
-            glyphLayout.addLine (glyphLine);
-            glyphLine->setStringRange (lineStringRange);
-        }
-
-        ComSmartPtr<CustomDirectWriteTextRenderer> textRenderer = new CustomDirectWriteTextRenderer();
+        // The lines are added to the layout by the renderer as it reaches them, because
+        // each line's runs have to follow it in the layout's run list
+        ComSmartPtr<CustomDirectWriteTextRenderer> textRenderer = new CustomDirectWriteTextRenderer (dwLineMetrics, (int) actualLineCount);
         hr = dwTextLayout->Draw (&glyphLayout,
                                  textRenderer,
                                  glyphLayout.area.getX(),
                                  glyphLayout.area.getY());
+
+        // ..and any empty lines at the end, which have no glyph runs to add them
+        textRenderer->addLinesUpTo (glyphLayout, textRenderer->getNumLines() - 1);
     }
 }
 
 void GlyphLayout::setText (const AttributedString& text)
 {
+    clear();
+
     if (SharedDirectWriteFactory::getInstance()->isAvailable)
         DirectWriteTypeLayout::createLayout (*this, text);
     else
         createStandardLayout (text);
 }
+
+void GlyphLayout::updateText (const AttributedString& text, const Range<int>& changedRange)
+{
+    // DirectWrite has to lay out the whole paragraph again
+    if (SharedDirectWriteFactory::getInstance()->isAvailable)
+        setText (text);
+    else
+        updateStandardLayout (text, changedRange);
+}
+
+void GlyphLayout::measureText (const AttributedString& text, const float width, AttributedString::Measurement& result)
+{
+    if (SharedDirectWriteFactory::getInstance()->isAvailable)
+        measureFullLayout (text, width, result);
+    else
+        measureStandardLayout (text, width, result);
+}
@@ -165,6 +165,8 @@ public:
 
     float getStringWidth (const String& text)
     {
+        const ScopedLock sl (lock);
+
         const CharPointer_UTF16 utf16 (text.toUTF16());
         const size_t numChars = utf16.length();
         HeapBlock<int16> results (numChars + 1);
@@ -183,6 +185,8 @@ public:
 
     void getGlyphPositions (const String& text, Array <int>& resultGlyphs, Array <float>& xOffsets)
     {
+        const ScopedLock sl (lock);
+
         const CharPointer_UTF16 utf16 (text.toUTF16());
         const size_t numChars = utf16.length();
         HeapBlock<int16> results (numChars + 1);
@@ -208,6 +212,8 @@ public:
 
     bool getOutlineForGlyph (int glyphNumber, Path& glyphPath)
     {
+        const ScopedLock sl (lock);
+
         if (glyphNumber < 0)
             glyphNumber = defaultGlyph;
 
@@ -279,6 +285,7 @@ private:
     HFONT fontH;
     HGDIOBJ previousFontH;
     HDC dc;
+    CriticalSection lock;   // guards the DC and the lazily-built kerning pairs
     TEXTMETRIC tm;
     float ascent;
     int defaultGlyph;
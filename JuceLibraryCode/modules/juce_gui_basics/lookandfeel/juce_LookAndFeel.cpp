@@ -1374,10 +1374,14 @@ void LookAndFeel::drawLayoutLabel (Graphics& g, LayoutLabel& layoutLabel)
         g.setColour (layoutLabel.findColour (LayoutLabel::textColourId).withMultipliedAlpha (alpha));
         g.setFont (layoutLabel.getFont());
 
-        layoutLabel.getAttributedText().draw (g, Rectangle<int> (layoutLabel.getHorizontalBorderSize(),
-                                                                 layoutLabel.getVerticalBorderSize(),
-                                                                 layoutLabel.getWidth() - 2 * layoutLabel.getHorizontalBorderSize(),
-                                                                 layoutLabel.getHeight() - 2 * layoutLabel.getVerticalBorderSize()));
+        // Where the graphics context has its own text layout engine, it's used instead of the label's cached layout
+        if (! g.getInternalContext()->drawTextLayout (layoutLabel.getAttributedText(),
+                                                      Rectangle<int> (layoutLabel.getHorizontalBorderSize(),
+                                                                      layoutLabel.getVerticalBorderSize(),
+                                                                      layoutLabel.getWidth() - 2 * layoutLabel.getHorizontalBorderSize(),
+                                                                      layoutLabel.getHeight() - 2 * layoutLabel.getVerticalBorderSize()),
+                                                      nullptr))
+            layoutLabel.getGlyphLayout().draw (g);
 
         g.setColour (layoutLabel.findColour (LayoutLabel::outlineColourId).withMultipliedAlpha (alpha));
         g.drawRect (0, 0, layoutLabel.getWidth(), layoutLabel.getHeight());
@@ -1400,12 +1404,19 @@ void LookAndFeel::drawFrameLabel (Graphics& g, FrameLabel& frameLabel)
         g.setColour (frameLabel.findColour (FrameLabel::textColourId).withMultipliedAlpha (alpha));
         g.setFont (frameLabel.getFont());
 
-        AttributedString::drawMultiple (g, Rectangle<int> (frameLabel.getHorizontalBorderSize(),
-                                                           frameLabel.getVerticalBorderSize(),
-                                                           frameLabel.getWidth() - 2 * frameLabel.getHorizontalBorderSize(),
-                                                           frameLabel.getHeight() - 2 * frameLabel.getVerticalBorderSize()),
-                                        frameLabel.getParagraphs().getRawDataPointer(),
-                                        frameLabel.getParagraphs().size());
+        // Where the graphics context has its own text layout engine, it's used instead of the label's cached layouts
+        if (! AttributedString::drawMultipleNatively (g, Rectangle<int> (frameLabel.getHorizontalBorderSize(),
+                                                                         frameLabel.getVerticalBorderSize(),
+                                                                         frameLabel.getWidth() - 2 * frameLabel.getHorizontalBorderSize(),
+                                                                         frameLabel.getHeight() - 2 * frameLabel.getVerticalBorderSize()),
+                                                      frameLabel.getParagraphs().getRawDataPointer(),
+                                                      frameLabel.getParagraphs().size()))
+        {
+            const OwnedArray<GlyphLayout>& paragraphs = frameLabel.getParagraphLayouts();
+
+            for (int i = 0; i < paragraphs.size(); ++i)
+                paragraphs.getUnchecked (i)->draw (g);
+        }
 
         g.setColour (frameLabel.findColour (FrameLabel::outlineColourId).withMultipliedAlpha (alpha));
         g.drawRect (0, 0, frameLabel.getWidth(), frameLabel.getHeight());
@@ -31,6 +31,8 @@ FrameLabel::FrameLabel (const String& name,
     : Component (name),
       textValue (labelText),
       lastTextValue (labelText),
+      paragraphLayoutsValid (false),
+      layoutThreadPool (nullptr),
       font (15.0f),
       justification (Justification::centredLeft),
       horizontalBorderSize (5),
@@ -87,6 +89,7 @@ void FrameLabel::setParagraphs (ScopedPointer<OwnedArray<AttributedString> > new
     hideEditor (true);
 
     textValues = newText;
+    invalidateLayout();
     repaint();
 
     textWasChanged();
@@ -110,6 +113,31 @@ OwnedArray<AttributedString>& FrameLabel::getParagraphs (const bool) const
     return *textValues;
 }
 
+const OwnedArray<GlyphLayout>& FrameLabel::getParagraphLayouts()
+{
+    if (! paragraphLayoutsValid)
+    {
+        paragraphLayoutArea = getTextArea();
+        paragraphLayouts.clear();
+        AttributedString::layoutMultiple (paragraphLayouts, paragraphLayoutArea,
+                                          textValues->getRawDataPointer(), textValues->size(),
+                                          layoutThreadPool);
+        paragraphLayoutsValid = true;
+    }
+
+    return paragraphLayouts;
+}
+
+void FrameLabel::invalidateLayout()
+{
+    paragraphLayoutsValid = false;
+}
+
+void FrameLabel::setLayoutThreadPool (ThreadPool* const newThreadPool) noexcept
+{
+    layoutThreadPool = newThreadPool;
+}
+
 void FrameLabel::valueChanged (Value&)
 {
     if (lastTextValue != textValue.toString())
@@ -122,6 +150,7 @@ void FrameLabel::setFont (const Font& newFont)
     if (font != newFont)
     {
         font = newFont;
+        invalidateLayout();
         repaint();
     }
 }
@@ -158,6 +187,7 @@ void FrameLabel::setBorderSize (int h, int v)
     {
         horizontalBorderSize = h;
         verticalBorderSize = v;
+        invalidateLayout();
         repaint();
     }
 }
@@ -352,6 +382,14 @@ void FrameLabel::resized()
 {
     if (editor != nullptr)
         editor->setBoundsInset (BorderSize<int> (0));
+
+    // A new width changes where the lines wrap, and more height may reveal paragraphs
+    // that weren't laid out, but just shrinking the label doesn't need a new layout.
+    const Rectangle<int> area (getTextArea());
+
+    if (area.getWidth() != paragraphLayoutArea.getWidth()
+         || area.getHeight() > paragraphLayoutArea.getHeight())
+        invalidateLayout();
 }
 
 void FrameLabel::focusGained (FocusChangeType cause)
@@ -370,6 +408,11 @@ void FrameLabel::colourChanged()
     repaint();
 }
 
+void FrameLabel::lookAndFeelChanged()
+{
+    invalidateLayout();
+}
+
 void FrameLabel::setMinimumHorizontalScale (const float newScale)
 {
     if (minimumHorizontalScale != newScale)
@@ -422,6 +465,13 @@ void FrameLabel::callChangeListeners()
     listeners.callChecked (checker, &FrameLabelListener::labelTextChanged, this);  // (can't use FrameLabel::Listener due to idiotic VC2005 bug)
 }
 
+Rectangle<int> FrameLabel::getTextArea() const
+{
+    return Rectangle<int> (horizontalBorderSize, verticalBorderSize,
+                           getWidth() - 2 * horizontalBorderSize,
+                           getHeight() - 2 * verticalBorderSize);
+}
+
 //==============================================================================
 void FrameLabel::textEditorTextChanged (TextEditor& ed)
 {
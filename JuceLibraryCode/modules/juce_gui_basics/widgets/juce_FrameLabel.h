@@ -80,6 +80,27 @@ public:
 
     OwnedArray<AttributedString>& getParagraphs (bool returnActiveEditorContents = false) const;
 
+    /** Returns the laid-out glyphs for each of the paragraphs, creating them if needed.
+
+        The layouts are kept between repaints, and are only rebuilt after the paragraphs,
+        font, border size, width or look-and-feel of the label changes, or when the label
+        grows taller than the area they were created for. If you modify the objects returned
+        by getParagraphs() directly, call invalidateLayout() afterwards.
+
+        @see AttributedString::layoutMultiple
+    */
+    const OwnedArray<GlyphLayout>& getParagraphLayouts();
+
+    /** Discards the cached layouts, so that they'll be recreated when the label is next drawn. */
+    void invalidateLayout();
+
+    /** Gives the label a ThreadPool to use for laying out its paragraphs in parallel.
+
+        The pool isn't owned by the label, and must stay alive until the label is deleted or
+        this is called again with a different pool (or nullptr to lay out on the message thread).
+    */
+    void setLayoutThreadPool (ThreadPool* newThreadPool) noexcept;
+
     /** Returns the text content as a Value object.
         You can call Value::referTo() on this object to make the label read and control
         a Value object that you supply.
@@ -313,6 +334,8 @@ protected:
     /** @internal */
     void colourChanged();
     /** @internal */
+    void lookAndFeelChanged();
+    /** @internal */
     void valueChanged (Value&);
 
 private:
@@ -320,6 +343,10 @@ private:
     Value textValue;
     String lastTextValue;
     ScopedPointer<OwnedArray<AttributedString> > textValues;
+    OwnedArray<GlyphLayout> paragraphLayouts;
+    Rectangle<int> paragraphLayoutArea;
+    bool paragraphLayoutsValid;
+    ThreadPool* layoutThreadPool;
     Font font;
     Justification justification;
     ScopedPointer<TextEditor> editor;
@@ -334,6 +361,7 @@ private:
 
     bool updateFromTextEditorContents (TextEditor&);
     void callChangeListeners();
+    Rectangle<int> getTextArea() const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameLabel);
 };
@@ -87,6 +87,7 @@ void LayoutLabel::setAttributedText (ScopedPointer<AttributedString> newText,
     hideEditor (true);
 
     attributedTextValue = newText;
+    invalidateLayout();
     repaint();
 
     textWasChanged();
@@ -110,6 +111,22 @@ AttributedString& LayoutLabel::getAttributedText (const bool) const
     return *attributedTextValue;
 }
 
+const GlyphLayout& LayoutLabel::getGlyphLayout()
+{
+    if (glyphLayout == nullptr)
+    {
+        glyphLayout = new GlyphLayout (getTextArea().toFloat());
+        glyphLayout->setText (*attributedTextValue);
+    }
+
+    return *glyphLayout;
+}
+
+void LayoutLabel::invalidateLayout()
+{
+    glyphLayout = nullptr;
+}
+
 void LayoutLabel::valueChanged (Value&)
 {
     if (lastTextValue != textValue.toString())
@@ -122,6 +139,7 @@ void LayoutLabel::setFont (const Font& newFont)
     if (font != newFont)
     {
         font = newFont;
+        invalidateLayout();
         repaint();
     }
 }
@@ -158,6 +176,7 @@ void LayoutLabel::setBorderSize (int h, int v)
     {
         horizontalBorderSize = h;
         verticalBorderSize = v;
+        invalidateLayout();
         repaint();
     }
 }
@@ -352,6 +371,10 @@ void LayoutLabel::resized()
 {
     if (editor != nullptr)
         editor->setBoundsInset (BorderSize<int> (0));
+
+    // the height doesn't affect where the lines wrap, so only a new width needs a new layout
+    if (glyphLayout != nullptr && glyphLayout->area.getWidth() != (float) getTextArea().getWidth())
+        invalidateLayout();
 }
 
 void LayoutLabel::focusGained (FocusChangeType cause)
@@ -370,6 +393,11 @@ void LayoutLabel::colourChanged()
     repaint();
 }
 
+void LayoutLabel::lookAndFeelChanged()
+{
+    invalidateLayout();
+}
+
 void LayoutLabel::setMinimumHorizontalScale (const float newScale)
 {
     if (minimumHorizontalScale != newScale)
@@ -422,6 +450,13 @@ void LayoutLabel::callChangeListeners()
     listeners.callChecked (checker, &LayoutLabelListener::labelTextChanged, this);  // (can't use LayoutLabel::Listener due to idiotic VC2005 bug)
 }
 
+Rectangle<int> LayoutLabel::getTextArea() const
+{
+    return Rectangle<int> (horizontalBorderSize, verticalBorderSize,
+                           getWidth() - 2 * horizontalBorderSize,
+                           getHeight() - 2 * verticalBorderSize);
+}
+
 //==============================================================================
 void LayoutLabel::textEditorTextChanged (TextEditor& ed)
 {
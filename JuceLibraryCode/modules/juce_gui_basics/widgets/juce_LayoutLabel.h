@@ -80,6 +80,17 @@ public:
 
     AttributedString& getAttributedText (bool returnActiveEditorContents = false) const;
 
+    /** Returns the laid-out glyphs for the label's attributed text, creating them if needed.
+
+        The layout is kept between repaints, and is only rebuilt after the attributed text,
+        font, border size, width or look-and-feel of the label changes. If you modify the
+        object returned by getAttributedText() directly, call invalidateLayout() afterwards.
+    */
+    const GlyphLayout& getGlyphLayout();
+
+    /** Discards the cached layout, so that it'll be recreated when the label is next drawn. */
+    void invalidateLayout();
+
     /** Returns the text content as a Value object.
         You can call Value::referTo() on this object to make the label read and control
         a Value object that you supply.
@@ -313,6 +324,8 @@ protected:
     /** @internal */
     void colourChanged();
     /** @internal */
+    void lookAndFeelChanged();
+    /** @internal */
     void valueChanged (Value&);
 
 private:
@@ -320,6 +333,7 @@ private:
     Value textValue;
     String lastTextValue;
     ScopedPointer<AttributedString> attributedTextValue;
+    ScopedPointer<GlyphLayout> glyphLayout;
     Font font;
     Justification justification;
     ScopedPointer<TextEditor> editor;
@@ -334,6 +348,7 @@ private:
 
     bool updateFromTextEditorContents (TextEditor&);
     void callChangeListeners();
+    Rectangle<int> getTextArea() const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LayoutLabel);
 };
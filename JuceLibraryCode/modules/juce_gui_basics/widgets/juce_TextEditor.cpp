@@ -26,36 +26,19 @@
 BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
-// a word or space that can't be broken down any further
+// a word or space that can't be broken down any further. Its characters are kept in
+// the text of the section that contains it, rather than in a string of its own
 struct TextAtom
 {
     //==============================================================================
-    String atomText;
+    int start, length;      // the range of the section's text that the atom covers
     float width;
-    int numChars;
+    int numChars;           // (less than the length when it's part of a word that's been broken across lines)
+    juce_wchar firstChar;
 
     //==============================================================================
-    bool isWhitespace() const       { return CharacterFunctions::isWhitespace (atomText[0]); }
-    bool isNewLine() const          { return atomText[0] == '\r' || atomText[0] == '\n'; }
-
-    String getText (const juce_wchar passwordCharacter) const
-    {
-        if (passwordCharacter == 0)
-            return atomText;
-        else
-            return String::repeatedString (String::charToString (passwordCharacter),
-                                           atomText.length());
-    }
-
-    String getTrimmedText (const juce_wchar passwordCharacter) const
-    {
-        if (passwordCharacter == 0)
-            return atomText.substring (0, numChars);
-        else if (isNewLine())
-            return String::empty;
-        else
-            return String::repeatedString (String::charToString (passwordCharacter), numChars);
-    }
+    bool isWhitespace() const       { return CharacterFunctions::isWhitespace (firstChar); }
+    bool isNewLine() const          { return firstChar == '\r' || firstChar == '\n'; }
 };
 
 //==============================================================================
@@ -64,36 +47,27 @@ class TextEditor::UniformTextSection
 {
 public:
     //==============================================================================
-    UniformTextSection (const String& text,
+    UniformTextSection (const String& text_,
                         const Font& font_,
                         const Colour& colour_,
                         const juce_wchar passwordCharacter)
       : font (font_),
         colour (colour_)
     {
-        initialiseAtoms (text, passwordCharacter);
+        initialiseAtoms (text_, passwordCharacter);
     }
 
     UniformTextSection (const UniformTextSection& other)
       : font (other.font),
-        colour (other.colour)
-    {
-        atoms.ensureStorageAllocated (other.atoms.size());
-
-        for (int i = 0; i < other.atoms.size(); ++i)
-            atoms.add (new TextAtom (*other.atoms.getUnchecked(i)));
-    }
-
-    ~UniformTextSection()
+        colour (other.colour),
+        text (other.text),
+        atoms (other.atoms)
     {
-        // (no need to delete the atoms, as they're explicitly deleted by the caller)
     }
 
     void clear()
     {
-        for (int i = atoms.size(); --i >= 0;)
-            delete getAtom(i);
-
+        text.clear();
         atoms.clear();
     }
 
@@ -104,30 +78,52 @@ public:
 
     TextAtom* getAtom (const int index) const noexcept
     {
-        return atoms.getUnchecked (index);
+        return &(atoms.getReference (index));
+    }
+
+    String getText (const TextAtom& atom, const juce_wchar passwordCharacter) const
+    {
+        if (passwordCharacter == 0)
+            return String (CharPointer_UTF32 (text.begin() + atom.start), (size_t) atom.length);
+        else
+            return String::repeatedString (String::charToString (passwordCharacter), atom.length);
+    }
+
+    juce_wchar getCharacter (const int index) const noexcept
+    {
+        return text [index];
+    }
+
+    String getTrimmedText (const TextAtom& atom, const juce_wchar passwordCharacter) const
+    {
+        if (passwordCharacter == 0)
+            return String (CharPointer_UTF32 (text.begin() + atom.start), (size_t) atom.numChars);
+        else if (atom.isNewLine())
+            return String::empty;
+        else
+            return String::repeatedString (String::charToString (passwordCharacter), atom.numChars);
     }
 
     void append (const UniformTextSection& other, const juce_wchar passwordCharacter)
     {
         if (other.atoms.size() > 0)
         {
-            TextAtom* const lastAtom = atoms.getLast();
+            const int offset = text.size();
             int i = 0;
 
-            if (lastAtom != nullptr)
+            text.addArray (other.text);
+
+            if (atoms.size() > 0)
             {
-                if (! CharacterFunctions::isWhitespace (lastAtom->atomText.getLastCharacter()))
-                {
-                    TextAtom* const first = other.getAtom(0);
+                TextAtom& lastAtom = atoms.getReference (atoms.size() - 1);
 
-                    if (! CharacterFunctions::isWhitespace (first->atomText[0]))
-                    {
-                        lastAtom->atomText += first->atomText;
-                        lastAtom->numChars = (uint16) (lastAtom->numChars + first->numChars);
-                        lastAtom->width = font.getStringWidthFloat (lastAtom->getText (passwordCharacter));
-                        delete first;
-                        ++i;
-                    }
+                if (! (lastAtom.isWhitespace() || other.getAtom(0)->isWhitespace()
+                        || canBreakAfter (lastAtom, other.getAtom(0)->firstChar)))
+                {
+                    lastAtom.length += other.getAtom(0)->length;
+                    lastAtom.numChars += other.getAtom(0)->numChars;
+                    lastAtom.width = font.getStringWidthFloat (getText (lastAtom, passwordCharacter));
+                    ++i;
                 }
             }
 
@@ -135,8 +131,9 @@ public:
 
             while (i < other.atoms.size())
             {
-                atoms.add (other.getAtom(i));
-                ++i;
+                TextAtom atom (*other.getAtom (i++));
+                atom.start += offset;
+                atoms.add (atom);
             }
         }
     }
@@ -147,50 +144,41 @@ public:
         UniformTextSection* const section2 = new UniformTextSection (String::empty,
                                                                      font, colour,
                                                                      passwordCharacter);
-        int index = 0;
+        const int i = findAtomContaining (indexToBreakAt);
 
-        for (int i = 0; i < atoms.size(); ++i)
+        if (i >= 0 && indexToBreakAt < text.size())
         {
-            TextAtom* const atom = getAtom(i);
-
-            const int nextIndex = index + atom->numChars;
+            TextAtom& atom = atoms.getReference (i);
+            int firstAtomToMove = i;
 
-            if (index == indexToBreakAt)
+            if (indexToBreakAt > atom.start)
             {
-                int j;
-                for (j = i; j < atoms.size(); ++j)
-                    section2->atoms.add (getAtom (j));
+                TextAtom secondAtom (atom);
+                secondAtom.start = indexToBreakAt;
+                secondAtom.length = atom.start + atom.length - indexToBreakAt;
+                secondAtom.numChars = secondAtom.length;
+                secondAtom.firstChar = text.getUnchecked (indexToBreakAt);
+                secondAtom.width = font.getStringWidthFloat (getText (secondAtom, passwordCharacter));
 
-                for (j = atoms.size(); --j >= i;)
-                    atoms.remove (j);
-
-                break;
-            }
-            else if (indexToBreakAt >= index && indexToBreakAt < nextIndex)
-            {
-                TextAtom* const secondAtom = new TextAtom();
-
-                secondAtom->atomText = atom->atomText.substring (indexToBreakAt - index);
-                secondAtom->width = font.getStringWidthFloat (secondAtom->getText (passwordCharacter));
-                secondAtom->numChars = (uint16) secondAtom->atomText.length();
+                atom.length = indexToBreakAt - atom.start;
+                atom.numChars = atom.length;
+                atom.width = font.getStringWidthFloat (getText (atom, passwordCharacter));
 
                 section2->atoms.add (secondAtom);
+                ++firstAtomToMove;
+            }
 
-                atom->atomText = atom->atomText.substring (0, indexToBreakAt - index);
-                atom->width = font.getStringWidthFloat (atom->getText (passwordCharacter));
-                atom->numChars = (uint16) (indexToBreakAt - index);
-
-                int j;
-                for (j = i + 1; j < atoms.size(); ++j)
-                    section2->atoms.add (getAtom (j));
+            section2->text.addArray (text, indexToBreakAt);
+            section2->atoms.ensureStorageAllocated (section2->atoms.size() + atoms.size() - firstAtomToMove);
 
-                for (j = atoms.size(); --j > i;)
-                    atoms.remove (j);
+            for (int j = firstAtomToMove; j < atoms.size(); ++j)
+                section2->atoms.add (atoms.getReference (j));
 
-                break;
-            }
+            for (int j = section2->atoms.size(); --j >= 0;)
+                section2->atoms.getReference (j).start -= indexToBreakAt;
 
-            index = nextIndex;
+            text.removeRange (indexToBreakAt, text.size());
+            atoms.removeRange (firstAtomToMove, atoms.size());
         }
 
         return section2;
@@ -198,41 +186,46 @@ public:
 
     void appendAllText (MemoryOutputStream& mo) const
     {
-        for (int i = 0; i < atoms.size(); ++i)
-            mo << getAtom(i)->atomText;
+        appendSubstring (mo, Range<int> (0, text.size()));
     }
 
     void appendSubstring (MemoryOutputStream& mo, const Range<int>& range) const
     {
-        int index = 0;
-        for (int i = 0; i < atoms.size(); ++i)
-        {
-            const TextAtom* const atom = getAtom (i);
-            const int nextIndex = index + atom->numChars;
-
-            if (range.getStart() < nextIndex)
-            {
-                if (range.getEnd() <= index)
-                    break;
+        const Range<int> r (range.getIntersectionWith (Range<int> (0, text.size())));
 
-                const Range<int> r ((range - index).getIntersectionWith (Range<int> (0, (int) atom->numChars)));
+        if (! r.isEmpty())
+            mo << String (CharPointer_UTF32 (text.begin() + r.getStart()), (size_t) r.getLength());
+    }
 
-                if (! r.isEmpty())
-                    mo << atom->atomText.substring (r.getStart(), r.getEnd());
-            }
+    int getTotalLength() const
+    {
+        return text.size();
+    }
 
-            index = nextIndex;
-        }
+    // true if this section could be followed by the other one without the text being laid
+    // out any differently from the way it would be if the two were a single section
+    bool canBeFollowedBy (const UniformTextSection& next) const noexcept
+    {
+        return atoms.size() > 0 && next.atoms.size() > 0
+                && (atoms.getReference (atoms.size() - 1).isWhitespace()
+                     || next.atoms.getReference (0).isWhitespace());
     }
 
-    int getTotalLength() const
+    // returns the start of the atom nearest to the given character that the section could be
+    // split before without changing its layout, or 0 if there isn't one within maxDistance of it
+    int findSplitPoint (const int index, const int maxDistance) const noexcept
     {
-        int total = 0;
+        const int nearest = jmax (1, findAtomContaining (index));
+
+        for (int i = nearest; i < atoms.size() && atoms.getReference (i).start <= index + maxDistance; ++i)
+            if (isSplitPoint (i))
+                return atoms.getReference (i).start;
 
-        for (int i = atoms.size(); --i >= 0;)
-            total += getAtom(i)->numChars;
+        for (int i = nearest; --i > 0 && atoms.getReference (i).start >= index - maxDistance;)
+            if (isSplitPoint (i))
+                return atoms.getReference (i).start;
 
-        return total;
+        return 0;
     }
 
     void setFont (const Font& newFont,
@@ -244,8 +237,8 @@ public:
 
             for (int i = atoms.size(); --i >= 0;)
             {
-                TextAtom* const atom = atoms.getUnchecked(i);
-                atom->width = newFont.getStringWidthFloat (atom->getText (passwordCharacter));
+                TextAtom& atom = atoms.getReference (i);
+                atom.width = newFont.getStringWidthFloat (getText (atom, passwordCharacter));
             }
         }
     }
@@ -255,75 +248,202 @@ public:
     Colour colour;
 
 private:
-    Array <TextAtom*> atoms;
+    Array <juce_wchar> text;
+    Array <TextAtom> atoms;
 
     //==============================================================================
+    // returns the index of the atom that contains the given character, or -1 if the section is empty
+    int findAtomContaining (const int index) const noexcept
+    {
+        int start = 0, end = atoms.size();
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if (atoms.getReference (mid).start <= index)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return start - 1;
+    }
+
+    bool isSplitPoint (const int atomIndex) const noexcept
+    {
+        return atoms.getReference (atomIndex).isWhitespace()
+                || atoms.getReference (atomIndex - 1).isWhitespace();
+    }
+
     void initialiseAtoms (const String& textToParse,
                           const juce_wchar passwordCharacter)
     {
-        String::CharPointerType text (textToParse.getCharPointer());
+        text.ensureStorageAllocated (textToParse.length());
+
+        for (String::CharPointerType t (textToParse.getCharPointer()); ! t.isEmpty();)
+        {
+            const juce_wchar c = t.getAndAdvance();
+
+            if (c != '\r' || *t != '\n')   // (a CR-LF pair is kept as just the LF)
+                text.add (c);
+        }
+
+        // each atom is a line-break, a run of whitespace, or the part of a word that
+        // comes before the next place where a line could be broken
+        LineBreaker lineBreaker;
+        int atomStart = 0;
 
-        while (! text.isEmpty())
+        for (int i = 0; i < text.size(); ++i)
         {
-            size_t numChars = 0;
-            String::CharPointerType start (text);
+            // (a run of ASCII letters and digits, or of spaces, never has an atom starting inside it)
+            const juce_wchar* runStart = text.begin() + i;
+            i += lineBreaker.skipAsciiRun (runStart, text.size() - i);
+
+            if (i >= text.size())
+                break;
 
-            // create a whitespace atom unless it starts with non-ws
-            if (text.isWhitespace() && *text != '\r' && *text != '\n')
+            const juce_wchar c = text.getUnchecked (i);
+            const bool canBreak = lineBreaker.next (c) != LineBreaker::noBreak;
+
+            if (i > atomStart)
             {
-                do
+                const juce_wchar previous = text.getUnchecked (i - 1);
+
+                if (canBreak || isNewLine (c) || isNewLine (previous)
+                     || CharacterFunctions::isWhitespace (c) != CharacterFunctions::isWhitespace (previous))
                 {
-                    ++text;
-                    ++numChars;
+                    addAtom (atomStart, i, passwordCharacter);
+                    atomStart = i;
                 }
-                while (text.isWhitespace() && *text != '\r' && *text != '\n');
             }
-            else
+        }
+
+        if (atomStart < text.size())
+            addAtom (atomStart, text.size(), passwordCharacter);
+    }
+
+    void addAtom (const int start, const int end, const juce_wchar passwordCharacter)
+    {
+        TextAtom atom;
+        atom.start = start;
+        atom.length = atom.numChars = end - start;
+        atom.firstChar = text.getUnchecked (start);
+        atom.width = font.getStringWidthFloat (getText (atom, passwordCharacter));
+
+        atoms.add (atom);
+    }
+
+    static bool isNewLine (const juce_wchar c) noexcept
+    {
+        return c == '\r' || c == '\n';
+    }
+
+    // returns true if a line could be broken between the end of an atom and the character after it
+    bool canBreakAfter (const TextAtom& atom, const juce_wchar nextChar) const noexcept
+    {
+        LineBreaker lineBreaker;
+
+        for (int i = atom.start; i < atom.start + atom.length; ++i)
+            lineBreaker.next (text.getUnchecked (i));
+
+        return lineBreaker.next (nextChar) != LineBreaker::noBreak;
+    }
+
+    UniformTextSection& operator= (const UniformTextSection& other);
+    JUCE_LEAK_DETECTOR (UniformTextSection);
+};
+
+//==============================================================================
+// some runs of glyphs and their colours, kept in a single arrangement so that they
+// can be drawn later on, in the same order that the runs were added
+class ColouredGlyphList
+{
+public:
+    ColouredGlyphList() {}
+
+    // adds a line of text to the arrangement, and returns the index of its first glyph
+    int addText (const Font& font, const String& text, const float x, const float y)
+    {
+        const int firstGlyph = glyphs.getNumGlyphs();
+        glyphs.addLineOfText (font, text, x, y);
+        return firstGlyph;
+    }
+
+    int getNumGlyphs() const noexcept
+    {
+        return glyphs.getNumGlyphs();
+    }
+
+    void addRun (const int startGlyph, const int endGlyph, const Font& font, const Colour& colour)
+    {
+        if (endGlyph > startGlyph)
+        {
+            Run run;
+            run.startGlyph = startGlyph;
+            run.endGlyph = endGlyph;
+            run.font = font;
+            run.colour = colour;
+            runs.add (run);
+        }
+    }
+
+    void draw (Graphics& g) const
+    {
+        for (int i = 0; i < runs.size(); ++i)
+        {
+            const Run& run = runs.getReference (i);
+            g.setColour (run.colour);
+
+            for (int j = run.startGlyph; j < run.endGlyph; ++j)
             {
-                if (*text == '\r')
-                {
-                    ++text;
-                    ++numChars;
+                const PositionedGlyph& pg = glyphs.getGlyph (j);
 
-                    if (*text == '\n')
-                    {
-                        ++start;
-                        ++text;
-                    }
-                }
-                else if (*text == '\n')
-                {
-                    ++text;
-                    ++numChars;
-                }
-                else
+                // (each run's underline is drawn in the same way as a GlyphArrangement's)
+                if (run.font.isUnderlined())
                 {
-                    while (! (text.isEmpty() || text.isWhitespace()))
-                    {
-                        ++text;
-                        ++numChars;
-                    }
-                }
-            }
+                    const float lineThickness = run.font.getDescent() * 0.3f;
+                    float nextX = pg.getRight();
 
-            TextAtom* const atom = new TextAtom();
-            atom->atomText = String (start, numChars);
+                    if (j < run.endGlyph - 1 && glyphs.getGlyph (j + 1).getBaselineY() == pg.getBaselineY())
+                        nextX = glyphs.getGlyph (j + 1).getLeft();
 
-            atom->width = font.getStringWidthFloat (atom->getText (passwordCharacter));
-            atom->numChars = (uint16) numChars;
+                    g.fillRect (pg.getLeft(), pg.getBaselineY() + lineThickness * 2.0f,
+                                nextX - pg.getLeft(), lineThickness);
+                }
 
-            atoms.add (atom);
+                pg.draw (g);
+            }
         }
     }
 
-    UniformTextSection& operator= (const UniformTextSection& other);
-    JUCE_LEAK_DETECTOR (UniformTextSection);
+private:
+    struct Run
+    {
+        int startGlyph, endGlyph;
+        Font font;
+        Colour colour;
+    };
+
+    GlyphArrangement glyphs;
+    Array <Run> runs;
+
+    JUCE_DECLARE_NON_COPYABLE (ColouredGlyphList);
 };
 
 //==============================================================================
 class TextEditor::Iterator
 {
 public:
+    //==============================================================================
+    // the state of an iterator at the first atom of a line, from which it can be resumed
+    struct LineStart
+    {
+        int sectionIndex, atomIndex, indexInText;
+        float lineY, lineHeight, maxDescent, atomRight;
+        float width; // the right-hand edge of the furthest atom on the line
+    };
+
     //==============================================================================
     Iterator (const Array <UniformTextSection*>& sections_,
               const float wordWrapWidth_,
@@ -340,7 +460,9 @@ public:
         sectionIndex (0),
         atomIndex (0),
         wordWrapWidth (wordWrapWidth_),
-        passwordCharacter (passwordCharacter_)
+        passwordCharacter (passwordCharacter_),
+        brokenWordStart (0),
+        isAtLineStart (false)
     {
         jassert (wordWrapWidth_ > 0);
 
@@ -367,20 +489,56 @@ public:
         atomIndex (other.atomIndex),
         wordWrapWidth (other.wordWrapWidth),
         passwordCharacter (other.passwordCharacter),
-        tempAtom (other.tempAtom)
+        tempAtom (other.tempAtom),
+        brokenWordOffsets (other.brokenWordOffsets),
+        brokenWordStart (other.brokenWordStart),
+        isAtLineStart (other.isAtLineStart)
     {
+        if (other.atom == &other.tempAtom)
+            atom = &tempAtom;
+    }
+
+    // creates an iterator whose first call to next() will return the first atom of a line
+    Iterator (const Array <UniformTextSection*>& sections_,
+              const float wordWrapWidth_,
+              const juce_wchar passwordCharacter_,
+              const LineStart& line)
+      : indexInText (line.indexInText),
+        lineY (line.lineY),
+        lineHeight (line.lineHeight),
+        maxDescent (line.maxDescent),
+        atomX (0),
+        atomRight (line.atomRight),
+        atom (0),
+        currentSection (sections_.getUnchecked (line.sectionIndex)),
+        sections (sections_),
+        sectionIndex (line.sectionIndex),
+        atomIndex (line.atomIndex),
+        wordWrapWidth (wordWrapWidth_),
+        passwordCharacter (passwordCharacter_),
+        brokenWordStart (0),
+        isAtLineStart (true)
+    {
+        atom = currentSection->getAtom (atomIndex - 1);
     }
 
     //==============================================================================
     bool next()
     {
+        if (isAtLineStart)
+        {
+            isAtLineStart = false;
+            return true;
+        }
+
         if (atom == &tempAtom)
         {
-            const int numRemaining = tempAtom.atomText.length() - tempAtom.numChars;
+            const int numRemaining = tempAtom.length - tempAtom.numChars;
 
             if (numRemaining > 0)
             {
-                tempAtom.atomText = tempAtom.atomText.substring (tempAtom.numChars);
+                tempAtom.start += tempAtom.numChars;
+                tempAtom.length -= tempAtom.numChars;
 
                 atomX = 0;
 
@@ -389,18 +547,25 @@ public:
 
                 indexInText += tempAtom.numChars;
 
-                GlyphArrangement g;
-                g.addLineOfText (currentSection->font, atom->getText (passwordCharacter), 0.0f, 0.0f);
+                // the whole word was measured when it was found to be too long, so each
+                // line's piece of it can be found without measuring the rest of it again
+                const int firstGlyph = tempAtom.start - brokenWordStart;
+                const float startX = firstGlyph < brokenWordOffsets.size() ? brokenWordOffsets.getUnchecked (firstGlyph) : 0.0f;
 
                 int split;
-                for (split = 0; split < g.getNumGlyphs(); ++split)
-                    if (shouldWrap (g.getGlyph (split).getRight()))
+                for (split = 0; firstGlyph + split + 1 < brokenWordOffsets.size(); ++split)
+                    if (shouldWrap (brokenWordOffsets.getUnchecked (firstGlyph + split + 1) - startX))
                         break;
 
+                // (avoid splitting it just before a combining mark)
+                while (split > 1 && split < numRemaining && passwordCharacter == 0
+                        && LineBreaker::isCombiningMark (currentSection->getCharacter (tempAtom.start + split)))
+                    --split;
+
                 if (split > 0 && split <= numRemaining)
                 {
                     tempAtom.numChars = (uint16) split;
-                    tempAtom.width = g.getGlyph (split - 1).getRight();
+                    tempAtom.width = brokenWordOffsets.getUnchecked (firstGlyph + split) - startX;
                     atomRight = atomX + tempAtom.width;
                     return true;
                 }
@@ -503,6 +668,12 @@ public:
                     tempAtom.numChars = 0;
                     atom = &tempAtom;
 
+                    Array<int> glyphs;
+                    brokenWordOffsets.clearQuick();
+                    brokenWordStart = tempAtom.start;
+                    currentSection->font.getGlyphPositions (currentSection->getText (tempAtom, passwordCharacter),
+                                                            glyphs, brokenWordOffsets);
+
                     if (atomX > 0)
                         beginNewLine();
 
@@ -569,25 +740,18 @@ public:
     }
 
     //==============================================================================
-    void draw (Graphics& g, const UniformTextSection*& lastSection) const
+    void addGlyphs (ColouredGlyphList& glyphs) const
     {
         if (passwordCharacter != 0 || ! atom->isWhitespace())
         {
-            if (lastSection != currentSection)
-            {
-                lastSection = currentSection;
-                g.setColour (currentSection->colour);
-                g.setFont (currentSection->font);
-            }
+            jassert (currentSection->getTrimmedText (*atom, passwordCharacter).isNotEmpty());
 
-            jassert (atom->getTrimmedText (passwordCharacter).isNotEmpty());
+            const int firstGlyph = glyphs.addText (currentSection->font,
+                                                   currentSection->getTrimmedText (*atom, passwordCharacter),
+                                                   atomX,
+                                                   (float) roundToInt (lineY + lineHeight - maxDescent));
 
-            GlyphArrangement ga;
-            ga.addLineOfText (currentSection->font,
-                              atom->getTrimmedText (passwordCharacter),
-                              atomX,
-                              (float) roundToInt (lineY + lineHeight - maxDescent));
-            ga.draw (g);
+            glyphs.addRun (firstGlyph, glyphs.getNumGlyphs(), currentSection->font, currentSection->colour);
         }
     }
 
@@ -602,51 +766,33 @@ public:
         g.fillRect (startX, y, endX - startX, nextY - y);
     }
 
-    void drawUnderline (Graphics& g, const Range<int>& underline, const Colour& colour) const
+    Rectangle<int> getUnderlineArea (const Range<int>& underline) const
     {
         const int startX    = roundToInt (indexToX (underline.getStart()));
         const int endX      = roundToInt (indexToX (underline.getEnd()));
         const int baselineY = roundToInt (lineY + currentSection->font.getAscent() + 0.5f);
 
-        Graphics::ScopedSaveState state (g);
-        g.reduceClipRegion (Rectangle<int> (startX, baselineY, endX - startX, 1));
-        g.fillCheckerBoard (Rectangle<int> (endX, baselineY + 1), 3, 1, colour, Colours::transparentBlack);
+        return Rectangle<int> (startX, baselineY, endX - startX, 1);
     }
 
-    void drawSelectedText (Graphics& g,
-                           const Range<int>& selection,
-                           const Colour& selectedTextColour) const
+    void addSelectedGlyphs (ColouredGlyphList& glyphs,
+                            const Range<int>& selection,
+                            const Colour& selectedTextColour) const
     {
         if (passwordCharacter != 0 || ! atom->isWhitespace())
         {
-            GlyphArrangement ga;
-            ga.addLineOfText (currentSection->font,
-                              atom->getTrimmedText (passwordCharacter),
-                              atomX,
-                              (float) roundToInt (lineY + lineHeight - maxDescent));
-
-            if (selection.getEnd() < indexInText + atom->numChars)
-            {
-                GlyphArrangement ga2 (ga);
-                ga2.removeRangeOfGlyphs (0, selection.getEnd() - indexInText);
-                ga.removeRangeOfGlyphs (selection.getEnd() - indexInText, -1);
-
-                g.setColour (currentSection->colour);
-                ga2.draw (g);
-            }
-
-            if (selection.getStart() > indexInText)
-            {
-                GlyphArrangement ga2 (ga);
-                ga2.removeRangeOfGlyphs (selection.getStart() - indexInText, -1);
-                ga.removeRangeOfGlyphs (0, selection.getStart() - indexInText);
-
-                g.setColour (currentSection->colour);
-                ga2.draw (g);
-            }
-
-            g.setColour (selectedTextColour);
-            ga.draw (g);
+            const int firstGlyph = glyphs.addText (currentSection->font,
+                                                   currentSection->getTrimmedText (*atom, passwordCharacter),
+                                                   atomX,
+                                                   (float) roundToInt (lineY + lineHeight - maxDescent));
+            const int endGlyph = glyphs.getNumGlyphs();
+
+            const int selectionStart = jlimit (firstGlyph, endGlyph, firstGlyph + selection.getStart() - indexInText);
+            const int selectionEnd   = jlimit (firstGlyph, endGlyph, firstGlyph + selection.getEnd() - indexInText);
+
+            glyphs.addRun (selectionEnd, endGlyph, currentSection->font, currentSection->colour);
+            glyphs.addRun (firstGlyph, selectionStart, currentSection->font, currentSection->colour);
+            glyphs.addRun (selectionStart, selectionEnd, currentSection->font, selectedTextColour);
         }
     }
 
@@ -661,7 +807,7 @@ public:
 
         GlyphArrangement g;
         g.addLineOfText (currentSection->font,
-                         atom->getText (passwordCharacter),
+                         currentSection->getText (*atom, passwordCharacter),
                          atomX, 0.0f);
 
         if (indexToFind - indexInText >= g.getNumGlyphs())
@@ -680,7 +826,7 @@ public:
 
         GlyphArrangement g;
         g.addLineOfText (currentSection->font,
-                         atom->getText (passwordCharacter),
+                         currentSection->getText (*atom, passwordCharacter),
                          atomX, 0.0f);
 
         int j;
@@ -711,6 +857,30 @@ public:
         return false;
     }
 
+    //==============================================================================
+    // returns true if the current atom is part of a word that had to be broken
+    // across lines, in which case the iterator can't be resumed from it
+    bool isInsideBrokenWord() const noexcept
+    {
+        return atom == &tempAtom;
+    }
+
+    LineStart getLineStart() const noexcept
+    {
+        jassert (! isInsideBrokenWord());
+
+        LineStart line;
+        line.sectionIndex = sectionIndex;
+        line.atomIndex = atomIndex;
+        line.indexInText = indexInText;
+        line.lineY = lineY;
+        line.lineHeight = lineHeight;
+        line.maxDescent = maxDescent;
+        line.atomRight = atomRight;
+        line.width = atomRight;
+        return line;
+    }
+
     //==============================================================================
     int indexInText;
     float lineY, lineHeight, maxDescent;
@@ -724,6 +894,9 @@ private:
     const float wordWrapWidth;
     const juce_wchar passwordCharacter;
     TextAtom tempAtom;
+    Array<float> brokenWordOffsets;  // the glyph positions of a word that's being broken across lines
+    int brokenWordStart;
+    bool isAtLineStart;
 
     Iterator& operator= (const Iterator&);
 
@@ -750,6 +923,331 @@ private:
 };
 
 
+//==============================================================================
+// keeps a list of the positions at which the wrapped lines start, so that the layout
+// can be picked up from the line that's needed instead of from the top of the text
+class TextEditor::LineIndex
+{
+public:
+    LineIndex (const Array <UniformTextSection*>& sections_)
+        : sections (sections_),
+          wordWrapWidth (0),
+          passwordCharacter (0),
+          numSections (0),
+          endY (0),
+          isComplete (false),
+          shiftStart (0),
+          shiftChars (0),
+          shiftSections (0),
+          shiftY (0)
+    {
+    }
+
+    void clear()
+    {
+        lines.clearQuick();
+        isComplete = false;
+        clearShift();
+    }
+
+    //==============================================================================
+    // returns an iterator that will start from the line containing the given character
+    Iterator getIteratorForIndex (const int index, const float wordWrapWidth_, const juce_wchar passwordCharacter_)
+    {
+        setLayout (wordWrapWidth_, passwordCharacter_);
+        extendTo (index, -1.0f);
+
+        return createIterator (findLineContaining (index));
+    }
+
+    // returns an iterator that will start from the last line that begins above the given y position
+    Iterator getIteratorForY (const float y, const float wordWrapWidth_, const juce_wchar passwordCharacter_)
+    {
+        setLayout (wordWrapWidth_, passwordCharacter_);
+        extendTo (-1, y);
+
+        int start = 0, end = lines.size();
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if (getLine (mid).lineY < y)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return createIterator (start - 1);
+    }
+
+    void getTextSize (const float wordWrapWidth_, const juce_wchar passwordCharacter_,
+                      float& width, float& height)
+    {
+        setLayout (wordWrapWidth_, passwordCharacter_);
+        extendTo (std::numeric_limits<int>::max(), 0.0f);
+
+        width = 0.0f;
+
+        for (int i = lines.size(); --i >= 0;)
+            width = jmax (width, lines.getReference (i).width);
+
+        height = endY;
+    }
+
+    //==============================================================================
+    // Called after some text has been inserted or removed. The lines around the change are
+    // laid out again until one starts at the same place as an old one, and the lines after that
+    // are kept, just moved by the number of characters and the height that have been added.
+    // (The move isn't applied to each of those lines straight away, but is added to the shift
+    // that's applied to the lines after the edit whenever they're read).
+    // Any lines from firstRearrangedChar onwards are also laid out again, because the sections
+    // or atoms that they start in may have been merged or split up.
+    void textChanged (const int changeStart, const int numCharsRemoved, const int numCharsInserted,
+                      const int firstRearrangedChar,
+                      const float wordWrapWidth_, const juce_wchar passwordCharacter_)
+    {
+        if (wordWrapWidth_ != wordWrapWidth || passwordCharacter_ != passwordCharacter || wordWrapWidth <= 0)
+        {
+            clear();
+            return;
+        }
+
+        // changing a line can also change the way the couple of lines before it are wrapped
+        const int firstLine = jmax (-1, findLineContaining (jmin (changeStart, firstRearrangedChar)) - 3);
+
+        if (! isComplete)
+        {
+            removeLinesFrom (firstLine + 1);
+            return;
+        }
+
+        const int oldNumSections = numSections;
+        const float oldEndY = endY;
+        const int charDelta = numCharsInserted - numCharsRemoved;
+        const int changeEnd = changeStart + numCharsInserted;
+
+        isComplete = false;
+        numSections = sections.size();
+
+        Iterator i (resumeFromLine (firstLine));
+        float lastLineY = firstLine >= 0 ? getLine (firstLine).lineY : -1.0f;
+        float* const firstLineWidth = firstLine >= 0 ? &(lines.getReference (firstLine).width) : nullptr;
+        Array <Iterator::LineStart> newLines;
+        int oldIndex = firstLine + 1;
+
+        while (findNextLineStart (i, lastLineY, newLines.size() > 0 ? &(newLines.getReference (newLines.size() - 1).width)
+                                                                    : firstLineWidth))
+        {
+            const Iterator::LineStart line (i.getLineStart());
+
+            if (line.indexInText > changeEnd)
+            {
+                while (oldIndex < lines.size() && getLine (oldIndex).indexInText + charDelta < line.indexInText)
+                    ++oldIndex;
+
+                if (oldIndex < lines.size())
+                {
+                    const Iterator::LineStart oldLine (getLine (oldIndex));
+
+                    if (oldLine.indexInText + charDelta == line.indexInText
+                         && numSections - line.sectionIndex == oldNumSections - oldLine.sectionIndex)
+                    {
+                        moveShiftStart (oldIndex);
+                        replaceLines (firstLine + 1, oldIndex, newLines);
+
+                        const float yDelta = line.lineY - oldLine.lineY;
+                        const int atomDelta = line.atomIndex - oldLine.atomIndex;
+
+                        shiftStart = firstLine + 1 + newLines.size();
+                        shiftChars += charDelta;
+                        shiftSections += line.sectionIndex - oldLine.sectionIndex;
+                        shiftY += yDelta;
+
+                        for (int j = shiftStart; j < lines.size() && getLine (j).sectionIndex == line.sectionIndex; ++j)
+                            lines.getReference (j).atomIndex += atomDelta;
+
+                        endY = oldEndY + yDelta;
+                        isComplete = true;
+                        return;
+                    }
+                }
+            }
+
+            newLines.add (line);
+        }
+
+        removeLinesFrom (firstLine + 1);
+        lines.addArray (newLines);
+        shiftStart = lines.size();
+    }
+
+private:
+    //==============================================================================
+    const Array <UniformTextSection*>& sections;
+    Array <Iterator::LineStart> lines;
+    float wordWrapWidth;
+    juce_wchar passwordCharacter;
+    int numSections;
+    float endY;
+    bool isComplete;
+
+    // the lines from shiftStart onwards are stored as they were before some edits that moved them
+    int shiftStart, shiftChars, shiftSections;
+    float shiftY;
+
+    Iterator::LineStart getLine (const int lineIndex) const noexcept
+    {
+        Iterator::LineStart line (lines.getReference (lineIndex));
+
+        if (lineIndex >= shiftStart)
+        {
+            line.indexInText += shiftChars;
+            line.sectionIndex += shiftSections;
+            line.lineY += shiftY;
+        }
+
+        return line;
+    }
+
+    // applies the shift to the lines before newStart, or takes it off the lines after it,
+    // so that it only has to be applied to the lines from newStart onwards
+    void moveShiftStart (const int newStart) noexcept
+    {
+        for (; shiftStart < newStart; ++shiftStart)
+        {
+            Iterator::LineStart& l = lines.getReference (shiftStart);
+            l.indexInText += shiftChars;
+            l.sectionIndex += shiftSections;
+            l.lineY += shiftY;
+        }
+
+        while (shiftStart > newStart)
+        {
+            Iterator::LineStart& l = lines.getReference (--shiftStart);
+            l.indexInText -= shiftChars;
+            l.sectionIndex -= shiftSections;
+            l.lineY -= shiftY;
+        }
+    }
+
+    void clearShift() noexcept
+    {
+        shiftStart = lines.size();
+        shiftChars = shiftSections = 0;
+        shiftY = 0;
+    }
+
+    void removeLinesFrom (const int lineIndex)
+    {
+        moveShiftStart (jmin (jmax (shiftStart, lineIndex), lines.size()));
+        lines.removeRange (lineIndex, lines.size());
+        clearShift();
+    }
+
+    // replaces the lines from startLine up to endLine with some new ones
+    void replaceLines (const int startLine, const int endLine, const Array <Iterator::LineStart>& newLines)
+    {
+        const int numToOverwrite = jmin (endLine - startLine, newLines.size());
+
+        for (int i = 0; i < numToOverwrite; ++i)
+            lines.set (startLine + i, newLines.getReference (i));
+
+        lines.removeRange (startLine + numToOverwrite, endLine - startLine - numToOverwrite);
+        lines.insertArray (startLine + numToOverwrite, newLines.begin() + numToOverwrite, newLines.size() - numToOverwrite);
+    }
+
+    void setLayout (const float wordWrapWidth_, const juce_wchar passwordCharacter_)
+    {
+        if (wordWrapWidth_ != wordWrapWidth || passwordCharacter_ != passwordCharacter)
+        {
+            wordWrapWidth = wordWrapWidth_;
+            passwordCharacter = passwordCharacter_;
+            clear();
+        }
+    }
+
+    int findLineContaining (const int index) const noexcept
+    {
+        int start = 0, end = lines.size();
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if (getLine (mid).indexInText <= index)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return start - 1;
+    }
+
+    Iterator createIterator (const int lineIndex) const
+    {
+        if (lineIndex < 0)
+            return Iterator (sections, wordWrapWidth, passwordCharacter);
+
+        return Iterator (sections, wordWrapWidth, passwordCharacter, getLine (lineIndex));
+    }
+
+    Iterator resumeFromLine (const int lineIndex)
+    {
+        if (lineIndex >= 0)
+            lines.getReference (lineIndex).width = 0;
+
+        return createIterator (lineIndex);
+    }
+
+    // lays out lines until one has been added that starts after the given character and y position
+    void extendTo (const int index, const float y)
+    {
+        numSections = sections.size();
+
+        if (isComplete || (lines.size() > 0 && getLine (lines.size() - 1).indexInText > index
+                                             && getLine (lines.size() - 1).lineY >= y))
+            return;
+
+        Iterator i (resumeFromLine (lines.size() - 1));
+        float lastLineY = lines.size() > 0 ? getLine (lines.size() - 1).lineY : -1.0f;
+
+        while (findNextLineStart (i, lastLineY, lines.size() > 0 ? &(lines.getReference (lines.size() - 1).width) : nullptr))
+        {
+            lines.add (i.getLineStart());
+
+            if (i.indexInText > index && i.lineY >= y)
+                break;
+        }
+    }
+
+    // moves the iterator on to the first atom of the next line that it could be resumed from,
+    // keeping track of the width of the line that it started on as it goes
+    bool findNextLineStart (Iterator& i, float& lastLineY, float* const lastLineWidth)
+    {
+        while (i.next())
+        {
+            if (i.lineY != lastLineY)
+            {
+                lastLineY = i.lineY;
+
+                if (! i.isInsideBrokenWord())
+                    return true;
+            }
+
+            if (lastLineWidth != nullptr)
+                *lastLineWidth = jmax (*lastLineWidth, i.atomRight);
+        }
+
+        endY = i.lineY + i.lineHeight;
+        isComplete = true;
+        return false;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (LineIndex);
+};
+
+
 //==============================================================================
 class TextEditor::InsertAction  : public UndoableAction
 {
@@ -953,11 +1451,41 @@ namespace TextEditorDefs
 
     const int maxActionsPerTransaction = 100;
 
+    // the length beyond which a run of text with one font and colour is kept in several
+    // sections, so that an edit only has to copy the text of the section that it's in
+    const int maxSectionLength = 4096;
+
     int getCharacterCategory (const juce_wchar character)
     {
         return CharacterFunctions::isLetterOrDigit (character)
                     ? 2 : (CharacterFunctions::isWhitespace (character) ? 0 : 1);
     }
+
+    struct RangeStartComparator
+    {
+        static int compareElements (const Range<int>& first, const Range<int>& second) noexcept
+        {
+            return first.getStart() < second.getStart() ? -1 : (first.getStart() > second.getStart() ? 1 : 0);
+        }
+    };
+
+    // returns the index of the first of some sorted, non-overlapping ranges that ends after the given index
+    int findFirstRangeEndingAfter (const Array <Range<int> >& ranges, const int index) noexcept
+    {
+        int start = 0, end = ranges.size();
+
+        while (start < end)
+        {
+            const int mid = (start + end) / 2;
+
+            if (ranges.getReference (mid).getEnd() <= index)
+                start = mid + 1;
+            else
+                end = mid;
+        }
+
+        return start;
+    }
 }
 
 //==============================================================================
@@ -984,6 +1512,7 @@ TextEditor::TextEditor (const String& name,
       currentFont (14.0f),
       totalNumChars (0),
       caretPosition (0),
+      lineIndex (new LineIndex (sections)),
       passwordCharacter (passwordCharacter_),
       dragType (notDragging)
 {
@@ -1139,7 +1668,8 @@ void TextEditor::applyFontToAllText (const Font& newFont)
         uts->colour = overallColour;
     }
 
-    coalesceSimilarSections();
+    coalesceSimilarSections (0, sections.size() - 1);
+    lineIndex->clear();
     updateTextHolderSize();
     scrollToMakeSureCursorIsVisible();
     repaint();
@@ -1336,7 +1866,7 @@ void TextEditor::repaintText (const Range<int>& range)
 
         if (wordWrapWidth > 0)
         {
-            Iterator i (sections, wordWrapWidth, passwordCharacter);
+            Iterator i (lineIndex->getIteratorForIndex (range.getStart(), wordWrapWidth, passwordCharacter));
 
             i.getCharPosition (range.getStart(), x, y, lh);
 
@@ -1442,16 +1972,11 @@ void TextEditor::updateTextHolderSize()
 
     if (wordWrapWidth > 0)
     {
-        float maxWidth = 0.0f;
-
-        Iterator i (sections, wordWrapWidth, passwordCharacter);
-
-        while (i.next())
-            maxWidth = jmax (maxWidth, i.atomRight);
+        float maxWidth, height;
+        lineIndex->getTextSize (wordWrapWidth, passwordCharacter, maxWidth, height);
 
         const int w = leftIndent + roundToInt (maxWidth);
-        const int h = topIndent + roundToInt (jmax (i.lineY + i.lineHeight,
-                                                    currentFont.getHeight()));
+        const int h = topIndent + roundToInt (jmax (height, currentFont.getHeight()));
 
         textHolder->setSize (w + 2, h + 1); // (the +2 allows a bit of space for the cursor to be at the right-hand-edge)
     }
@@ -1668,62 +2193,71 @@ void TextEditor::drawContent (Graphics& g)
         const Rectangle<int> clip (g.getClipBounds());
         Colour selectedTextColour;
 
-        Iterator i (sections, wordWrapWidth, passwordCharacter);
-
-        while (i.lineY + 200.0 < clip.getY() && i.next())
-        {}
-
         if (! selection.isEmpty())
         {
             g.setColour (findColour (highlightColourId).withMultipliedAlpha (hasKeyboardFocus (true) ? 1.0f : 0.5f));
 
             selectedTextColour = findColour (highlightedTextColourId);
-
-            Iterator i2 (i);
-
-            while (i2.next() && i2.lineY < clip.getBottom())
-            {
-                if (i2.lineY + i2.lineHeight >= clip.getY()
-                     && selection.intersects (Range<int> (i2.indexInText, i2.indexInText + i2.atom->numChars)))
-                {
-                    i2.drawSelection (g, selection);
-                }
-            }
         }
 
-        const UniformTextSection* lastSection = nullptr;
+        // The highlight is filled in as the visible atoms are visited, but their text and
+        // underlines are collected up and drawn afterwards, so that they go on top of it.
+        ColouredGlyphList glyphs;
+        Array <Rectangle<int> > underlines;
+        Array <Range<int> > activeUnderlines;
+        int nextUnderline = -1;
+
+        Iterator i (lineIndex->getIteratorForY ((float) clip.getY(), wordWrapWidth, passwordCharacter));
 
         while (i.next() && i.lineY < clip.getBottom())
         {
             if (i.lineY + i.lineHeight >= clip.getY())
             {
-                if (selection.intersects (Range<int> (i.indexInText, i.indexInText + i.atom->numChars)))
+                const Range<int> atomRange (i.indexInText, i.indexInText + i.atom->numChars);
+
+                if (selection.intersects (atomRange))
                 {
-                    i.drawSelectedText (g, selection, selectedTextColour);
-                    lastSection = nullptr;
+                    i.drawSelection (g, selection);
+                    i.addSelectedGlyphs (glyphs, selection, selectedTextColour);
                 }
                 else
                 {
-                    i.draw (g, lastSection);
+                    i.addGlyphs (glyphs);
                 }
-            }
-        }
 
-        for (int j = underlinedSections.size(); --j >= 0;)
-        {
-            const Range<int>& underlinedSection = underlinedSections.getReference (j);
+                // (the underlined sections are sorted and don't overlap, so the first one that
+                // can be visible is found with a binary search)
+                if (nextUnderline < 0)
+                    nextUnderline = TextEditorDefs::findFirstRangeEndingAfter (underlinedSections, atomRange.getStart());
 
-            Iterator i2 (sections, wordWrapWidth, passwordCharacter);
+                while (nextUnderline < underlinedSections.size()
+                        && underlinedSections.getReference (nextUnderline).getStart() < atomRange.getEnd())
+                    activeUnderlines.add (underlinedSections.getReference (nextUnderline++));
 
-            while (i2.next() && i2.lineY < clip.getBottom())
-            {
-                if (i2.lineY + i2.lineHeight >= clip.getY()
-                     && underlinedSection.intersects (Range<int> (i2.indexInText, i2.indexInText + i2.atom->numChars)))
+                for (int j = activeUnderlines.size(); --j >= 0;)
                 {
-                    i2.drawUnderline (g, underlinedSection, findColour (textColourId));
+                    const Range<int>& underlinedSection = activeUnderlines.getReference (j);
+
+                    if (underlinedSection.getEnd() <= atomRange.getStart())
+                        activeUnderlines.remove (j);
+                    else if (underlinedSection.intersects (atomRange))
+                        underlines.add (i.getUnderlineArea (underlinedSection));
                 }
             }
         }
+
+        glyphs.draw (g);
+
+        const Colour underlineColour (findColour (textColourId));
+
+        for (int j = 0; j < underlines.size(); ++j)
+        {
+            const Rectangle<int>& area = underlines.getReference (j);
+
+            Graphics::ScopedSaveState state (g);
+            g.reduceClipRegion (area);
+            g.fillCheckerBoard (Rectangle<int> (area.getRight(), area.getBottom()), 3, 1, underlineColour, Colours::transparentBlack);
+        }
     }
 }
 
@@ -2236,6 +2770,26 @@ void TextEditor::enablementChanged()
 void TextEditor::setTemporaryUnderlining (const Array <Range<int> >& newUnderlinedSections)
 {
     underlinedSections = newUnderlinedSections;
+
+    TextEditorDefs::RangeStartComparator comparator;
+    underlinedSections.sort (comparator);
+
+    // any overlapping sections are merged, so that their ends are in order too
+    for (int i = 1; i < underlinedSections.size();)
+    {
+        Range<int>& previous = underlinedSections.getReference (i - 1);
+
+        if (underlinedSections.getReference (i).getStart() < previous.getEnd())
+        {
+            previous = previous.getUnionWith (underlinedSections.getReference (i));
+            underlinedSections.remove (i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
     repaint();
 }
 
@@ -2272,41 +2826,22 @@ void TextEditor::insert (const String& text,
             repaintText (Range<int> (insertIndex, getTotalNumChars())); // must do this before and after changing the data, in case
                                                                         // a line gets moved due to word wrap
 
-            int index = 0;
-            int nextIndex = 0;
-
-            for (int i = 0; i < sections.size(); ++i)
-            {
-                nextIndex = index + sections.getUnchecked (i)->getTotalLength();
-
-                if (insertIndex == index)
-                {
-                    sections.insert (i, new UniformTextSection (text,
-                                                                font, colour,
-                                                                passwordCharacter));
-                    break;
-                }
-                else if (insertIndex > index && insertIndex < nextIndex)
-                {
-                    splitSection (i, insertIndex - index);
-                    sections.insert (i + 1, new UniformTextSection (text,
-                                                                    font, colour,
-                                                                    passwordCharacter));
-                    break;
-                }
-
-                index = nextIndex;
-            }
+            const int oldTotalNumChars = getTotalNumChars();
+            const int sectionIndex = splitSectionsAt (insertIndex);
 
-            if (nextIndex == insertIndex)
-                sections.add (new UniformTextSection (text,
-                                                      font, colour,
-                                                      passwordCharacter));
+            sections.insert (sectionIndex, new UniformTextSection (text,
+                                                                   font, colour,
+                                                                   passwordCharacter));
+            sectionStarts.insert (sectionIndex, insertIndex);
+            updateSectionStarts (sectionIndex + 1);
 
-            coalesceSimilarSections();
+            const int firstRearrangedChar = coalesceSimilarSections (sectionIndex - 2, sectionIndex + 2);
             totalNumChars = -1;
             valueTextNeedsUpdating = true;
 
+            lineIndex->textChanged (insertIndex, 0, getTotalNumChars() - oldTotalNumChars,
+                                    firstRearrangedChar, getWordWrapWidth(), passwordCharacter);
+
             updateTextHolderSize();
             moveCaretTo (caretPositionToMoveTo, false);
 
@@ -2318,42 +2853,23 @@ void TextEditor::insert (const String& text,
 void TextEditor::reinsert (const int insertIndex,
                            const Array <UniformTextSection*>& sectionsToInsert)
 {
-    int index = 0;
-    int nextIndex = 0;
+    const int oldTotalNumChars = getTotalNumChars();
+    const int sectionIndex = splitSectionsAt (insertIndex);
 
-    for (int i = 0; i < sections.size(); ++i)
+    for (int j = sectionsToInsert.size(); --j >= 0;)
     {
-        nextIndex = index + sections.getUnchecked (i)->getTotalLength();
-
-        if (insertIndex == index)
-        {
-            for (int j = sectionsToInsert.size(); --j >= 0;)
-                sections.insert (i, new UniformTextSection (*sectionsToInsert.getUnchecked(j)));
-
-            break;
-        }
-        else if (insertIndex > index && insertIndex < nextIndex)
-        {
-            splitSection (i, insertIndex - index);
-
-            for (int j = sectionsToInsert.size(); --j >= 0;)
-                sections.insert (i + 1, new UniformTextSection (*sectionsToInsert.getUnchecked(j)));
-
-            break;
-        }
-
-        index = nextIndex;
+        sections.insert (sectionIndex, new UniformTextSection (*sectionsToInsert.getUnchecked(j)));
+        sectionStarts.insert (sectionIndex, insertIndex);
     }
 
-    if (nextIndex == insertIndex)
-    {
-        for (int j = 0; j < sectionsToInsert.size(); ++j)
-            sections.add (new UniformTextSection (*sectionsToInsert.getUnchecked(j)));
-    }
+    updateSectionStarts (sectionIndex + 1);
 
-    coalesceSimilarSections();
+    const int firstRearrangedChar = coalesceSimilarSections (sectionIndex - 2, sectionIndex + sectionsToInsert.size() + 1);
     totalNumChars = -1;
     valueTextNeedsUpdating = true;
+
+    lineIndex->textChanged (insertIndex, 0, getTotalNumChars() - oldTotalNumChars,
+                            firstRearrangedChar, getWordWrapWidth(), passwordCharacter);
 }
 
 void TextEditor::remove (const Range<int>& range,
@@ -2362,51 +2878,15 @@ void TextEditor::remove (const Range<int>& range,
 {
     if (! range.isEmpty())
     {
-        int index = 0;
-
-        for (int i = 0; i < sections.size(); ++i)
-        {
-            const int nextIndex = index + sections.getUnchecked(i)->getTotalLength();
-
-            if (range.getStart() > index && range.getStart() < nextIndex)
-            {
-                splitSection (i, range.getStart() - index);
-                --i;
-            }
-            else if (range.getEnd() > index && range.getEnd() < nextIndex)
-            {
-                splitSection (i, range.getEnd() - index);
-                --i;
-            }
-            else
-            {
-                index = nextIndex;
-
-                if (index > range.getEnd())
-                    break;
-            }
-        }
-
-        index = 0;
+        const int firstSection = splitSectionsAt (range.getStart());
+        const int endSection = splitSectionsAt (range.getEnd());
 
         if (um != nullptr)
         {
             Array <UniformTextSection*> removedSections;
 
-            for (int i = 0; i < sections.size(); ++i)
-            {
-                if (range.getEnd() <= range.getStart())
-                    break;
-
-                UniformTextSection* const section = sections.getUnchecked (i);
-
-                const int nextIndex = index + section->getTotalLength();
-
-                if (range.getStart() <= index && range.getEnd() >= nextIndex)
-                    removedSections.add (new UniformTextSection (*section));
-
-                index = nextIndex;
-            }
+            for (int i = firstSection; i < endSection; ++i)
+                removedSections.add (new UniformTextSection (*sections.getUnchecked (i)));
 
             if (um->getNumActionsInCurrentTransaction() > TextEditorDefs::maxActionsPerTransaction)
                 newTransaction();
@@ -2416,36 +2896,26 @@ void TextEditor::remove (const Range<int>& range,
         }
         else
         {
-            Range<int> remainingRange (range);
+            const int oldTotalNumChars = getTotalNumChars();
 
-            for (int i = 0; i < sections.size(); ++i)
+            for (int i = endSection; --i >= firstSection;)
             {
                 UniformTextSection* const section = sections.getUnchecked (i);
-
-                const int nextIndex = index + section->getTotalLength();
-
-                if (remainingRange.getStart() <= index && remainingRange.getEnd() >= nextIndex)
-                {
-                    sections.remove(i);
-                    section->clear();
-                    delete section;
-
-                    remainingRange.setEnd (remainingRange.getEnd() - (nextIndex - index));
-                    if (remainingRange.isEmpty())
-                        break;
-
-                    --i;
-                }
-                else
-                {
-                    index = nextIndex;
-                }
+                section->clear();
+                delete section;
             }
 
-            coalesceSimilarSections();
+            sections.removeRange (firstSection, endSection - firstSection);
+            sectionStarts.removeRange (firstSection, endSection - firstSection);
+            updateSectionStarts (firstSection);
+
+            const int firstRearrangedChar = coalesceSimilarSections (firstSection - 2, firstSection + 1);
             totalNumChars = -1;
             valueTextNeedsUpdating = true;
 
+            lineIndex->textChanged (range.getStart(), oldTotalNumChars - getTotalNumChars(), 0,
+                                    firstRearrangedChar, getWordWrapWidth(), passwordCharacter);
+
             moveCaretTo (caretPositionToMoveTo, false);
 
             repaintText (Range<int> (range.getStart(), getTotalNumChars()));
@@ -2473,22 +2943,14 @@ String TextEditor::getTextInRange (const Range<int>& range) const
     MemoryOutputStream mo;
     mo.preallocate ((size_t) jmin (getTotalNumChars(), range.getLength()));
 
-    int index = 0;
-
-    for (int i = 0; i < sections.size(); ++i)
+    for (int i = jmax (0, findSectionContaining (range.getStart())); i < sections.size(); ++i)
     {
-        const UniformTextSection* const s = sections.getUnchecked (i);
-        const int nextIndex = index + s->getTotalLength();
-
-        if (range.getStart() < nextIndex)
-        {
-            if (range.getEnd() <= index)
-                break;
+        const int index = sectionStarts.getUnchecked (i);
 
-            s->appendSubstring (mo, range - index);
-        }
+        if (range.getEnd() <= index)
+            break;
 
-        index = nextIndex;
+        sections.getUnchecked (i)->appendSubstring (mo, range - index);
     }
 
     return mo.toString();
@@ -2523,7 +2985,7 @@ void TextEditor::getCharPosition (const int index, float& cx, float& cy, float&
 
     if (wordWrapWidth > 0 && sections.size() > 0)
     {
-        Iterator i (sections, wordWrapWidth, passwordCharacter);
+        Iterator i (lineIndex->getIteratorForIndex (index, wordWrapWidth, passwordCharacter));
 
         i.getCharPosition (index, cx, cy, lineHeight);
     }
@@ -2540,7 +3002,7 @@ int TextEditor::indexAtPosition (const float x, const float y)
 
     if (wordWrapWidth > 0)
     {
-        Iterator i (sections, wordWrapWidth, passwordCharacter);
+        Iterator i (lineIndex->getIteratorForY (y, wordWrapWidth, passwordCharacter));
 
         while (i.next())
         {
@@ -2609,6 +3071,41 @@ int TextEditor::findWordBreakBefore (const int position) const
 
 
 //==============================================================================
+int TextEditor::findSectionContaining (const int index) const noexcept
+{
+    int start = 0, end = sections.size();
+
+    while (start < end)
+    {
+        const int mid = (start + end) / 2;
+
+        if (sectionStarts.getUnchecked (mid) <= index)
+            start = mid + 1;
+        else
+            end = mid;
+    }
+
+    return start - 1;
+}
+
+int TextEditor::splitSectionsAt (const int index)
+{
+    const int i = findSectionContaining (index);
+
+    if (i < 0)
+        return 0;
+
+    const int charToSplitAt = index - sectionStarts.getUnchecked (i);
+
+    if (charToSplitAt == 0)
+        return i;
+
+    if (charToSplitAt < sections.getUnchecked (i)->getTotalLength())
+        splitSection (i, charToSplitAt);
+
+    return i + 1;
+}
+
 void TextEditor::splitSection (const int sectionIndex,
                                const int charToSplitAt)
 {
@@ -2616,24 +3113,75 @@ void TextEditor::splitSection (const int sectionIndex,
 
     sections.insert (sectionIndex + 1,
                      sections.getUnchecked (sectionIndex)->split (charToSplitAt, passwordCharacter));
+    sectionStarts.insert (sectionIndex + 1, sectionStarts.getUnchecked (sectionIndex) + charToSplitAt);
 }
 
-void TextEditor::coalesceSimilarSections()
+void TextEditor::updateSectionStarts (const int firstSection)
 {
-    for (int i = 0; i < sections.size() - 1; ++i)
+    jassert (sectionStarts.size() == sections.size());
+
+    int index = firstSection > 0 ? sectionStarts.getUnchecked (firstSection - 1)
+                                     + sections.getUnchecked (firstSection - 1)->getTotalLength()
+                                 : 0;
+
+    for (int i = jmax (0, firstSection); i < sections.size(); ++i)
+    {
+        sectionStarts.set (i, index);
+        index += sections.getUnchecked (i)->getTotalLength();
+    }
+}
+
+// Only the sections from firstSection to lastSection are merged or split up, because the
+// ones elsewhere were already coalesced after earlier edits. An edit passes in a section beyond
+// each end of the ones it changed, as the piece of a section it split may now fit into those.
+int TextEditor::coalesceSimilarSections (int firstSection, int lastSection)
+{
+    int firstRearrangedChar = std::numeric_limits<int>::max();
+    firstSection = jmax (0, firstSection);
+    lastSection = jmin (lastSection, sections.size() - 1);
+
+    for (int i = firstSection; i < lastSection; ++i)
     {
         UniformTextSection* const s1 = sections.getUnchecked (i);
         UniformTextSection* const s2 = sections.getUnchecked (i + 1);
 
         if (s1->font == s2->font
-             && s1->colour == s2->colour)
+             && s1->colour == s2->colour
+             && (s1->getTotalLength() + s2->getTotalLength() <= TextEditorDefs::maxSectionLength
+                  || ! s1->canBeFollowedBy (*s2)))
         {
+            firstRearrangedChar = jmin (firstRearrangedChar, sectionStarts.getUnchecked (i + 1));
+
             s1->append (*s2, passwordCharacter);
             sections.remove (i + 1);
+            sectionStarts.remove (i + 1);
             delete s2;
+            --lastSection;
             --i;
         }
     }
+
+    // long sections are broken up from the end, into pieces of roughly equal length
+    for (int i = lastSection; i >= firstSection; --i)
+    {
+        UniformTextSection* const s = sections.getUnchecked (i);
+        int length = s->getTotalLength();
+
+        while (length > TextEditorDefs::maxSectionLength)
+        {
+            const int numPieces = (length + TextEditorDefs::maxSectionLength - 1) / TextEditorDefs::maxSectionLength;
+            const int splitPoint = s->findSplitPoint (length - length / numPieces, TextEditorDefs::maxSectionLength / 2);
+
+            if (splitPoint <= 0)
+                break;
+
+            splitSection (i, splitPoint);
+            firstRearrangedChar = jmin (firstRearrangedChar, sectionStarts.getUnchecked (i) + splitPoint);
+            length = splitPoint;
+        }
+    }
+
+    return firstRearrangedChar;
 }
 
 void TextEditor::Listener::textEditorTextChanged (TextEditor&) {}
@@ -622,6 +622,7 @@ protected:
 private:
     //==============================================================================
     class Iterator;
+    class LineIndex;
     class UniformTextSection;
     class TextHolderComponent;
     class InsertAction;
@@ -656,6 +657,8 @@ private:
     mutable int totalNumChars;
     int caretPosition;
     Array <UniformTextSection*> sections;
+    Array <int> sectionStarts;
+    ScopedPointer <LineIndex> lineIndex;
     String textToShowWhenEmpty;
     Colour colourForTextWhenEmpty;
     juce_wchar passwordCharacter;
@@ -672,8 +675,11 @@ private:
     ListenerList <Listener> listeners;
     Array <Range<int> > underlinedSections;
 
-    void coalesceSimilarSections();
+    int coalesceSimilarSections (int firstSection, int lastSection);
+    int findSectionContaining (int index) const noexcept;
+    int splitSectionsAt (int index);
     void splitSection (int sectionIndex, int charToSplitAt);
+    void updateSectionStarts (int firstSection);
     void clearInternal (UndoManager* um);
     void insert (const String& text, int insertIndex, const Font& font,
                  const Colour& colour, UndoManager* um, int caretPositionToMoveTo);
@@ -1439,14 +1439,15 @@ public:
     {
         if (clip != nullptr)
         {
+            typedef RenderingHelpers::GlyphCache <CachedGlyphEdgeTable, SavedState> GlyphCacheType;
+
             if (transform.isOnlyTranslated && t.isOnlyTranslation())
             {
-                RenderingHelpers::GlyphCache <CachedGlyphEdgeTable, SavedState>::getInstance()
-                    .drawGlyph (*this, font, glyphNumber,
-                                transform.xOffset + t.getTranslationX(),
-                                transform.yOffset + t.getTranslationY());
+                GlyphCacheType::getInstance().drawGlyph (*this, font, glyphNumber,
+                                                         transform.xOffset + t.getTranslationX(),
+                                                         transform.yOffset + t.getTranslationY());
             }
-            else
+            else if (! GlyphCacheType::getInstance().drawTransformedGlyph (*this, font, glyphNumber, transform.getTransformWith (t)))
             {
                 const float fontHeight = font.getHeight();
 
@@ -1551,38 +1552,33 @@ private:
         clip->fillEdgeTable (target, et, getFillType(), gradientTexture);
     }
 
-    class CachedGlyphEdgeTable
+    class CachedGlyphEdgeTable  : public ReferenceCountedObject
     {
     public:
-        CachedGlyphEdgeTable() : glyph (0), lastAccessCount (0) {}
+        CachedGlyphEdgeTable() {}
 
-        void draw (OpenGLRenderer::SavedState& state, float x, const float y) const
+        void draw (OpenGLRenderer::SavedState& state, const int x, const int y) const
         {
-            if (snapToIntegerCoordinate)
-                x = std::floor (x + 0.5f);
-
             if (edgeTable != nullptr)
-                state.fillEdgeTable (*edgeTable, x, roundToInt (y));
+                state.fillEdgeTable (*edgeTable, (float) x, y);
         }
 
-        void generate (const Font& newFont, const int glyphNumber)
+        void generate (const Font& font, const int glyphNumber, const AffineTransform& transform)
         {
-            font = newFont;
-            snapToIntegerCoordinate = newFont.getTypeface()->isHinted();
-            glyph = glyphNumber;
-
             const float fontHeight = font.getHeight();
             edgeTable = font.getTypeface()->getEdgeTableForGlyph (glyphNumber,
                                                                   AffineTransform::scale (fontHeight * font.getHorizontalScale(), fontHeight)
+                                                                                  .followedBy (transform)
                                                                                 #if JUCE_MAC || JUCE_IOS
                                                                                   .translated (0.0f, -0.5f)
                                                                                 #endif
                                                                   );
         }
 
-        Font font;
-        int glyph, lastAccessCount;
-        bool snapToIntegerCoordinate;
+        size_t getMemorySize() const noexcept
+        {
+            return sizeof (*this) + (edgeTable != nullptr ? edgeTable->getAllocatedSize() : 0);
+        }
 
     private:
         ScopedPointer <EdgeTable> edgeTable;